@@ -0,0 +1,1104 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+/* musikcube-bench: generates a synthetic library (and optionally a set of
+synthetic audio fixtures), times the library, indexer and audio hot paths,
+and writes the results as json. everything is deterministic for a given
+set of arguments, so results can be compared across builds. */
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <core/audio/Buffer.h>
+#include <core/audio/Streams.h>
+#include <core/db/Connection.h>
+#include <core/db/Statement.h>
+#include <core/db/ScopedTransaction.h>
+#include <core/io/DataStreamFactory.h>
+#include <core/library/Indexer.h>
+#include <core/library/LocalLibrary.h>
+#include <core/library/query/local/CategoryListQuery.h>
+#include <core/library/query/local/SearchTrackListQuery.h>
+#include <core/library/track/LibraryTrack.h>
+#include <core/plugin/PluginFactory.h>
+#include <core/runtime/Message.h>
+#include <core/runtime/MessageQueue.h>
+#include <core/sdk/ITagReader.h>
+#include <core/support/Common.h>
+
+#include <boost/filesystem.hpp>
+
+#ifndef WIN32
+#include <microhttpd.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <json.hpp>
+
+#include "../core/version.h"
+#include "../plugins/server/Constants.h"
+#include "../plugins/server/MessageEncoding.h"
+
+using namespace musik::core;
+using namespace musik::core::audio;
+using namespace musik::core::db;
+using namespace musik::core::db::local;
+using namespace musik::core::library;
+using namespace musik::core::runtime;
+using namespace musik::core::sdk;
+
+using Clock = std::chrono::steady_clock;
+using nlohmann::json;
+
+#define TRACK_PAGE_SIZE 50
+#define FIXTURE_SAMPLE_RATE 44100
+#define FIXTURE_CHANNELS 2
+#define FIXTURE_BITRATE 192
+#define SAMPLES_PER_BUFFER 2048
+#define HTTP_FILE_BYTES (32 * 1024 * 1024)
+#define HTTP_RANGE_BYTES (256 * 1024)
+#define HTTP_BASE_PORT 17906
+
+struct Options {
+    int tracks{ 10000 };
+    int artists{ 500 };
+    int albums{ 1000 };
+    int genres{ 25 };
+    double skew{ 1.0 }; /* zipf exponent; 0 = uniform */
+    int iterations{ 5 };
+    int fixtures{ 20 };
+    int fixtureSeconds{ 30 };
+    int queueThreads{ 4 };
+    int queueMessages{ 100000 };
+    int httpClients{ 8 };
+    int httpRequests{ 400 };
+    unsigned seed{ 1 };
+    std::string workDir;
+    std::string output;
+};
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/* runs fn() the specified number of times and reports min/avg/max */
+template <typename T>
+static json timeIterations(int iterations, T fn) {
+    double total = 0.0, min = 0.0, max = 0.0;
+
+    for (int i = 0; i < iterations; i++) {
+        auto start = Clock::now();
+        fn();
+        double elapsed = millisSince(start);
+        total += elapsed;
+        min = (i == 0) ? elapsed : std::min(min, elapsed);
+        max = std::max(max, elapsed);
+    }
+
+    return {
+        { "iterations", iterations },
+        { "min_ms", min },
+        { "avg_ms", iterations ? total / iterations : 0.0 },
+        { "max_ms", max }
+    };
+}
+
+/* zipf-ish distribution over [0, count), so a few artists/albums/genres
+own most of the tracks, like a real library. */
+class SkewedDistribution {
+    public:
+        SkewedDistribution(int count, double skew) {
+            double sum = 0.0;
+            for (int i = 0; i < count; i++) {
+                sum += 1.0 / std::pow((double) (i + 1), skew);
+                this->cdf.push_back(sum);
+            }
+            for (double& d : this->cdf) {
+                d /= sum;
+            }
+        }
+
+        int operator()(std::mt19937& rng) {
+            double r = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            auto it = std::lower_bound(this->cdf.begin(), this->cdf.end(), r);
+            return (int) std::min((size_t) (it - this->cdf.begin()), this->cdf.size() - 1);
+        }
+
+    private:
+        std::vector<double> cdf;
+};
+
+static int64_t insertName(Connection& db, const char* table, const std::string& name, int order) {
+    std::string sql = std::string("INSERT INTO ") + table + " (name, sort_order) VALUES (?, ?)";
+    Statement stmt(sql.c_str(), db);
+    stmt.BindText(0, name);
+    stmt.BindInt32(1, order);
+    stmt.Step();
+    return db.LastInsertedId();
+}
+
+static json populateSyntheticLibrary(Connection& db, const Options& options) {
+    auto start = Clock::now();
+
+    std::mt19937 rng(options.seed);
+    SkewedDistribution artistDist(options.artists, options.skew);
+    SkewedDistribution albumDist(options.albums, options.skew);
+    SkewedDistribution genreDist(options.genres, options.skew);
+
+    std::vector<int64_t> artistIds, albumIds, genreIds;
+
+    {
+        ScopedTransaction transaction(db);
+
+        for (int i = 0; i < options.artists; i++) {
+            artistIds.push_back(insertName(db, "artists", "artist " + std::to_string(i), i));
+        }
+
+        for (int i = 0; i < options.albums; i++) {
+            albumIds.push_back(insertName(db, "albums", "album " + std::to_string(i), i));
+        }
+
+        for (int i = 0; i < options.genres; i++) {
+            genreIds.push_back(insertName(db, "genres", "genre " + std::to_string(i), i));
+        }
+
+        Statement insertTrack(
+            "INSERT INTO tracks "
+            "(track, disc, duration, filesize, title, filename, filetime, visual_genre_id, "
+            " visual_artist_id, album_artist_id, album_id, directory_id, external_id) "
+            "VALUES (?, '1', ?, ?, ?, ?, 0, ?, ?, ?, ?, 0, ?)",
+            db);
+
+        Statement insertTrackArtist("INSERT INTO track_artists (track_id, artist_id) VALUES (?, ?)", db);
+        Statement insertTrackGenre("INSERT INTO track_genres (track_id, genre_id) VALUES (?, ?)", db);
+
+        for (int i = 0; i < options.tracks; i++) {
+            int64_t artistId = artistIds[artistDist(rng)];
+            int64_t albumId = albumIds[albumDist(rng)];
+            int64_t genreId = genreIds[genreDist(rng)];
+            std::string title = "track " + std::to_string(i);
+
+            insertTrack.Reset();
+            insertTrack.BindInt32(0, (i % 20) + 1);
+            insertTrack.BindInt32(1, 120 + (int) (rng() % 300));
+            insertTrack.BindInt64(2, 3000000 + (int64_t) (rng() % 7000000));
+            insertTrack.BindText(3, title);
+            insertTrack.BindText(4, "/bench/" + std::to_string(albumId) + "/" + title + ".mp3");
+            insertTrack.BindInt64(5, genreId);
+            insertTrack.BindInt64(6, artistId);
+            insertTrack.BindInt64(7, artistId);
+            insertTrack.BindInt64(8, albumId);
+            insertTrack.BindText(9, "bench-" + std::to_string(i));
+            insertTrack.Step();
+
+            int64_t trackId = db.LastInsertedId();
+
+            insertTrackArtist.Reset();
+            insertTrackArtist.BindInt64(0, trackId);
+            insertTrackArtist.BindInt64(1, artistId);
+            insertTrackArtist.Step();
+
+            insertTrackGenre.Reset();
+            insertTrackGenre.BindInt64(0, trackId);
+            insertTrackGenre.BindInt64(1, genreId);
+            insertTrackGenre.Step();
+        }
+    }
+
+    LocalLibrary::CreateIndexes(db);
+
+    return {
+        { "tracks", options.tracks },
+        { "artists", options.artists },
+        { "albums", options.albums },
+        { "genres", options.genres },
+        { "skew", options.skew },
+        { "populate_ms", millisSince(start) }
+    };
+}
+
+static json benchmarkLibraryQueries(Connection& db, const Options& options) {
+    json result;
+
+    for (auto field : { "artist", "album", "genre" }) {
+        size_t count = 0;
+        result["category_list_query"][field] = timeIterations(options.iterations, [&]() {
+            auto query = std::make_shared<CategoryListQuery>(field);
+            query->Run(db);
+            count = query->GetResult() ? query->GetResult()->Count() : 0;
+        });
+        result["category_list_query"][field]["results"] = count;
+    }
+
+    for (auto filter : { "track 1", "album 9", "artist", "zzz" }) {
+        size_t count = 0;
+        result["search_track_list_query"][filter] = timeIterations(options.iterations, [&]() {
+            auto query = std::make_shared<SearchTrackListQuery>(ILibraryPtr(), filter);
+            query->Run(db);
+            count = query->GetResult() ? query->GetResult()->Count() : 0;
+        });
+        result["search_track_list_query"][filter]["results"] = count;
+    }
+
+    /* TrackList::Get() hydrates tracks a page at a time through
+    LibraryTrack::Load(); time the same thing against the database
+    directly, for the first few pages. */
+    std::vector<int64_t> ids;
+    {
+        Statement stmt("SELECT id FROM tracks ORDER BY id LIMIT ?", db);
+        stmt.BindInt32(0, TRACK_PAGE_SIZE * 10);
+        while (stmt.Step() == Row) {
+            ids.push_back(stmt.ColumnInt64(0));
+        }
+    }
+
+    result["track_page_load"] = timeIterations(options.iterations, [&]() {
+        for (size_t page = 0; page < ids.size(); page += TRACK_PAGE_SIZE) {
+            size_t end = std::min(page + TRACK_PAGE_SIZE, ids.size());
+            for (size_t i = page; i < end; i++) {
+                LibraryTrack track(ids[i], 0);
+                LibraryTrack::Load(&track, db);
+            }
+        }
+    });
+    result["track_page_load"]["page_size"] = TRACK_PAGE_SIZE;
+    result["track_page_load"]["tracks"] = ids.size();
+
+    /* LibraryTrack keeps well-known fields in typed slots, with album,
+    artist and genre strings interned. hold a few pages resident (like the
+    TrackList cache does) and time field reads against them, then make sure
+    the interned strings are released along with the tracks. */
+    std::vector<TrackPtr> resident;
+    for (int64_t id : ids) {
+        auto track = std::make_shared<LibraryTrack>(id, 0);
+        LibraryTrack::Load(track.get(), db);
+        resident.push_back(track);
+    }
+
+    size_t bytes = 0;
+    result["track_field_access"] = timeIterations(options.iterations, [&]() {
+        bytes = 0;
+        for (auto& track : resident) {
+            for (auto key : { "title", "album", "artist", "genre", "track", "disc", "duration" }) {
+                bytes += track->GetString(key).size();
+            }
+            bytes += (size_t) track->GetInt64("album_id");
+        }
+    });
+    result["track_field_access"]["tracks"] = resident.size();
+    result["track_field_access"]["interned_strings"] = LibraryTrack::InternedStringCount();
+    resident.clear();
+    result["track_field_access"]["interned_strings_after_release"] = LibraryTrack::InternedStringCount();
+
+    return result;
+}
+
+/* builds query_tracks-style responses, a page at a time, and reports how many
+bytes each track costs on the wire as json text, as msgpack with the same
+shape, and as msgpack with positional track records and compacted keys (what
+the server sends to clients that negotiate the binary encoding). */
+static json benchmarkWireEncoding(Connection& db, const Options& options) {
+    std::vector<int64_t> ids;
+    {
+        Statement stmt("SELECT id FROM tracks ORDER BY id LIMIT ?", db);
+        stmt.BindInt32(0, TRACK_PAGE_SIZE * 10);
+        while (stmt.Step() == Row) {
+            ids.push_back(stmt.ColumnInt64(0));
+        }
+    }
+
+    auto envelope = [](int page, json& data, size_t count) {
+        return json({
+            { message::name, "query_tracks" },
+            { message::type, "response" },
+            { message::id, "bench-" + std::to_string(page) },
+            { message::options, {
+                { key::data, data },
+                { key::count, count },
+                { key::limit, TRACK_PAGE_SIZE },
+                { key::offset, page * TRACK_PAGE_SIZE }
+            }}
+        });
+    };
+
+    size_t textBytes = 0, msgpackBytes = 0, compactBytes = 0;
+
+    for (size_t page = 0; page < ids.size(); page += TRACK_PAGE_SIZE) {
+        size_t end = std::min(page + TRACK_PAGE_SIZE, ids.size());
+        json objects = json::array(), arrays = json::array();
+
+        for (size_t i = page; i < end; i++) {
+            LibraryTrack track(ids[i], 0);
+            LibraryTrack::Load(&track, db);
+
+            json fields = json::array({
+                track.GetId(),
+                track.GetString(key::external_id.c_str()),
+                track.GetString(key::title.c_str()),
+                track.GetInt32(key::track_num.c_str(), 0),
+                track.GetString(key::album.c_str()),
+                track.GetInt64(key::album_id.c_str()),
+                track.GetString(key::album_artist.c_str()),
+                track.GetInt64(key::album_artist_id.c_str()),
+                track.GetString(key::artist.c_str()),
+                track.GetInt64(key::visual_artist_id.c_str()),
+                track.GetString(key::genre.c_str()),
+                track.GetInt64(key::visual_genre_id.c_str()),
+                track.GetInt64(key::thumbnail_id.c_str())
+            });
+
+            json object = json::object();
+            for (size_t f = 0; f < TRACK_FIELDS.size(); f++) {
+                object[TRACK_FIELDS[f]] = fields[f];
+            }
+
+            objects.push_back(object);
+            arrays.push_back(fields);
+        }
+
+        int index = (int) (page / TRACK_PAGE_SIZE);
+        json plain = envelope(index, objects, ids.size());
+        textBytes += plain.dump().size();
+        msgpackBytes += json::to_msgpack(plain).size();
+        compactBytes += json::to_msgpack(CompactMessage(envelope(index, arrays, ids.size()))).size();
+    }
+
+    auto perTrack = [&ids](size_t bytes) {
+        return ids.size() ? (double) bytes / (double) ids.size() : 0.0;
+    };
+
+    return {
+        { "tracks", ids.size() },
+        { "page_size", TRACK_PAGE_SIZE },
+        { "json_bytes_per_track", perTrack(textBytes) },
+        { "msgpack_bytes_per_track", perTrack(msgpackBytes) },
+        { "compact_msgpack_bytes_per_track", perTrack(compactBytes) }
+    };
+}
+
+/* writes a stereo sweep through the specified encoder. the stock encoders
+don't write tags, so fixture metadata comes from filenames only. */
+static bool writeFixture(const std::string& filename, const std::string& type, int seconds, int index) {
+    IEncoder* encoder = streams::GetEncoderForType(type.c_str());
+    if (!encoder) {
+        return false;
+    }
+
+    FILE* out = fopen(filename.c_str(), "wb");
+    if (!out) {
+        encoder->Release();
+        return false;
+    }
+
+    encoder->Initialize(FIXTURE_SAMPLE_RATE, FIXTURE_CHANNELS, FIXTURE_BITRATE);
+
+    Buffer pcm;
+    pcm.SetSampleRate(FIXTURE_SAMPLE_RATE);
+    pcm.SetChannels(FIXTURE_CHANNELS);
+    pcm.SetSamples(SAMPLES_PER_BUFFER * FIXTURE_CHANNELS);
+
+    const double frequency = 220.0 + 20.0 * index;
+    const long totalFrames = (long) seconds * FIXTURE_SAMPLE_RATE;
+    char* data = nullptr;
+    int length;
+
+    for (long frame = 0; frame < totalFrames; frame += SAMPLES_PER_BUFFER) {
+        float* samples = pcm.BufferPointer();
+        for (int i = 0; i < SAMPLES_PER_BUFFER; i++) {
+            double t = (double) (frame + i) / FIXTURE_SAMPLE_RATE;
+            float value = (float) (0.25 * std::sin(2.0 * M_PI * frequency * t * (1.0 + t / seconds)));
+            samples[i * 2] = samples[i * 2 + 1] = value;
+        }
+
+        if ((length = encoder->Encode(&pcm, &data)) > 0) {
+            fwrite(data, 1, length, out);
+        }
+    }
+
+    if ((length = encoder->Flush(&data)) > 0) {
+        fwrite(data, 1, length, out);
+    }
+
+    fclose(out);
+    encoder->Finalize(filename.c_str());
+    encoder->Release();
+    return true;
+}
+
+static json generateFixtures(const std::string& dir, const Options& options, std::vector<std::string>& files) {
+    json result;
+    boost::filesystem::create_directories(dir);
+
+    for (std::string type : { ".mp3", ".ogg" }) {
+        auto start = Clock::now();
+        int written = 0;
+
+        for (int i = 0; i < options.fixtures; i++) {
+            std::string fn = dir + "/fixture-" + std::to_string(i) + type;
+            if (writeFixture(fn, type, options.fixtureSeconds, i)) {
+                files.push_back(fn);
+                ++written;
+            }
+        }
+
+        result[type.substr(1)] = {
+            { "files", written },
+            { "seconds_each", options.fixtureSeconds },
+            { "encode_ms", millisSince(start) }
+        };
+    }
+
+    return result;
+}
+
+static json benchmarkIndexer(const std::string& workDir, const std::string& fixtureDir) {
+    std::string libraryDir = workDir + "/indexer/";
+    std::string dbFilename = libraryDir + "musik.db";
+
+    boost::filesystem::create_directories(libraryDir);
+
+    {
+        Connection db;
+        db.Open(dbFilename.c_str());
+        LocalLibrary::CreateDatabase(db);
+    }
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    int syncs = 0;
+
+    class Listener : public sigslot::has_slots<> {
+        public:
+            std::function<void(int)> callback;
+            void OnFinished(int count) { callback(count); }
+    } listener;
+
+    listener.callback = [&](int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++syncs;
+        finished.notify_all();
+    };
+
+    Indexer indexer(libraryDir, dbFilename);
+    indexer.Finished.connect(&listener, &Listener::OnFinished);
+    indexer.AddPath(fixtureDir);
+
+    auto sync = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        int target = syncs + 1;
+        auto start = Clock::now();
+        indexer.Schedule(IIndexer::SyncType::Local);
+        finished.wait(lock, [&]() { return syncs >= target; });
+        return millisSince(start);
+    };
+
+    json result;
+    double initialMillis = sync();
+    result["initial_index_ms"] = initialMillis;
+    result["noop_rescan_ms"] = sync();
+
+    Connection db;
+    db.Open(dbFilename.c_str());
+    Statement count("SELECT COUNT(*) FROM tracks", db);
+    int64_t indexed = (count.Step() == Row) ? count.ColumnInt64(0) : 0;
+    result["tracks_indexed"] = indexed;
+
+    /* dominated by tag reading; compare across builds to see the effect of
+    changes to the metadata reader plugins. */
+    result["files_per_second"] = (initialMillis > 0.0)
+        ? (double) indexed * 1000.0 / initialMillis : 0.0;
+
+    return result;
+}
+
+/* runs every tag reader plugin over the fixtures in isolation (no database
+writes), so changes to the readers themselves can be measured. */
+static json benchmarkTagReaders(const std::vector<std::string>& files, const Options& options) {
+    using TagReaderDeleter = PluginFactory::ReleaseDeleter<ITagReader>;
+
+    class NullTagStore : public ITagStore {
+        public:
+            size_t values{ 0 };
+            virtual void Retain() { }
+            virtual void Release() { }
+            virtual void SetValue(const char* key, const char* value) { ++values; }
+            virtual void ClearValue(const char* key) { }
+            virtual bool Contains(const char* key) { return false; }
+            virtual void SetThumbnail(const char *data, long size) { }
+            virtual void SetReplayGain(const ReplayGain& replayGain) { }
+    };
+
+    auto readers = PluginFactory::Instance()
+        .QueryInterface<ITagReader, TagReaderDeleter>("GetTagReader");
+
+    std::map<std::string, json> results;
+
+    for (auto& reader : readers) {
+        for (auto& fn : files) {
+            std::string type = boost::filesystem::path(fn).extension().string();
+            type = type.size() ? type.substr(1) : type;
+
+            if (!reader->CanRead(type.c_str())) {
+                continue;
+            }
+
+            NullTagStore store;
+            int succeeded = 0;
+            auto start = Clock::now();
+
+            for (int i = 0; i < options.iterations; i++) {
+                if (reader->Read(fn.c_str(), &store)) {
+                    ++succeeded;
+                }
+            }
+
+            double elapsed = millisSince(start);
+
+            json& entry = results[type];
+            entry["reads"] = entry.value("reads", 0) + options.iterations;
+            entry["succeeded"] = entry.value("succeeded", 0) + succeeded;
+            entry["values"] = entry.value("values", (uint64_t) 0) + (uint64_t) store.values;
+            entry["elapsed_ms"] = entry.value("elapsed_ms", 0.0) + elapsed;
+        }
+    }
+
+    json result = json::object();
+    for (auto& kv : results) {
+        json entry = kv.second;
+        double seconds = entry["elapsed_ms"].get<double>() / 1000.0;
+        if (seconds > 0.0) {
+            entry["files_per_second"] = entry["reads"].get<double>() / seconds;
+        }
+        result[kv.first] = entry;
+    }
+
+    return result;
+}
+
+/* decodes every fixture of each type, and reports pcm throughput. if
+transcode is true, the pcm is also fed through the mp3 encoder, which is
+the same pipeline the server's TranscodingDataStream runs. */
+static json benchmarkDecode(const std::vector<std::string>& files, bool transcode) {
+    std::map<std::string, json> results;
+
+    for (auto& fn : files) {
+        std::string type = boost::filesystem::path(fn).extension().string();
+        auto stream = io::DataStreamFactory::OpenSharedDataStream(fn.c_str());
+        if (!stream) {
+            continue;
+        }
+
+        auto decoder = streams::GetDecoderForDataStream(stream, DecodeIntent::Sequential);
+        if (!decoder) {
+            continue;
+        }
+
+        IEncoder* encoder = nullptr;
+        if (transcode) {
+            encoder = streams::GetEncoderForType(".mp3");
+            if (!encoder) {
+                continue;
+            }
+        }
+
+        Buffer pcm;
+        uint64_t bytes = 0;
+        double audioSeconds = 0.0;
+        bool initialized = false;
+        char* data = nullptr;
+
+        auto start = Clock::now();
+
+        while (decoder->GetBuffer(&pcm)) {
+            bytes += (uint64_t) pcm.Bytes();
+            audioSeconds += (double) pcm.Samples() / (double) (pcm.Channels() * pcm.SampleRate());
+
+            if (encoder) {
+                if (!initialized) {
+                    encoder->Initialize(pcm.SampleRate(), pcm.Channels(), FIXTURE_BITRATE);
+                    initialized = true;
+                }
+                encoder->Encode(&pcm, &data);
+            }
+        }
+
+        if (encoder) {
+            encoder->Flush(&data);
+            encoder->Release();
+        }
+
+        double elapsed = millisSince(start);
+
+        json& entry = results[type.size() ? type.substr(1) : type];
+        entry["files"] = entry.value("files", 0) + 1;
+        entry["pcm_bytes"] = entry.value("pcm_bytes", (uint64_t) 0) + bytes;
+        entry["audio_seconds"] = entry.value("audio_seconds", 0.0) + audioSeconds;
+        entry["elapsed_ms"] = entry.value("elapsed_ms", 0.0) + elapsed;
+    }
+
+    json result = json::object();
+    for (auto& kv : results) {
+        json entry = kv.second;
+        double seconds = entry["elapsed_ms"].get<double>() / 1000.0;
+        if (seconds > 0.0) {
+            entry["mb_per_second"] = (entry["pcm_bytes"].get<double>() / (1024.0 * 1024.0)) / seconds;
+            entry["realtime_factor"] = entry["audio_seconds"].get<double>() / seconds;
+        }
+        result[kv.first] = entry;
+    }
+
+    return result;
+}
+
+#ifndef WIN32
+
+/* serves one file, the same two ways HttpServer::HandleAudioTrackRequest
+can: straight from a descriptor, or copied through an IDataStream */
+struct HttpFile {
+    std::string filename;
+    uint64_t size;
+    bool useFd;
+};
+
+struct HttpStreamRange {
+    io::DataStreamFactory::DataStreamPtr stream;
+    uint64_t from;
+};
+
+static ssize_t httpStreamRead(void* cls, uint64_t pos, char* buf, size_t max) {
+    auto range = static_cast<HttpStreamRange*>(cls);
+    if (!range->stream->SetPosition((PositionType) (range->from + pos))) {
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+    PositionType read = range->stream->Read(buf, (PositionType) max);
+    return (read > 0) ? (ssize_t) read : MHD_CONTENT_READER_END_OF_STREAM;
+}
+
+static void httpStreamFree(void* cls) {
+    delete static_cast<HttpStreamRange*>(cls);
+}
+
+static int httpHandleRequest(
+    void* cls, MHD_Connection* connection, const char* url, const char* method,
+    const char* version, const char* uploadData, size_t* uploadSize, void** state)
+{
+    auto file = static_cast<HttpFile*>(cls);
+
+    uint64_t from = 0, to = file->size - 1;
+    const char* rangeHeader = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Range");
+    if (rangeHeader) {
+        unsigned long long a = 0, b = 0;
+        if (sscanf(rangeHeader, "bytes=%llu-%llu", &a, &b) == 2 && a <= b && b < file->size) {
+            from = a;
+            to = b;
+        }
+    }
+
+    uint64_t length = to - from + 1;
+    MHD_Response* response = nullptr;
+
+    if (file->useFd) {
+        int fd = open(file->filename.c_str(), O_RDONLY);
+        if (fd != -1) {
+            response = MHD_create_response_from_fd_at_offset64(length, fd, from);
+            if (!response) {
+                close(fd);
+            }
+        }
+    }
+    else {
+        auto range = new HttpStreamRange();
+        range->stream = io::DataStreamFactory::OpenSharedDataStream(file->filename.c_str());
+        range->from = from;
+        if (range->stream) {
+            response = MHD_create_response_from_callback(
+                length, 4096, &httpStreamRead, range, &httpStreamFree);
+        }
+        if (!response) {
+            delete range;
+        }
+    }
+
+    if (!response) {
+        return MHD_NO;
+    }
+
+    int result = MHD_queue_response(
+        connection, rangeHeader ? MHD_HTTP_PARTIAL_CONTENT : MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return result;
+}
+
+/* one GET with a Range header, on its own connection; returns bytes read */
+static size_t httpGetRange(int port, uint64_t from, uint64_t to) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == -1) {
+        return 0;
+    }
+
+    sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    size_t total = 0;
+    if (connect(sock, (sockaddr*) &address, sizeof(address)) == 0) {
+        std::string request =
+            "GET /file HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Range: bytes=" + std::to_string(from) + "-" + std::to_string(to) + "\r\n"
+            "Connection: close\r\n\r\n";
+
+        if (send(sock, request.c_str(), request.size(), 0) == (ssize_t) request.size()) {
+            char buffer[64 * 1024];
+            ssize_t read;
+            while ((read = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+                total += (size_t) read;
+            }
+        }
+    }
+
+    close(sock);
+    return total;
+}
+
+/* N clients issue random range requests against a local file, served once
+via descriptors (sendfile) and once through the IDataStream callback path */
+static json benchmarkHttpRanges(const std::string& workDir, const Options& options) {
+    json result;
+
+    std::string filename = workDir + "/http-range.bin";
+    {
+        std::mt19937 rng(options.seed);
+        std::vector<char> block(1024 * 1024);
+        std::ofstream out(filename, std::ios::binary);
+        for (int i = 0; i < HTTP_FILE_BYTES / (int) block.size(); i++) {
+            for (auto& c : block) {
+                c = (char) (rng() & 0xff);
+            }
+            out.write(block.data(), block.size());
+        }
+    }
+
+    const int clients = std::max(1, options.httpClients);
+    const int perClient = std::max(1, options.httpRequests / clients);
+
+    for (bool useFd : { true, false }) {
+        HttpFile file = { filename, (uint64_t) HTTP_FILE_BYTES, useFd };
+
+        MHD_Daemon* daemon = nullptr;
+        int port = HTTP_BASE_PORT;
+        for (; !daemon && port < HTTP_BASE_PORT + 10; port++) {
+            daemon = MHD_start_daemon(
+#if MHD_VERSION >= 0x00095300
+                MHD_USE_AUTO | MHD_USE_INTERNAL_POLLING_THREAD,
+#else
+                MHD_USE_SELECT_INTERNALLY,
+#endif
+                (uint16_t) port, nullptr, nullptr,
+                (MHD_AccessHandlerCallback) &httpHandleRequest, &file,
+                MHD_OPTION_THREAD_POOL_SIZE, (unsigned) std::max(1u, std::thread::hardware_concurrency()),
+                MHD_OPTION_CONNECTION_LIMIT, (unsigned) (clients * 2),
+                MHD_OPTION_END);
+        }
+
+        const std::string mode = useFd ? "fd" : "stream";
+
+        if (!daemon) {
+            result[mode] = { { "error", "failed to start httpd" } };
+            continue;
+        }
+
+        --port;
+
+        std::atomic<uint64_t> bytes(0);
+        std::vector<std::thread> threads;
+        auto start = Clock::now();
+
+        for (int i = 0; i < clients; i++) {
+            threads.push_back(std::thread([&, i]() {
+                std::mt19937 rng(options.seed + i);
+                std::uniform_int_distribution<uint64_t> offsets(0, HTTP_FILE_BYTES - HTTP_RANGE_BYTES);
+                for (int r = 0; r < perClient; r++) {
+                    uint64_t from = offsets(rng);
+                    bytes += httpGetRange(port, from, from + HTTP_RANGE_BYTES - 1);
+                }
+            }));
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double elapsed = millisSince(start);
+        MHD_stop_daemon(daemon);
+
+        double seconds = elapsed / 1000.0;
+        result[mode] = {
+            { "clients", clients },
+            { "requests", clients * perClient },
+            { "range_bytes", HTTP_RANGE_BYTES },
+            { "bytes_received", bytes.load() },
+            { "elapsed_ms", elapsed },
+            { "requests_per_second", seconds > 0.0 ? (clients * perClient) / seconds : 0.0 },
+            { "mb_per_second", seconds > 0.0 ? (bytes.load() / (1024.0 * 1024.0)) / seconds : 0.0 }
+        };
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(filename, ec);
+
+    return result;
+}
+
+#endif
+
+/* producers post (and debounce) a mix of immediate and delayed messages,
+the way PlaybackService, Crossfader and the ui do, while a single thread
+dispatches them. */
+static json benchmarkMessageQueue(const Options& options) {
+    class Target : public IMessageTarget {
+        public:
+            std::atomic<int> received{ 0 };
+            virtual void ProcessMessage(IMessage& message) override {
+                ++received;
+            }
+    };
+
+    const int threads = std::max(1, options.queueThreads);
+    const int perThread = std::max(1, options.queueMessages / threads);
+
+    MessageQueue queue;
+    std::vector<std::unique_ptr<Target>> targets;
+    for (int i = 0; i < threads; i++) {
+        targets.push_back(std::unique_ptr<Target>(new Target()));
+    }
+
+    std::atomic<bool> producing{ true };
+    std::atomic<int> debounced{ 0 };
+
+    std::thread dispatcher([&]() {
+        while (producing.load() ||
+            std::any_of(targets.begin(), targets.end(), [&](const std::unique_ptr<Target>& t) {
+                return queue.Contains(t.get());
+            }))
+        {
+            queue.WaitAndDispatch(5);
+        }
+    });
+
+    auto start = Clock::now();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < threads; i++) {
+        producers.push_back(std::thread([&, i]() {
+            std::mt19937 rng(options.seed + i);
+            Target* target = targets[i].get();
+            for (int j = 0; j < perThread; j++) {
+                int type = (int) (rng() % 8);
+                int64_t delay = (type == 0) ? (int64_t) (rng() % 50) : 0;
+                if (type == 1) {
+                    queue.Debounce(Message::Create(target, type, j), 10);
+                    ++debounced;
+                }
+                else {
+                    queue.Post(Message::Create(target, type, j), delay);
+                }
+            }
+        }));
+    }
+
+    for (auto& t : producers) {
+        t.join();
+    }
+
+    double postMs = millisSince(start);
+    producing.store(false);
+    dispatcher.join();
+    double totalMs = millisSince(start);
+
+    int received = 0;
+    for (auto& t : targets) {
+        received += t->received.load();
+    }
+
+    const int posted = threads * perThread;
+
+    return {
+        { "threads", threads },
+        { "posted", posted },
+        { "debounced", debounced.load() },
+        { "delivered", received },
+        { "post_ms", postMs },
+        { "drain_ms", totalMs },
+        { "posts_per_second", postMs > 0.0 ? posted / (postMs / 1000.0) : 0.0 }
+    };
+}
+
+static void printHelp() {
+    std::cout << "\n  musikcube-bench:\n";
+    std::cout << "    --tracks <n>: number of synthetic tracks (default 10000)\n";
+    std::cout << "    --artists <n>, --albums <n>, --genres <n>: distinct values\n";
+    std::cout << "    --skew <f>: zipf exponent for tag distributions, 0 is uniform (default 1.0)\n";
+    std::cout << "    --iterations <n>: runs per timed query or tag read (default 5)\n";
+    std::cout << "    --fixtures <n>: audio fixtures per format, 0 to skip audio (default 20)\n";
+    std::cout << "    --fixture-seconds <n>: length of each fixture (default 30)\n";
+    std::cout << "    --queue-threads <n>: message queue producer threads (default 4)\n";
+    std::cout << "    --queue-messages <n>: total messages posted to the queue (default 100000)\n";
+    std::cout << "    --http-clients <n>: concurrent http range request clients, 0 to skip (default 8)\n";
+    std::cout << "    --http-requests <n>: total http range requests (default 400)\n";
+    std::cout << "    --seed <n>: random seed (default 1)\n";
+    std::cout << "    --workdir <path>: scratch directory (default: system temp)\n";
+    std::cout << "    --output <file>: write json here instead of stdout\n\n";
+}
+
+static bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+
+        try {
+            if (arg == "--tracks") { options.tracks = std::stoi(value); }
+            else if (arg == "--artists") { options.artists = std::stoi(value); }
+            else if (arg == "--albums") { options.albums = std::stoi(value); }
+            else if (arg == "--genres") { options.genres = std::stoi(value); }
+            else if (arg == "--skew") { options.skew = std::stod(value); }
+            else if (arg == "--iterations") { options.iterations = std::stoi(value); }
+            else if (arg == "--fixtures") { options.fixtures = std::stoi(value); }
+            else if (arg == "--fixture-seconds") { options.fixtureSeconds = std::stoi(value); }
+            else if (arg == "--queue-threads") { options.queueThreads = std::stoi(value); }
+            else if (arg == "--queue-messages") { options.queueMessages = std::stoi(value); }
+            else if (arg == "--http-clients") { options.httpClients = std::stoi(value); }
+            else if (arg == "--http-requests") { options.httpRequests = std::stoi(value); }
+            else if (arg == "--seed") { options.seed = (unsigned) std::stoul(value); }
+            else if (arg == "--workdir") { options.workDir = value; }
+            else if (arg == "--output") { options.output = value; }
+            else {
+                std::cerr << "unknown argument: " << arg << "\n";
+                return false;
+            }
+        }
+        catch (...) {
+            std::cerr << "invalid value for " << arg << "\n";
+            return false;
+        }
+
+        ++i;
+    }
+
+    return options.tracks > 0 && options.artists > 0 &&
+        options.albums > 0 && options.genres > 0 && options.iterations > 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+
+    if (!parseArgs(argc, argv, options)) {
+        printHelp();
+        return EXIT_FAILURE;
+    }
+
+    if (!options.workDir.size()) {
+        options.workDir = (boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path("musikcube-bench-%%%%%%%%")).string();
+    }
+
+    boost::filesystem::create_directories(options.workDir);
+
+    json output;
+    output["version"] = VERSION;
+    output["seed"] = options.seed;
+
+    {
+        std::string dbFilename = options.workDir + "/synthetic.db";
+        boost::filesystem::remove(dbFilename);
+
+        Connection db;
+        db.Open(dbFilename.c_str());
+        LocalLibrary::CreateDatabase(db);
+
+        output["library"] = populateSyntheticLibrary(db, options);
+        output["library"]["queries"] = benchmarkLibraryQueries(db, options);
+        output["wire_encoding"] = benchmarkWireEncoding(db, options);
+    }
+
+    output["message_queue"] = benchmarkMessageQueue(options);
+
+#ifndef WIN32
+    if (options.httpClients > 0) {
+        output["http_ranges"] = benchmarkHttpRanges(options.workDir, options);
+    }
+#endif
+
+    if (options.fixtures > 0) {
+        std::string fixtureDir = options.workDir + "/fixtures";
+        std::vector<std::string> files;
+
+        output["fixtures"] = generateFixtures(fixtureDir, options, files);
+
+        if (files.size()) {
+            output["indexer"] = benchmarkIndexer(options.workDir, fixtureDir);
+            output["tag_readers"] = benchmarkTagReaders(files, options);
+            output["decode"] = benchmarkDecode(files, false);
+            output["transcode"] = benchmarkDecode(files, true);
+        }
+        else {
+            output["audio_skipped"] = "no encoder plugins found";
+        }
+    }
+
+    if (options.output.size()) {
+        std::ofstream out(options.output);
+        out << output.dump(2) << "\n";
+    }
+    else {
+        std::cout << output.dump(2) << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -36,6 +36,7 @@
 
 #include <core/audio/Crossfader.h>
 #include <core/runtime/Message.h>
+#include <core/support/Metrics.h>
 
 #include <algorithm>
 #include <chrono>
@@ -63,6 +64,18 @@ using namespace std::chrono;
 #define MESSAGE_QUIT 0
 #define MESSAGE_TICK 1
 
+static musik::core::metrics::Counter& fadesMetric = musik::core::metrics::GetCounter(
+    "musikcube_crossfader_fades_total",
+    "fades started by the crossfader");
+
+static musik::core::metrics::Gauge& activeFadesMetric = musik::core::metrics::GetGauge(
+    "musikcube_crossfader_active_fades",
+    "fades currently in progress");
+
+static musik::core::metrics::Histogram& tickMetric = musik::core::metrics::GetHistogram(
+    "musikcube_crossfader_tick_duration_microseconds",
+    "time spent adjusting output volumes per crossfader tick");
+
 Crossfader::Crossfader(ITransport& transport)
 : transport(transport) {
     this->quit = false;
@@ -95,6 +108,8 @@ void Crossfader::Fade(
         context->ticksCounted = 0;
         context->ticksTotal = (durationMs / TICK_TIME_MILLIS);
         contextList.push_back(context);
+        fadesMetric.Increment();
+        activeFadesMetric.Set((int64_t) contextList.size());
 
         player->Attach(this);
 
@@ -127,6 +142,7 @@ void Crossfader::Stop() {
     }
 
     this->contextList.clear();
+    activeFadesMetric.Set(0);
 }
 
 void Crossfader::Drain() {
@@ -172,6 +188,8 @@ void Crossfader::Cancel(Player* player, Direction direction) {
 
                 return remove;
             });
+
+        activeFadesMetric.Set((int64_t) this->contextList.size());
     }
 }
 
@@ -224,6 +242,7 @@ void Crossfader::ProcessMessage(IMessage &message) {
 
             {
                 LOCK(this->contextListLock);
+                musik::core::metrics::ScopedTimer timer(tickMetric);
 
                 auto it = this->contextList.begin();
                 auto globalVolume = this->transport.Volume();
@@ -287,6 +306,7 @@ void Crossfader::ProcessMessage(IMessage &message) {
                 }
 
                 emptied = (this->contextList.size() == 0);
+                activeFadesMetric.Set((int64_t) this->contextList.size());
             } /* end critical section */
 
             /* notify outside of the critical section! */
@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+
+#include "DspChain.h"
+#include "Streams.h"
+
+using namespace musik::core::audio;
+using namespace musik::core::sdk;
+
+namespace {
+    /* presents a legacy IDSP as an interleaved IBlockDSP by wrapping each
+    block in a non-owning Buffer view. */
+    class LegacyDspAdapter : public IBlockDSP {
+        public:
+            LegacyDspAdapter(std::shared_ptr<IDSP> dsp)
+            : dsp(dsp), sampleRate(0), channels(0) {
+            }
+
+            virtual void Release() override { delete this; }
+            virtual DspLayout Layout() override { return DspLayout::Interleaved; }
+
+            virtual bool Configure(long sampleRate, int channels, int maxFrames) override {
+                this->sampleRate = sampleRate;
+                this->channels = channels;
+                return true;
+            }
+
+            virtual int Latency() override { return 0; }
+
+            virtual void Process(float* const* data, int frames) override {
+                Buffer view(data[0], frames * this->channels);
+                view.SetSampleRate(this->sampleRate);
+                view.SetChannels(this->channels);
+                this->dsp->Process(&view);
+            }
+
+        private:
+            std::shared_ptr<IDSP> dsp;
+            long sampleRate;
+            int channels;
+    };
+}
+
+DspChain::DspChain(int maxFrames)
+: maxFrames(maxFrames)
+, sampleRate(0)
+, channels(0)
+, latency(0.0) {
+    for (auto dsp : streams::GetBlockDspPlugins()) {
+        this->stages.push_back({ dsp, dsp->Layout(), false });
+    }
+
+    for (auto dsp : streams::GetDspPlugins()) {
+        auto adapter = std::shared_ptr<IBlockDSP>(new LegacyDspAdapter(dsp));
+        this->stages.push_back({ adapter, DspLayout::Interleaved, false });
+    }
+}
+
+void DspChain::Configure(long sampleRate, int channels) {
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+
+    this->planar.resize((size_t) channels * this->maxFrames);
+    this->planes.resize((size_t) channels);
+    for (int i = 0; i < channels; i++) {
+        this->planes[i] = this->planar.data() + (size_t) i * this->maxFrames;
+    }
+
+    int totalFrames = 0;
+    for (auto& stage : this->stages) {
+        stage.enabled = stage.dsp->Configure(sampleRate, channels, this->maxFrames);
+        if (stage.enabled) {
+            totalFrames += std::max(0, stage.dsp->Latency());
+        }
+    }
+
+    this->latency.store(sampleRate > 0 ? (double) totalFrames / (double) sampleRate : 0.0);
+}
+
+void DspChain::Deinterleave(const float* input, int frames) {
+    const int channels = this->channels;
+    for (int c = 0; c < channels; c++) {
+        float* plane = this->planes[c];
+        const float* src = input + c;
+        for (int i = 0; i < frames; i++) {
+            plane[i] = src[i * channels];
+        }
+    }
+}
+
+void DspChain::Interleave(float* output, int frames) {
+    const int channels = this->channels;
+    for (int c = 0; c < channels; c++) {
+        const float* plane = this->planes[c];
+        float* dst = output + c;
+        for (int i = 0; i < frames; i++) {
+            dst[i * channels] = plane[i];
+        }
+    }
+}
+
+void DspChain::Process(Buffer* buffer) {
+    if (this->stages.empty() || buffer->Channels() <= 0) {
+        return;
+    }
+
+    if (buffer->SampleRate() != this->sampleRate || buffer->Channels() != this->channels) {
+        this->Configure(buffer->SampleRate(), buffer->Channels());
+    }
+
+    const int channels = this->channels;
+    const long totalFrames = buffer->Samples() / channels;
+    float* samples = buffer->BufferPointer();
+
+    for (long offset = 0; offset < totalFrames; offset += this->maxFrames) {
+        const int frames = (int) std::min((long) this->maxFrames, totalFrames - offset);
+        float* interleaved = samples + offset * channels;
+        bool inPlanar = false;
+
+        for (auto& stage : this->stages) {
+            if (!stage.enabled) {
+                continue;
+            }
+
+            if (stage.layout == DspLayout::Planar) {
+                if (!inPlanar) {
+                    this->Deinterleave(interleaved, frames);
+                    inPlanar = true;
+                }
+                stage.dsp->Process(this->planes.data(), frames);
+            }
+            else {
+                if (inPlanar) {
+                    this->Interleave(interleaved, frames);
+                    inPlanar = false;
+                }
+                stage.dsp->Process(&interleaved, frames);
+            }
+        }
+
+        if (inPlanar) {
+            this->Interleave(interleaved, frames);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/config.h>
+#include <core/audio/Buffer.h>
+#include <core/sdk/IDSP.h>
+#include <core/sdk/IBlockDSP.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace musik { namespace core { namespace audio {
+
+    /* runs a stream's DSP plugins over each decoded buffer, in place. the
+    chain is (re)configured whenever the buffer format changes, splits
+    buffers into blocks no larger than the negotiated maximum, and only
+    converts between interleaved and planar layouts when consecutive DSPs
+    disagree. legacy IDSP plugins are wrapped in an adapter and run as
+    interleaved block DSPs. */
+    class DspChain {
+        public:
+            using IDSP = musik::core::sdk::IDSP;
+            using IBlockDSP = musik::core::sdk::IBlockDSP;
+
+            DspChain(int maxFrames);
+
+            bool Empty() const { return this->stages.empty(); }
+            void Process(Buffer* buffer);
+
+            /* total latency introduced by the configured DSPs */
+            double Latency() const { return this->latency.load(); }
+
+        private:
+            struct Stage {
+                std::shared_ptr<IBlockDSP> dsp;
+                musik::core::sdk::DspLayout layout;
+                bool enabled;
+            };
+
+            void Configure(long sampleRate, int channels);
+            void Deinterleave(const float* input, int frames);
+            void Interleave(float* output, int frames);
+
+            std::vector<Stage> stages;
+            int maxFrames;
+            long sampleRate;
+            int channels;
+            std::atomic<double> latency;
+
+            /* planar scratch space shared by consecutive planar stages, so
+            we only convert once per run of them. sized at configure time;
+            nothing is allocated while processing. */
+            std::vector<float> planar;
+            std::vector<float*> planes;
+    };
+
+} } }
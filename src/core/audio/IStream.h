@@ -57,8 +57,10 @@ namespace musik { namespace core { namespace audio {
             virtual double SetPosition(double seconds) = 0;
             virtual double GetDuration() = 0;
             virtual bool OpenStream(std::string uri) = 0;
+            virtual void SetPrerollBufferCount(int count) = 0;
             virtual void Interrupt() = 0;
             virtual int GetCapabilities() = 0;
+            virtual double GetLatency() = 0;
             virtual bool Eof() = 0;
     };
 
@@ -39,7 +39,8 @@
 #include <core/audio/MasterTransport.h>
 #include <core/library/LocalLibraryConstants.h>
 #include <core/library/track/Track.h>
-#include <core/library/query/local/ReplayGainQuery.h>
+#include <core/library/query/local/PlaybackInfoQuery.h>
+#include <core/library/query/local/PersistedPlayQueueQuery.h>
 #include <core/plugin/PluginFactory.h>
 #include <core/runtime/MessageQueue.h>
 #include <core/runtime/Message.h>
@@ -49,6 +50,9 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include <thread>
+#include <chrono>
+
 using namespace musik::core::library;
 using namespace musik::core;
 using namespace musik::core::prefs;
@@ -56,11 +60,13 @@ using namespace musik::core::sdk;
 using namespace musik::core::runtime;
 using namespace musik::core::audio;
 using namespace musik::core::db::local;
+using musik::core::db::IQuery;
 
 using musik::core::TrackPtr;
 using musik::core::ILibraryPtr;
 using musik::core::audio::ITransport;
 using Editor = PlaybackService::Editor;
+using PlaybackInfoQuery = musik::core::db::local::PlaybackInfoQuery;
 
 #undef DEBUG_USE_HTTP_URIS
 
@@ -68,6 +74,11 @@ using Editor = PlaybackService::Editor;
 #define START_OVER (size_t) -2
 
 #define PREVIOUS_GRACE_PERIOD 2.0f
+#define MAX_JOURNALED_EDITS 512
+#define PREFETCH_COUNT 3
+#define PERSIST_QUEUE_DELAY_MS 1000
+#define MIN_PERSISTED_EDITS_BEFORE_COMPACT 1024
+#define MAX_PREPARED 64
 
 #define MESSAGE_STREAM_EVENT 1000
 #define MESSAGE_PLAYBACK_EVENT 1001
@@ -80,6 +91,7 @@ using Editor = PlaybackService::Editor;
 #define MESSAGE_NOTIFY_RESET 1008
 #define MESSAGE_SEEK 1009
 #define MESSAGE_RELOAD_OUTPUT 1010
+#define MESSAGE_PERSIST_QUEUE 1011
 
 class StreamMessage : public Message {
     public:
@@ -143,8 +155,13 @@ PlaybackService::PlaybackService(
 , repeatMode(RepeatNone)
 , messageQueue(messageQueue)
 , seekPosition(-1.0f)
+, queueRevision(0)
+, journalRevision(0)
+, persistedEditCount(0)
+, snapshotRequired(false)
 , index(NO_POSITION)
 , nextIndex(NO_POSITION)
+, prepareNextAfterPrefetch(false)
 , playbackPrefs(Preferences::ForComponent(components::Playback))
 , appPrefs(Preferences::ForComponent(components::Settings)) {
     transport->StreamEvent.connect(this, &PlaybackService::OnStreamEvent);
@@ -152,6 +169,7 @@ PlaybackService::PlaybackService(
     transport->VolumeChanged.connect(this, &PlaybackService::OnVolumeChanged);
     transport->TimeChanged.connect(this, &PlaybackService::OnTimeChanged);
     library->Indexer()->Finished.connect(this, &PlaybackService::OnIndexerFinished);
+    library->QueryCompleted.connect(this, &PlaybackService::OnQueryCompleted);
     loadPreferences(this->transport, *this, playbackPrefs);
     playback::LoadPlaybackContext(appPrefs, library, *this);
     this->InitRemotes();
@@ -169,6 +187,7 @@ PlaybackService::~PlaybackService() {
     savePreferences(*this, playbackPrefs);
     this->Stop();
     this->ResetRemotes();
+    this->messageQueue.Remove(this);
 }
 
 void PlaybackService::InitRemotes() {
@@ -192,12 +211,12 @@ void PlaybackService::PrepareNextTrack() {
     std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
 
     if (this->Count() > 0) {
+        size_t current = this->index;
+        this->Prefetch((current == NO_POSITION || current == START_OVER) ? 0 : current);
+
         /* repeat track, just keep playing the same thing over and over */
         if (this->repeatMode == RepeatTrack) {
-            this->nextIndex = this->index;
-            this->transport->PrepareNextTrack(
-                this->UriAtIndex(this->index),
-                this->GainAtIndex(this->index));
+            this->PrepareNextTrackAt(this->index);
         }
         else {
             /* annoying and confusing special case -- the user edited the
@@ -205,29 +224,21 @@ void PlaybackService::PrepareNextTrack() {
             again from the top... */
             if (this->index == START_OVER) {
                 if (this->playlist.Count() > 0) {
-                    this->index = NO_POSITION;
-                    this->nextIndex = 0;
-                    this->transport->PrepareNextTrack(
-                        this->UriAtIndex(nextIndex),
-                        this->GainAtIndex(nextIndex));
+                    if (this->PrepareNextTrackAt(0)) {
+                        this->index = NO_POSITION;
+                    }
                 }
             }
             /* normal case, just move forward */
             else if (this->playlist.Count() > this->index + 1) {
                 if (this->nextIndex != this->index + 1) {
-                    this->nextIndex = this->index + 1;
-                    this->transport->PrepareNextTrack(
-                        this->UriAtIndex(nextIndex),
-                        this->GainAtIndex(nextIndex));
+                    this->PrepareNextTrackAt(this->index + 1);
                 }
             }
             /* repeat list case, wrap around to the beginning if necessary */
             else if (this->repeatMode == RepeatList) {
                 if (this->nextIndex != 0) {
-                    this->nextIndex = 0;
-                    this->transport->PrepareNextTrack(
-                        this->UriAtIndex(nextIndex),
-                        this->GainAtIndex(nextIndex));
+                    this->PrepareNextTrackAt(0);
                 }
             }
             else {
@@ -238,6 +249,23 @@ void PlaybackService::PrepareNextTrack() {
     }
 }
 
+bool PlaybackService::PrepareNextTrackAt(size_t index) {
+    std::string uri;
+    ITransport::Gain gain;
+
+    if (!this->GetPrepared(index, uri, gain)) {
+        /* still being loaded by the library. don't block the message queue
+        on it; OnQueryCompleted() will ask us to try again. */
+        std::unique_lock<std::mutex> lock(this->preparedMutex);
+        this->prepareNextAfterPrefetch = true;
+        return false;
+    }
+
+    this->nextIndex = index;
+    this->transport->PrepareNextTrack(uri, gain);
+    return true;
+}
+
 void PlaybackService::SetRepeatMode(RepeatMode mode) {
     if (this->repeatMode != mode) {
         this->repeatMode = mode;
@@ -278,6 +306,8 @@ void PlaybackService::ToggleShuffle() {
         shuffled = true;
     }
 
+    this->ResetJournal();
+
     /* find the new playback index and prefetch the next track */
     if (id != -1) {
         int index = this->playlist.IndexOf(id);
@@ -406,6 +436,9 @@ void PlaybackService::ProcessMessage(IMessage &message) {
             this->seekPosition = -1.0f;
         }
     }
+    else if (type == MESSAGE_PERSIST_QUEUE) {
+        this->PersistQueue();
+    }
     else if (type == MESSAGE_RELOAD_OUTPUT) {
         auto state = this->GetPlaybackState();
         auto index = this->GetIndex();
@@ -585,6 +618,7 @@ bool PlaybackService::HotSwap(const TrackList& tracks, size_t index) {
         temp.CopyFrom(tracks);
         this->playlist.Swap(temp);
         this->unshuffled.Clear();
+        this->ResetJournal();
         this->index = found ? index : NO_POSITION;
         this->nextIndex = NO_POSITION;
     }
@@ -607,6 +641,7 @@ void PlaybackService::Play(const TrackList& tracks, size_t index) {
             temp.CopyFrom(tracks);
             this->playlist.Swap(temp);
             this->unshuffled.Clear();
+            this->ResetJournal();
         }
     }
 
@@ -657,6 +692,7 @@ void PlaybackService::CopyFrom(const TrackList& source) {
     std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
 
     this->playlist.CopyFrom(source);
+    this->ResetJournal();
     this->index = NO_POSITION;
     this->nextIndex = NO_POSITION;
 
@@ -686,6 +722,8 @@ void PlaybackService::CopyFrom(const musik::core::sdk::ITrackList* source) {
             this->playlist.Add(source->GetId(i));
         }
 
+        this->ResetJournal();
+
         this->index = NO_POSITION;
         this->nextIndex = NO_POSITION;
 
@@ -698,16 +736,152 @@ void PlaybackService::CopyFrom(const musik::core::sdk::ITrackList* source) {
     }
 }
 
+void PlaybackService::RestoreQueue(const TrackList& source, size_t persistedEditCount) {
+    std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+
+    this->CopyFrom(source);
+
+    /* what we just loaded is exactly what's in the database, so there's
+    nothing to write back. */
+    this->messageQueue.Remove(this, MESSAGE_PERSIST_QUEUE);
+    this->unpersistedEdits.clear();
+    this->snapshotRequired = false;
+    this->persistedEditCount = persistedEditCount;
+}
+
+bool PlaybackService::CancelPendingPersists() {
+    /* called with playlistMutex held. anything that hasn't started yet is
+    canceled and will be skipped by the library thread; anything that is
+    already running is allowed to finish. returns true if any pending
+    writes were dropped, in which case the caller must snapshot. */
+    bool dropped = false;
+
+    for (auto& query : this->pendingPersists) {
+        query->Cancel();
+    }
+
+    for (auto& query : this->pendingPersists) {
+        int status = query->GetStatus();
+        while (status == IQuery::Running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            status = query->GetStatus();
+        }
+
+        if (status != IQuery::Finished) {
+            dropped = true;
+        }
+    }
+
+    this->pendingPersists.clear();
+    return dropped;
+}
+
+void PlaybackService::PersistQueue(bool synchronous) {
+    std::shared_ptr<PersistedPlayQueueQuery> query;
+
+    {
+        std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+
+        if (!appPrefs->GetBool(keys::SaveSessionOnExit, true)) {
+            this->unpersistedEdits.clear();
+            return;
+        }
+
+        if (synchronous) {
+            /* the debounced write we're flushing may still be queued, and
+            earlier asynchronous writes may not have landed yet. make sure
+            none of them can run after this one; if any were dropped the
+            journal is incomplete, so rewrite the whole queue. */
+            this->messageQueue.Remove(this, MESSAGE_PERSIST_QUEUE);
+            if (this->CancelPendingPersists()) {
+                this->snapshotRequired = true;
+            }
+        }
+        else {
+            /* forget writes that have already completed */
+            auto it = this->pendingPersists.begin();
+            while (it != this->pendingPersists.end()) {
+                int status = (*it)->GetStatus();
+                if (status == IQuery::Finished) {
+                    it = this->pendingPersists.erase(it);
+                }
+                else if (status == IQuery::Failed || status == IQuery::Canceled) {
+                    /* the journal now has a hole; the next write must be
+                    a full snapshot. */
+                    it = this->pendingPersists.erase(it);
+                    this->snapshotRequired = true;
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        /* once the journal grows larger than the queue itself it's cheaper
+        to restore from a fresh snapshot, so compact it. */
+        size_t compactAfter = std::max(
+            (size_t) MIN_PERSISTED_EDITS_BEFORE_COMPACT, this->playlist.Count());
+
+        if (this->snapshotRequired ||
+            this->persistedEditCount + this->unpersistedEdits.size() > compactAfter)
+        {
+            std::vector<int64_t> ids;
+            ids.reserve(this->playlist.Count());
+            for (size_t i = 0; i < this->playlist.Count(); i++) {
+                ids.push_back(this->playlist.GetId(i));
+            }
+
+            query.reset(PersistedPlayQueueQuery::Snapshot(ids));
+            this->persistedEditCount = 0;
+        }
+        else if (this->unpersistedEdits.size()) {
+            query.reset(PersistedPlayQueueQuery::Append(this->unpersistedEdits));
+            this->persistedEditCount += this->unpersistedEdits.size();
+        }
+
+        this->unpersistedEdits.clear();
+        this->snapshotRequired = false;
+
+        if (query && !synchronous) {
+            this->pendingPersists.push_back(query);
+        }
+    }
+
+    if (query) {
+        this->library->Enqueue(query, synchronous ? ILibrary::QuerySynchronous : 0);
+    }
+}
+
 void PlaybackService::PlayAt(size_t index, ITransport::StartMode mode) {
     index = std::min(this->Count(), index);
 
-    std::string uri = this->UriAtIndex(index);
-    auto gain = this->GainAtIndex(index);
+    std::string uri;
+    ITransport::Gain gain;
+
+    if (!this->GetPrepared(index, uri, gain) && index < this->playlist.Count()) {
+        /* the user asked for this track explicitly, so there's nothing to
+        gain by deferring; load it synchronously, then prefetch what's next. */
+        std::vector<int64_t> ids = { this->playlist.GetId(index) };
+        auto query = std::make_shared<PlaybackInfoQuery>(ids);
+        this->library->Enqueue(query, ILibrary::QuerySynchronous);
+        if (query->GetStatus() == musik::core::db::IQuery::Finished) {
+            auto result = query->GetResult();
+            auto it = result->find(ids[0]);
+            if (it != result->end()) {
+                {
+                    std::unique_lock<std::mutex> lock(this->preparedMutex);
+                    this->prepared[ids[0]] = it->second;
+                }
+                this->GetPrepared(index, uri, gain);
+            }
+        }
+    }
 
     if (uri.size()) {
         transport->Start(uri, gain, mode);
         this->nextIndex = NO_POSITION;
         this->index = index;
+        this->Prefetch(index);
     }
 }
 
@@ -897,6 +1071,95 @@ void PlaybackService::OnIndexerFinished(int trackCount) {
     std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
     this->playlist.ClearCache();
     this->unshuffled.ClearCache();
+
+    std::unique_lock<std::mutex> preparedLock(this->preparedMutex);
+    this->prepared.clear();
+}
+
+void PlaybackService::OnQueryCompleted(musik::core::db::IQuery* query) {
+    std::unique_lock<std::mutex> lock(this->preparedMutex);
+
+    auto& queries = this->prefetchQueries;
+
+    auto it = std::find_if(queries.begin(), queries.end(),
+        [query](std::shared_ptr<PlaybackInfoQuery>& q) {
+            return q.get() == query;
+        });
+
+    if (it == queries.end()) {
+        return;
+    }
+
+    auto completed = *it;
+    queries.erase(it);
+
+    auto result = completed->GetResult();
+    for (int64_t id : completed->GetTrackIds()) {
+        this->prefetching.erase(id);
+
+        /* tracks that have since been removed from the library get an
+        empty entry so we don't keep asking for them. */
+        auto entry = result->find(id);
+        this->prepared[id] = (entry != result->end())
+            ? entry->second : PlaybackInfoQuery::Entry();
+    }
+
+    if (this->prepareNextAfterPrefetch) {
+        this->prepareNextAfterPrefetch = false;
+        POST(this, MESSAGE_PREPARE_NEXT_TRACK, NO_POSITION, 0);
+    }
+}
+
+void PlaybackService::Prefetch(size_t index) {
+    /* assumes playlistMutex is held */
+    size_t count = this->playlist.Count();
+    if (index >= count) {
+        return;
+    }
+
+    std::vector<int64_t> window;
+    for (size_t i = 0; i <= PREFETCH_COUNT; i++) {
+        size_t at = index + i;
+        if (at >= count) {
+            if (this->repeatMode != RepeatList) {
+                break;
+            }
+            at %= count;
+        }
+        window.push_back(this->playlist.GetId(at));
+    }
+
+    std::unique_lock<std::mutex> lock(this->preparedMutex);
+
+    if (this->prepared.size() > MAX_PREPARED) {
+        std::unordered_map<int64_t, PlaybackInfoQuery::Entry> keep;
+        for (int64_t id : window) {
+            auto it = this->prepared.find(id);
+            if (it != this->prepared.end()) {
+                keep[id] = it->second;
+            }
+        }
+        this->prepared.swap(keep);
+    }
+
+    std::vector<int64_t> missing;
+    for (int64_t id : window) {
+        if (this->prepared.find(id) == this->prepared.end() &&
+            this->prefetching.find(id) == this->prefetching.end())
+        {
+            this->prefetching.insert(id);
+            missing.push_back(id);
+        }
+    }
+
+    if (missing.size()) {
+        auto query = std::make_shared<PlaybackInfoQuery>(missing);
+        this->prefetchQueries.push_back(query);
+        lock.unlock();
+
+        /* completion is delivered to OnQueryCompleted() */
+        this->library->Enqueue(query);
+    }
 }
 
 /* our Editor interface. we proxy all of the ITrackListEditor methods so we
@@ -959,6 +1222,8 @@ PlaybackService::Editor::~Editor() {
 
 bool PlaybackService::Editor::Insert(int64_t id, size_t index) {
     if ((this->edited = this->tracks->Insert(id, index))) {
+        playback.JournalEdit(TrackListEditType::Insert, id, index, index);
+
         if (index == this->playIndex) {
             ++this->playIndex;
         }
@@ -974,6 +1239,8 @@ bool PlaybackService::Editor::Insert(int64_t id, size_t index) {
 
 bool PlaybackService::Editor::Swap(size_t index1, size_t index2) {
     if ((this->edited = this->tracks->Swap(index1, index2))) {
+        playback.JournalEdit(TrackListEditType::Swap, -1, index1, index2);
+
         if (index1 == this->playIndex) {
             this->playIndex = index2;
             this->nextTrackInvalidated = true;
@@ -990,6 +1257,8 @@ bool PlaybackService::Editor::Swap(size_t index1, size_t index2) {
 
 bool PlaybackService::Editor::Move(size_t from, size_t to) {
     if ((this->edited = this->tracks->Move(from, to))) {
+        playback.JournalEdit(TrackListEditType::Move, -1, from, to);
+
         if (from == this->playIndex) {
             this->playIndex = to;
         }
@@ -1008,6 +1277,8 @@ bool PlaybackService::Editor::Move(size_t from, size_t to) {
 
 bool PlaybackService::Editor::Delete(size_t index) {
     if ((this->edited = this->tracks->Delete(index))) {
+        playback.JournalEdit(TrackListEditType::Delete, -1, index, index);
+
         if (this->playback.Count() == 0) {
             this->playIndex = NO_POSITION;
         }
@@ -1028,6 +1299,9 @@ bool PlaybackService::Editor::Delete(size_t index) {
 void PlaybackService::Editor::Add(const int64_t id) {
     this->tracks->Add(id);
 
+    size_t added = this->playback.Count() - 1;
+    playback.JournalEdit(TrackListEditType::Add, id, added, added);
+
     if (this->playback.Count() - 1 == this->playIndex + 1) {
         this->nextTrackInvalidated = true;
     }
@@ -1038,6 +1312,7 @@ void PlaybackService::Editor::Add(const int64_t id) {
 void PlaybackService::Editor::Clear() {
     playback.playlist.Clear();
     playback.unshuffled.Clear();
+    playback.ResetJournal();
     this->playIndex = -1;
     this->nextTrackInvalidated = true;
     this->edited = true;
@@ -1061,6 +1336,12 @@ void PlaybackService::Editor::Release() {
 }
 
 std::string PlaybackService::UriAtIndex(size_t index) {
+    std::string uri;
+    ITransport::Gain gain;
+    if (this->GetPrepared(index, uri, gain)) {
+        return uri;
+    }
+
     if (index < this->playlist.Count()) {
         auto track = this->playlist.Get(index);
         if (track) {
@@ -1081,7 +1362,71 @@ ITrackList* PlaybackService::Clone() {
     return to->GetSdkValue();
 }
 
-ITransport::Gain PlaybackService::GainAtIndex(size_t index) {
+uint64_t PlaybackService::GetQueueRevision() {
+    std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+    return this->queueRevision;
+}
+
+int PlaybackService::GetQueueEdits(uint64_t sinceRevision, TrackListEdit* target, size_t count) {
+    std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+
+    if (sinceRevision < this->journalRevision || sinceRevision > this->queueRevision) {
+        return -1;
+    }
+
+    /* revisions in the journal are contiguous, starting at journalRevision + 1 */
+    size_t start = (size_t)(sinceRevision - this->journalRevision);
+    size_t available = this->journal.size() - start;
+
+    if (target) {
+        size_t n = std::min(count, available);
+        std::copy(
+            this->journal.begin() + start,
+            this->journal.begin() + start + n,
+            target);
+    }
+
+    return (int) available;
+}
+
+void PlaybackService::JournalEdit(TrackListEditType type, int64_t id, size_t from, size_t to) {
+    std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+
+    TrackListEdit edit;
+    edit.revision = ++this->queueRevision;
+    edit.type = type;
+    edit.id = id;
+    edit.from = from;
+    edit.to = to;
+
+    this->journal.push_back(edit);
+
+    while (this->journal.size() > MAX_JOURNALED_EDITS) {
+        this->journal.pop_front();
+        ++this->journalRevision;
+    }
+
+    if (!this->snapshotRequired) {
+        this->unpersistedEdits.push_back(edit);
+    }
+
+    this->messageQueue.Debounce(
+        Message::Create(this, MESSAGE_PERSIST_QUEUE), PERSIST_QUEUE_DELAY_MS);
+}
+
+void PlaybackService::ResetJournal() {
+    std::unique_lock<std::recursive_mutex> lock(this->playlistMutex);
+    this->journal.clear();
+    this->journalRevision = ++this->queueRevision;
+
+    this->unpersistedEdits.clear();
+    this->snapshotRequired = true;
+
+    this->messageQueue.Debounce(
+        Message::Create(this, MESSAGE_PERSIST_QUEUE), PERSIST_QUEUE_DELAY_MS);
+}
+
+ITransport::Gain PlaybackService::GetGain(const ReplayGain& rg) {
     using Mode = ReplayGainMode;
 
     ITransport::Gain result;
@@ -1092,21 +1437,38 @@ ITransport::Gain PlaybackService::GainAtIndex(size_t index) {
 
     Mode mode = (Mode)playbackPrefs->GetInt(keys::ReplayGainMode.c_str(), (int) Mode::Disabled);
 
-    if (mode != Mode::Disabled && index < this->playlist.Count()) {
-        int64_t id = this->playlist.Get(index)->GetId();
-        auto query = std::make_shared<ReplayGainQuery>(id);
-        if (this->library->Enqueue(query, ILibrary::QuerySynchronous)) {
-            auto rg = query->GetResult();
-            float gain = (mode == Mode::Album) ? rg->albumGain : rg->trackGain;
-            float peak = (mode == Mode::Album) ? rg->albumPeak : rg->trackPeak;
-            if (gain != 1.0f) {
-                /* http://wiki.hydrogenaud.io/index.php?title=ReplayGain_2.0_specification#Reduced_gain */
-                result.gain = powf(10.0f, (gain / 20.0f));
-                result.peak = (1.0f / peak);
-                result.peakValid = true;
-            }
+    if (mode != Mode::Disabled) {
+        float gain = (mode == Mode::Album) ? rg.albumGain : rg.trackGain;
+        float peak = (mode == Mode::Album) ? rg.albumPeak : rg.trackPeak;
+        if (gain != 1.0f) {
+            /* http://wiki.hydrogenaud.io/index.php?title=ReplayGain_2.0_specification#Reduced_gain */
+            result.gain = powf(10.0f, (gain / 20.0f));
+            result.peak = (1.0f / peak);
+            result.peakValid = true;
         }
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+bool PlaybackService::GetPrepared(size_t index, std::string& uri, ITransport::Gain& gain) {
+    if (index >= this->playlist.Count()) {
+        return false;
+    }
+
+    int64_t id = this->playlist.GetId(index);
+
+    std::unique_lock<std::mutex> lock(this->preparedMutex);
+    auto it = this->prepared.find(id);
+    if (it == this->prepared.end()) {
+        return false;
+    }
+
+#ifdef DEBUG_USE_HTTP_URIS
+    uri = "http://localhost:7906/audio/" + std::to_string(id);
+#else
+    uri = it->second.uri;
+#endif
+    gain = this->GetGain(it->second.replayGain);
+    return true;
+}
@@ -41,11 +41,16 @@
 #include <core/library/track/Track.h>
 #include <core/library/track/TrackList.h>
 #include <core/library/ILibrary.h>
+#include <core/library/query/local/PlaybackInfoQuery.h>
+#include <core/library/query/local/PersistedPlayQueueQuery.h>
 #include <core/audio/MasterTransport.h>
 #include <core/support/Preferences.h>
 #include <core/runtime/IMessageQueue.h>
 
 #include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace musik { namespace core { namespace audio {
 
@@ -111,6 +116,11 @@ namespace musik { namespace core { namespace audio {
             virtual void SetTimeChangeMode(musik::core::sdk::TimeChangeMode) override;
             virtual void ReloadOutput() override;
             virtual musik::core::sdk::ITrackList* Clone() override;
+            virtual uint64_t GetQueueRevision() override;
+            virtual int GetQueueEdits(
+                uint64_t sinceRevision,
+                musik::core::sdk::TrackListEdit* target,
+                size_t count) override;
 
             /* TODO: include in SDK? */
             virtual bool HotSwap(const TrackList& source, size_t index = 0);
@@ -122,6 +132,9 @@ namespace musik { namespace core { namespace audio {
             void Prepare(size_t index, double position = 0.0f);
             void CopyTo(musik::core::TrackList& target);
             void CopyFrom(const musik::core::TrackList& source);
+            void RestoreQueue(const musik::core::TrackList& source, size_t persistedEditCount);
+            void PersistQueue(bool synchronous = false);
+            bool CancelPendingPersists();
             musik::core::TrackPtr GetTrackAtIndex(size_t index);
             musik::core::TrackPtr GetPlaying();
 
@@ -180,6 +193,7 @@ namespace musik { namespace core { namespace audio {
             void OnVolumeChanged();
             void OnTimeChanged(double time);
             void OnIndexerFinished(int trackCount);
+            void OnQueryCompleted(musik::core::db::IQuery* query);
 
             void NotifyRemotesModeChanged();
             void PrepareNextTrack();
@@ -188,8 +202,17 @@ namespace musik { namespace core { namespace audio {
 
             void PlayAt(size_t index, ITransport::StartMode mode);
 
+            void JournalEdit(
+                musik::core::sdk::TrackListEditType type,
+                int64_t id, size_t from, size_t to);
+
+            void ResetJournal();
+
             std::string UriAtIndex(size_t index);
-            musik::core::audio::ITransport::Gain GainAtIndex(size_t index);
+            musik::core::audio::ITransport::Gain GetGain(const musik::core::sdk::ReplayGain& replayGain);
+            bool GetPrepared(size_t index, std::string& uri, musik::core::audio::ITransport::Gain& gain);
+            bool PrepareNextTrackAt(size_t index);
+            void Prefetch(size_t index);
 
             musik::core::TrackList playlist;
             musik::core::TrackList unshuffled;
@@ -209,6 +232,35 @@ namespace musik { namespace core { namespace audio {
 
             double seekPosition;
 
+            /* bounded journal of recent queue edits, so remotes can sync
+            incrementally. the journal covers every revision greater than
+            journalRevision; anything older requires a full re-read. */
+            std::deque<musik::core::sdk::TrackListEdit> journal;
+            uint64_t queueRevision, journalRevision;
+
+            /* edits that haven't been written to the persisted play queue
+            yet. if snapshotRequired is set the whole queue is rewritten
+            instead, e.g. after it was replaced or shuffled. */
+            std::vector<musik::core::sdk::TrackListEdit> unpersistedEdits;
+            size_t persistedEditCount;
+            bool snapshotRequired;
+
+            /* asynchronous persists that may not have run yet. a synchronous
+            persist cancels or waits on these first, so they can't land after
+            (or underneath) it. */
+            using PersistedPlayQueueQuery = musik::core::db::local::PersistedPlayQueueQuery;
+            std::vector<std::shared_ptr<PersistedPlayQueueQuery>> pendingPersists;
+
+            /* uri and replay gain for play queue entries around the current
+            index, keyed by track id. loaded asynchronously, so preparing the
+            next track doesn't have to wait on the library thread. */
+            using PlaybackInfoQuery = musik::core::db::local::PlaybackInfoQuery;
+            std::mutex preparedMutex;
+            std::unordered_map<int64_t, PlaybackInfoQuery::Entry> prepared;
+            std::unordered_set<int64_t> prefetching;
+            std::vector<std::shared_ptr<PlaybackInfoQuery>> prefetchQueries;
+            bool prepareNextAfterPrefetch;
+
             musik::core::runtime::IMessageQueue& messageQueue;
     };
 
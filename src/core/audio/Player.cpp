@@ -40,6 +40,9 @@
 #include <core/audio/Player.h>
 #include <core/audio/Visualizer.h>
 #include <core/plugin/PluginFactory.h>
+#include <core/support/Metrics.h>
+#include <core/support/Preferences.h>
+#include <core/support/PreferenceKeys.h>
 #include <core/sdk/constants.h>
 
 #include <algorithm>
@@ -52,6 +55,7 @@
 
 using namespace musik::core::audio;
 using namespace musik::core::sdk;
+using namespace musik::core::prefs;
 
 using std::min;
 using std::max;
@@ -59,6 +63,22 @@ using std::max;
 static std::string TAG = "Player";
 static float* hammingWindow = nullptr;
 
+static musik::core::metrics::Counter& underrunMetric = musik::core::metrics::GetCounter(
+    "musikcube_player_underruns_total",
+    "times a player had no decoded buffer ready for the output");
+
+static musik::core::metrics::Counter& outputRetryMetric = musik::core::metrics::GetCounter(
+    "musikcube_player_output_retries_total",
+    "times the output couldn't accept a buffer, and the player had to wait");
+
+static musik::core::metrics::Gauge& pendingBuffersMetric = musik::core::metrics::GetGauge(
+    "musikcube_player_pending_buffers",
+    "decoded buffers handed to outputs that haven't finished playing, across all players");
+
+static musik::core::metrics::Histogram& transitionGapMetric = musik::core::metrics::GetHistogram(
+    "musikcube_player_transition_gap_samples",
+    "sample frames between a prepared player being started and its first buffer reaching the output");
+
 using Listener = Player::EventListener;
 using ListenerList = std::list<Listener*>;
 
@@ -131,6 +151,8 @@ Player::Player(
 , seekToPosition(-1)
 , nextMixPoint(-1.0)
 , pendingBufferCount(0)
+, prepared(false)
+, warmStart(false)
 , destroyMode(destroyMode)
 , fftContext(nullptr)
 , gain(gain) {
@@ -159,6 +181,14 @@ void Player::Play() {
     std::unique_lock<std::mutex> lock(this->queueMutex);
 
     if (this->state != Player::Quit) {
+        if (this->state == Player::Idle) {
+            /* if our stream was already opened and pre-rolled, this is a
+            transition from the previous track. remember when we were asked
+            to start so we can measure the gap. */
+            this->warmStart = this->prepared;
+            this->playRequestedAt = std::chrono::steady_clock::now();
+        }
+
         this->state = Player::Playing;
         this->writeToOutputCondition.notify_all();
     }
@@ -212,15 +242,22 @@ ListenerList Player::Listeners() {
     return ListenerList(this->listeners);
 }
 
+double Player::GetLatency() {
+    /* the output's buffering, plus any delay introduced by DSPs */
+    double latency = this->output ? this->output->Latency() : 0.0;
+    auto stream = this->stream;
+    return stream ? latency + stream->GetLatency() : latency;
+}
+
 double Player::GetPosition() {
     double seek = this->seekToPosition.load();
     double current = this->currentPosition.load();
-    const double latency = this->output ? this->output->Latency() : 0.0;
+    const double latency = this->GetLatency();
     return std::max(0.0, round((seek >= 0 ? seek : current) - latency));
 }
 
 double Player::GetPositionInternal() {
-    const double latency = this->output ? this->output->Latency() : 0.0;
+    const double latency = this->GetLatency();
     return std::max(0.0, round(this->currentPosition.load() - latency));
 }
 
@@ -289,6 +326,9 @@ void musik::core::audio::playerThreadLoop(Player* player) {
 
     player->stream = Stream::Create();
 
+    player->stream->SetPrerollBufferCount(
+        Preferences::ForComponent(components::Playback)->GetInt(keys::PrerollBufferCount, 0));
+
     Buffer* buffer = nullptr;
 
     float gain = player->gain.preamp * player->gain.gain;
@@ -297,16 +337,24 @@ void musik::core::audio::playerThreadLoop(Player* player) {
     }
 
     if (player->stream->OpenStream(player->url)) {
+        {
+            std::unique_lock<std::mutex> lock(player->queueMutex);
+            player->prepared = true;
+        }
+
         for (Listener* l : player->Listeners()) {
             l->OnPlayerPrepared(player);
         }
 
+        bool measureGap = false;
+
         /* wait until we enter the Playing or Quit state */
         {
             std::unique_lock<std::mutex> lock(player->queueMutex);
             while (player->state == Player::Idle) {
                 player->writeToOutputCondition.wait(lock);
             }
+            measureGap = player->warmStart;
         }
 
         /* we're ready to go.... */
@@ -361,6 +409,7 @@ void musik::core::audio::playerThreadLoop(Player* player) {
                     }
 
                     ++player->pendingBufferCount;
+                    pendingBuffersMetric.Add(1);
                 }
             }
 
@@ -370,16 +419,26 @@ void musik::core::audio::playerThreadLoop(Player* player) {
                 /* if this result is negative it's an error code defined by the sdk's
                 OutputPlay enum. if it's a positive number it's the number of milliseconds
                 we should wait until automatically trying to play the buffer again. */
+                long sampleRate = buffer->SampleRate();
                 int playResult = player->output->Play(buffer, player);
 
                 if (playResult == OutputBufferWritten) {
                     buffer = nullptr; /* reset so we pick up a new one next iteration */
+
+                    if (measureGap) {
+                        measureGap = false;
+                        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - player->playRequestedAt).count();
+                        transitionGapMetric.Record((uint64_t)(elapsed * sampleRate / 1000000));
+                    }
                 }
                 else {
                     /* if the buffer was unable to be processed, we'll try again after
                     sleepMs milliseconds */
                     int sleepMs = 1000; /* default */
 
+                    outputRetryMetric.Increment();
+
                     /* if the playResult value >= 0, that means the output requested a
                     specific callback time because its internal buffer is full. */
                     if (playResult >= 0) {
@@ -410,6 +469,7 @@ void musik::core::audio::playerThreadLoop(Player* player) {
                     /* we should never get here, but if for some reason we can't get the
                     next buffer, but we're not EOF, that means we need to wait for a short
                     while and try again... */
+                    underrunMetric.Increment();
                     std::unique_lock<std::mutex> lock(player->queueMutex);
                     player->writeToOutputCondition.wait_for(
                         lock, std::chrono::milliseconds(10));
@@ -556,6 +616,7 @@ void Player::OnBufferProcessed(IBuffer *buffer) {
         /* removes the specified buffer from the list of locked buffers, and also
         lets the stream know it can be recycled. */
         --pendingBufferCount;
+        pendingBuffersMetric.Add(-1);
         this->stream->OnBufferProcessedByPlayer((Buffer*)buffer);
 
         /* if we're seeking this value will be non-negative, so we shouldn't touch
@@ -46,6 +46,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 
 namespace musik { namespace core { namespace audio {
 
@@ -106,6 +107,7 @@ namespace musik { namespace core { namespace audio {
             friend void playerThreadLoop(Player* player);
 
             double GetPositionInternal();
+            double GetLatency();
 
             Player(
                 const std::string &url,
@@ -168,6 +170,9 @@ namespace musik { namespace core { namespace audio {
             DestroyMode destroyMode;
             Gain gain;
             int pendingBufferCount;
+            bool prepared;
+            bool warmStart;
+            std::chrono::steady_clock::time_point playRequestedAt;
 
             FftContext* fftContext;
     };
@@ -52,6 +52,8 @@ Stream::Stream(int samplesPerChannel, double bufferLengthSeconds, unsigned int o
 , samplesPerChannel(samplesPerChannel)
 , bufferLengthSeconds(bufferLengthSeconds)
 , bufferCount(0)
+, prerollBufferCount(0)
+, prerolled(false)
 , decoderSampleRate(0)
 , decoderChannels(0)
 , decoderPosition(0)
@@ -61,7 +63,11 @@ Stream::Stream(int samplesPerChannel, double bufferLengthSeconds, unsigned int o
 , capabilities(0)
 , rawBuffer(nullptr) {
     if ((this->options & NoDSP) == 0) {
-        streams::GetDspPlugins();
+        this->dspChain.reset(new DspChain(samplesPerChannel));
+
+        if (this->dspChain->Empty()) {
+            this->dspChain.reset();
+        }
     }
 
     this->decoderBuffer = new Buffer();
@@ -111,6 +117,10 @@ double Stream::GetDuration() {
     return this->decoder ? this->decoder->GetDuration() : -1.0f;
 }
 
+double Stream::GetLatency() {
+    return this->dspChain ? this->dspChain->Latency() : 0.0;
+}
+
 int Stream::GetCapabilities() {
     return this->capabilities;
 }
@@ -127,12 +137,19 @@ bool Stream::OpenStream(std::string uri) {
         return false;
     }
 
-    this->decoder = streams::GetDecoderForDataStream(this->dataStream);
+    /* NoDSP streams are only used to analyze tracks, never to play them */
+    DecodeIntent intent = (this->options & NoDSP)
+        ? DecodeIntent::Sequential : DecodeIntent::Playback;
+
+    this->decoder = streams::GetDecoderForDataStream(this->dataStream, intent);
 
     if (this->decoder) {
         if (this->dataStream->CanPrefetch()) {
+            /* open the decoder, probe the format and decode the first few
+            buffers now, while the previous track is still playing. */
             this->capabilities |= (int) musik::core::sdk::Capability::Prebuffer;
             this->RefillInternalBuffers();
+            this->prerolled = (this->filledBuffers.size() > 0);
         }
         return true;
     }
@@ -140,6 +157,10 @@ bool Stream::OpenStream(std::string uri) {
     return false;
 }
 
+void Stream::SetPrerollBufferCount(int count) {
+    this->prerollBufferCount = std::max(0, count);
+}
+
 void Stream::Interrupt() {
     if (this->dataStream) {
         this->dataStream->Interrupt();
@@ -189,15 +210,22 @@ inline Buffer* Stream::GetEmptyBuffer() {
 }
 
 Buffer* Stream::GetNextProcessedOutputBuffer() {
-    this->RefillInternalBuffers();
+    /* if we pre-rolled, hand the first buffer over right away instead of
+    decoding another chunk first; that's the transition the pre-roll is
+    supposed to make gapless. we'll catch up on the next call. */
+    if (!this->prerolled || this->filledBuffers.empty()) {
+        this->RefillInternalBuffers();
+    }
+
+    this->prerolled = false;
 
     /* in the normal case we have buffers available in the filled queue. */
     if (this->filledBuffers.size()) {
         Buffer* buffer = this->filledBuffers.front();
         this->filledBuffers.pop_front();
 
-        for (std::shared_ptr<IDSP> dsp : this->dsps) {
-            dsp->Process(buffer);
+        if (this->dspChain) {
+            this->dspChain->Process(buffer);
         }
 
         return buffer;
@@ -240,9 +268,11 @@ void Stream::RefillInternalBuffers() {
         }
 
         /* count will be < 0 on the very first pass through. let's try to
-        fill 1/4 of our buffers */
+        fill 1/4 of our buffers, or the configured pre-roll amount */
         if (count < 0) {
-            count = bufferCount / 4;
+            count = (this->prerollBufferCount > 0)
+                ? std::min(this->prerollBufferCount, bufferCount - 1)
+                : bufferCount / 4;
         }
 
         /* we're going to write to this guy... */
@@ -39,7 +39,7 @@
 #include <core/audio/Buffer.h>
 #include <core/audio/IStream.h>
 #include <core/sdk/IDecoder.h>
-#include <core/sdk/IDSP.h>
+#include <core/audio/DspChain.h>
 
 #include <boost/shared_ptr.hpp>
 #include <list>
@@ -47,7 +47,6 @@
 namespace musik { namespace core { namespace audio {
 
     class Stream : public IStream {
-        using IDSP = musik::core::sdk::IDSP;
         using IDecoder = musik::core::sdk::IDecoder;
 
         public:
@@ -67,8 +66,10 @@ namespace musik { namespace core { namespace audio {
             virtual double SetPosition(double seconds) override;
             virtual double GetDuration() override;
             virtual bool OpenStream(std::string uri) override;
+            virtual void SetPrerollBufferCount(int count) override;
             virtual void Interrupt() override;
             virtual int GetCapabilities() override;
+            virtual double GetLatency() override;
             virtual bool Eof() override { return this->done; }
 
         private:
@@ -78,8 +79,6 @@ namespace musik { namespace core { namespace audio {
 
             typedef std::deque<Buffer*> BufferList;
             typedef std::shared_ptr<IDecoder> DecoderPtr;
-            typedef std::shared_ptr<IDSP> DspPtr;
-            typedef std::vector<DspPtr> Dsps;
 
             long decoderSampleRate;
             long decoderChannels;
@@ -98,6 +97,8 @@ namespace musik { namespace core { namespace audio {
             int samplesPerChannel;
             long samplesPerBuffer;
             int bufferCount;
+            int prerollBufferCount;
+            bool prerolled;
             bool done;
             double bufferLengthSeconds;
             int capabilities;
@@ -105,7 +106,7 @@ namespace musik { namespace core { namespace audio {
             float* rawBuffer;
 
             DecoderPtr decoder;
-            Dsps dsps;
+            std::unique_ptr<DspChain> dspChain;
     };
 
 } } }
@@ -51,6 +51,7 @@ using DataStreamPtr = musik::core::io::DataStreamFactory::DataStreamPtr;
 using DecoderFactoryList = std::vector<std::shared_ptr<IDecoderFactory>>;
 using EncoderFactoryList = std::vector<std::shared_ptr<IEncoderFactory>>;
 using DspList = std::vector<std::shared_ptr<IDSP>>;
+using BlockDspList = std::vector<std::shared_ptr<IBlockDSP>>;
 using Deleter = PluginFactory::ReleaseDeleter<IDecoder>;
 using DecoderPtr = std::shared_ptr<IDecoder>;
 
@@ -79,7 +80,7 @@ static void init() {
 namespace musik { namespace core { namespace audio {
 
     namespace streams {
-        IDecoder* GetDecoderForDataStream(IDataStream* dataStream) {
+        IDecoder* GetDecoderForDataStream(IDataStream* dataStream, DecodeIntent intent) {
             init();
 
             IDecoder* decoder = nullptr;
@@ -110,6 +111,8 @@ namespace musik { namespace core { namespace audio {
                 return nullptr;
             }
 
+            decoder->SetIntent(intent);
+
             /* ask the decoder to open the data stream. if it returns true we're
             good to start pulling data out of it! */
             if (!decoder->Open(dataStream)) {
@@ -135,8 +138,8 @@ namespace musik { namespace core { namespace audio {
             return nullptr;
         }
 
-        std::shared_ptr<IDecoder> GetDecoderForDataStream(DataStreamPtr dataStream) {
-            auto decoder = GetDecoderForDataStream(dataStream.get());
+        std::shared_ptr<IDecoder> GetDecoderForDataStream(DataStreamPtr dataStream, DecodeIntent intent) {
+            auto decoder = GetDecoderForDataStream(dataStream.get(), intent);
             return decoder ? DecoderPtr(decoder, Deleter()) : DecoderPtr();
         }
 
@@ -144,6 +147,11 @@ namespace musik { namespace core { namespace audio {
             typedef PluginFactory::ReleaseDeleter<IDSP> Deleter;
             return PluginFactory::Instance().QueryInterface<IDSP, Deleter>("GetDSP");
         }
+
+        BlockDspList GetBlockDspPlugins() {
+            typedef PluginFactory::ReleaseDeleter<IBlockDSP> Deleter;
+            return PluginFactory::Instance().QueryInterface<IBlockDSP, Deleter>("GetBlockDSP");
+        }
     };
 
 } } }
\ No newline at end of file
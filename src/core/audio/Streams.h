@@ -39,6 +39,7 @@
 #include <core/sdk/IDecoder.h>
 #include <core/sdk/IEncoder.h>
 #include <core/sdk/IDSP.h>
+#include <core/sdk/IBlockDSP.h>
 #include <core/sdk/IDecoderFactory.h>
 
 #include <memory>
@@ -48,14 +49,20 @@ namespace musik { namespace core { namespace audio {
 
     namespace streams {
         std::shared_ptr<musik::core::sdk::IDecoder>
-            GetDecoderForDataStream(musik::core::io::DataStreamFactory::DataStreamPtr dataStream);
+            GetDecoderForDataStream(
+                musik::core::io::DataStreamFactory::DataStreamPtr dataStream,
+                musik::core::sdk::DecodeIntent intent = musik::core::sdk::DecodeIntent::Playback);
 
         musik::core::sdk::IDecoder*
-            GetDecoderForDataStream(musik::core::sdk::IDataStream* stream);
+            GetDecoderForDataStream(
+                musik::core::sdk::IDataStream* stream,
+                musik::core::sdk::DecodeIntent intent = musik::core::sdk::DecodeIntent::Playback);
 
         musik::core::sdk::IEncoder* GetEncoderForType(const char* type);
 
         std::vector<std::shared_ptr<musik::core::sdk::IDSP > > GetDspPlugins();
+
+        std::vector<std::shared_ptr<musik::core::sdk::IBlockDSP > > GetBlockDspPlugins();
     };
 
 } } }
@@ -41,13 +41,16 @@
 #include <core/library/track/IndexerTrack.h>
 #include <core/library/track/LibraryTrack.h>
 #include <core/library/LocalLibraryConstants.h>
+#include <core/library/LocalLibrary.h>
 #include <core/db/Connection.h>
 #include <core/db/Statement.h>
 #include <core/plugin/PluginFactory.h>
 #include <core/support/Common.h>
+#include <core/support/Metrics.h>
 #include <core/support/Preferences.h>
 #include <core/support/PreferenceKeys.h>
 #include <core/sdk/IAnalyzer.h>
+#include <core/sdk/IPlugin.h>
 #include <core/sdk/IIndexerSource.h>
 #include <core/audio/Stream.h>
 
@@ -57,12 +60,16 @@
 #include <boost/bind.hpp>
 
 #include <atomic>
+#include <condition_variable>
+#include <map>
+#include <unordered_set>
 
 #define MULTI_THREADED_INDEXER 1
 #define STRESS_TEST_DB 0
 
 static const std::string TAG = "Indexer";
 static const size_t TRANSACTION_INTERVAL = 300;
+static const size_t ANALYZER_BATCH_SIZE = 64;
 static FILE* logFile = nullptr;
 
 #ifdef __arm__
@@ -78,6 +85,26 @@ using namespace musik::core::library;
 
 using Thread = std::unique_ptr<boost::thread>;
 
+static metrics::Counter& filesScannedMetric = metrics::GetCounter(
+    "musikcube_indexer_files_scanned_total",
+    "files examined by the indexer");
+
+static metrics::Counter& filesSavedMetric = metrics::GetCounter(
+    "musikcube_indexer_files_saved_total",
+    "files whose metadata was (re)written by the indexer");
+
+static metrics::Gauge& filesPerSecondMetric = metrics::GetGauge(
+    "musikcube_indexer_files_per_second",
+    "files scanned per second during the most recent sync");
+
+static metrics::Histogram& commitLatencyMetric = metrics::GetHistogram(
+    "musikcube_indexer_commit_duration_microseconds",
+    "time spent committing indexer transactions");
+
+static metrics::Histogram& syncDurationMetric = metrics::GetHistogram(
+    "musikcube_indexer_sync_duration_microseconds",
+    "wall time of complete indexer syncs");
+
 using TagReaderDestroyer = PluginFactory::ReleaseDeleter<ITagReader>;
 using DecoderDeleter = PluginFactory::ReleaseDeleter<IDecoderFactory>;
 using SourceDeleter = PluginFactory::ReleaseDeleter<IIndexerSource>;
@@ -404,6 +431,7 @@ void Indexer::ReadMetadataFromFile(
         if (saveToDb) {
             track.SetValue("path_id", pathId.c_str());
             track.Save(this->dbConnection, this->libraryPath);
+            filesSavedMetric.Increment();
 
 #if STRESS_TEST_DB != 0
             #define INC(track, key, x) \
@@ -442,9 +470,13 @@ inline void Indexer::IncrementTracksScanned(size_t delta) {
     std::unique_lock<std::mutex> lock(IndexerTrack::sharedWriteMutex);
 
     this->tracksScanned.fetch_add(delta);
+    filesScannedMetric.Increment(delta);
 
     if (this->tracksScanned > TRANSACTION_INTERVAL) {
-        this->trackTransaction->CommitAndRestart();
+        {
+            metrics::ScopedTimer timer(commitLatencyMetric);
+            this->trackTransaction->CommitAndRestart();
+        }
         this->Progress(this->tracksScanned);
         this->tracksScanned = 0;
     }
@@ -574,6 +606,9 @@ void Indexer::ThreadLoop() {
         this->state = StateIndexing;
         this->Started();
 
+        auto syncStart = std::chrono::steady_clock::now();
+        uint64_t filesScannedAtStart = filesScannedMetric.Value();
+
         this->dbConnection.Open(this->dbFilename.c_str(), 0);
         this->trackTransaction.reset(new db::ScopedTransaction(this->dbConnection));
 
@@ -604,6 +639,16 @@ void Indexer::ThreadLoop() {
 
         this->dbConnection.Close();
 
+        auto syncMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - syncStart).count();
+
+        syncDurationMetric.Record((uint64_t) syncMicros);
+
+        if (syncMicros > 0) {
+            uint64_t files = filesScannedMetric.Value() - filesScannedAtStart;
+            filesPerSecondMetric.Set((int64_t) ((files * 1000000) / (uint64_t) syncMicros));
+        }
+
         if (!this->Exited()) {
             this->Finished(this->tracksScanned);
         }
@@ -667,9 +712,14 @@ void Indexer::SyncCleanup() {
     this->dbConnection.Execute("DELETE FROM meta_values WHERE id NOT IN (SELECT DISTINCT(meta_value_id) FROM track_meta)");
     this->dbConnection.Execute("DELETE FROM meta_keys WHERE id NOT IN (SELECT DISTINCT(meta_key_id) FROM meta_values)");
 
-    /* orphaned replay gain and directories */
+    /* orphaned replay gain */
     this->dbConnection.Execute("DELETE FROM replay_gain WHERE track_id NOT IN (SELECT id FROM tracks)");
-    this->dbConnection.Execute("DELETE FROM directories WHERE id NOT IN (SELECT DISTINCT directory_id FROM tracks)");
+
+    /* orphaned analyzer state */
+    this->dbConnection.Execute("DELETE FROM analyzed_tracks WHERE track_id NOT IN (SELECT id FROM tracks)");
+
+    /* refresh per-directory track counts, and remove empty directories */
+    LocalLibrary::UpdateDirectoryTree(this->dbConnection);
 
     /* NOTE: we used to remove orphaned local library tracks here, but we don't anymore because
     the indexer generates stable external ids by hashing various file and metadata fields */
@@ -810,103 +860,328 @@ void Indexer::ProcessAddRemoveQueue() {
     }
 }
 
-void Indexer::RunAnalyzers() {
-    typedef sdk::IAnalyzer PluginType;
-    typedef PluginFactory::ReleaseDeleter<PluginType> Deleter;
-    typedef std::shared_ptr<PluginType> PluginPtr;
-    typedef std::vector<PluginPtr> PluginVector;
+namespace {
+    /* an analyzer plugin, and the version recorded for the tracks it has
+    processed. */
+    struct Analyzer {
+        std::string name;
+        std::string version;
+    };
 
-    /* short circuit if there aren't any analyzers */
+    using AnalyzerPtr = std::shared_ptr<Analyzer>;
 
-    PluginVector analyzers = PluginFactory::Instance()
-        .QueryInterface<PluginType, Deleter>("GetAudioAnalyzer");
+    /* one instance of each analyzer plugin, by name */
+    using AnalyzerInstances = std::map<std::string, std::shared_ptr<IAnalyzer>>;
 
-    if (analyzers.empty()) {
+    AnalyzerInstances createAnalyzerInstances() {
+        AnalyzerInstances result;
+
+        PluginFactory::Instance().QueryInterface<IAnalyzer, PluginFactory::ReleaseDeleter<IAnalyzer>>(
+            "GetAudioAnalyzer",
+            [&result](std::shared_ptr<IAnalyzer> plugin, const std::string& fn) {
+                result[boost::filesystem::path(fn).filename().string()] = plugin;
+            });
+
+        return result;
+    }
+
+    /* each pool worker checks out its own set of analyzer instances for
+    the duration of a track, so an instance only ever processes one track
+    at a time, from Start() through End(); see IAnalyzer.h. sets are created
+    on demand, so there are never more than there are workers. */
+    class AnalyzerInstancePool {
+        public:
+            AnalyzerInstances Acquire() {
+                {
+                    std::unique_lock<std::mutex> lock(this->mutex);
+                    if (!this->available.empty()) {
+                        AnalyzerInstances result = std::move(this->available.back());
+                        this->available.pop_back();
+                        return result;
+                    }
+                }
+
+                return createAnalyzerInstances();
+            }
+
+            void Release(AnalyzerInstances&& instances) {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->available.push_back(std::move(instances));
+            }
+
+        private:
+            std::mutex mutex;
+            std::vector<AnalyzerInstances> available;
+    };
+
+    struct AnalyzerJob {
+        std::shared_ptr<IndexerTrack> track;
+        std::vector<AnalyzerPtr> analyzers;
+        std::vector<AnalyzerPtr> finished; /* declined, or End() succeeded */
+        int64_t filetime;
+        bool completed;
+        bool save;
+    };
+
+    using AnalyzerJobPtr = std::shared_ptr<AnalyzerJob>;
+}
+
+static std::string analyzedKey(int64_t id, int64_t filetime, Analyzer& analyzer) {
+    return std::to_string(id) + "\t" + std::to_string(filetime) + "\t" +
+        analyzer.name + "\t" + analyzer.version;
+}
+
+static void analyzeTrack(
+    AnalyzerJob& job, AnalyzerInstances& instances, std::function<bool()> exited)
+{
+    using Running = std::pair<AnalyzerPtr, std::shared_ptr<IAnalyzer>>;
+
+    TagStore* store = new TagStore(job.track);
+
+    std::vector<Running> started;
+    for (auto analyzer : job.analyzers) {
+        auto instance = instances.find(analyzer->name);
+        if (instance != instances.end()) {
+            if (instance->second->Start(store)) {
+                started.push_back({ analyzer, instance->second });
+            }
+            else {
+                job.finished.push_back(analyzer); /* not interested */
+            }
+        }
+    }
+
+    if (started.empty()) {
+        /* nobody was interested in this track */
+        job.completed = true;
+        store->Release();
         return;
     }
 
-    /* for each track... */
+    auto stream = audio::Stream::Create(2048, 5.0, audio::IStream::NoDSP);
 
-    int64_t trackId = 0;
+    bool opened = stream && stream->OpenStream(job.track->Uri());
+    bool interrupted = false;
 
-    db::Statement getNextTrack(
-        "SELECT id FROM tracks WHERE id>? ORDER BY id LIMIT 1",
-        this->dbConnection);
+    if (opened) {
+        /* decode the stream quickly, passing to all analyzers */
+        std::vector<Running> running = started;
+        audio::Buffer* buffer;
 
-    getNextTrack.BindInt64(0, trackId);
+        while (!running.empty() && (buffer = stream->GetNextProcessedOutputBuffer())) {
+            auto it = running.begin();
+            while (it != running.end()) {
+                if (it->second->Analyze(store, buffer)) {
+                    ++it;
+                }
+                else {
+                    it = running.erase(it);
+                }
+            }
 
-    while(getNextTrack.Step() == db::Row ) {
-        trackId = getNextTrack.ColumnInt64(0);
+            stream->OnBufferProcessedByPlayer(buffer);
 
-        getNextTrack.ResetAndUnbind();
+            if (exited()) {
+                interrupted = true;
+                break;
+            }
+        }
+    }
 
-        IndexerTrack track(trackId);
+    /* done with track decoding and analysis, let the plugins know. only
+    the ones that succeeded are recorded as having analyzed the track; the
+    others will be retried next time. */
+    int successPlugins = 0;
+    for (auto& analyzer : started) {
+        if (analyzer.second->End(store)) {
+            job.finished.push_back(analyzer.first);
+            ++successPlugins;
+        }
+    }
 
-        if (LibraryTrack::Load(&track, this->dbConnection)) {
-            PluginVector runningAnalyzers;
+    /* the analyzers can write metadata back to the DB, so if any of them
+    completed successfully, then the track will be saved. tracks that we
+    couldn't open, or whose analysis was interrupted, will be retried during
+    the next run. */
+    job.save = opened && !interrupted && successPlugins > 0;
+    job.completed = opened && !interrupted;
 
-            TagStore* store = new TagStore(track);
-            PluginVector::iterator plugin = analyzers.begin();
-            for ( ; plugin != analyzers.end(); ++plugin) {
-                if ((*plugin)->Start(store)) {
-                    runningAnalyzers.push_back(*plugin);
+    store->Release();
+}
+
+void Indexer::RunAnalyzers() {
+    /* short circuit if there aren't any analyzers. the instances we query
+    for here become the first set in the pool. */
+
+    AnalyzerInstancePool instancePool;
+    AnalyzerInstances instances = createAnalyzerInstances();
+
+    std::vector<AnalyzerPtr> analyzers;
+    for (auto& instance : instances) {
+        auto analyzer = std::make_shared<Analyzer>();
+        analyzer->name = instance.first;
+        analyzers.push_back(analyzer);
+    }
+
+    if (analyzers.empty()) {
+        return;
+    }
+
+    instancePool.Release(std::move(instances));
+
+    /* tracks are re-analyzed if the plugin that analyzed them is updated */
+
+    PluginFactory::Instance().QueryInterface<IPlugin, PluginFactory::NullDeleter<IPlugin>>(
+        "GetPlugin",
+        [&analyzers](std::shared_ptr<IPlugin> plugin, const std::string& fn) {
+            std::string name = boost::filesystem::path(fn).filename().string();
+            for (auto analyzer : analyzers) {
+                if (analyzer->name == name) {
+                    analyzer->version = std::string(plugin->Name()) + " " + plugin->Version();
                 }
             }
+        });
 
-            if (!runningAnalyzers.empty()) {
-                audio::IStreamPtr stream = audio::Stream::Create(audio::IStream::NoDSP);
+    /* decoding is the expensive part, so do it on a pool with one thread
+    per core. */
 
-                if (stream) {
-                    if (stream->OpenStream(track.Uri())) {
+    boost::asio::io_service io;
+    boost::thread_group threadPool;
+    std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(io));
 
-                        /* decode the stream quickly, passing to all analyzers */
+    int threadCount = std::max(1, (int) boost::thread::hardware_concurrency());
+    for (int i = 0; i < threadCount; i++) {
+        threadPool.create_thread(boost::bind(&boost::asio::io_service::run, &io));
+    }
 
-                        audio::Buffer* buffer;
+    auto exited = [this]() { return this->Exited(); };
 
-                        while ((buffer = stream->GetNextProcessedOutputBuffer()) && !runningAnalyzers.empty()) {
-                            PluginVector::iterator plugin = runningAnalyzers.begin();
-                            while(plugin != runningAnalyzers.end()) {
-                                if ((*plugin)->Analyze(store, buffer)) {
-                                    ++plugin;
-                                }
-                                else {
-                                    plugin = runningAnalyzers.erase(plugin);
-                                }
-                            }
-                        }
+    db::Statement nextBatch(
+        "SELECT id, filetime FROM tracks WHERE id>? ORDER BY id LIMIT ?",
+        this->dbConnection);
 
-                        /* done with track decoding and analysis, let the plugins know */
+    db::Statement getAnalyzed(
+        "SELECT track_id, filetime, analyzer, version FROM analyzed_tracks "
+        "WHERE track_id>=? AND track_id<=?",
+        this->dbConnection);
 
-                        int successPlugins = 0;
-                        PluginVector::iterator plugin = analyzers.begin();
+    db::Statement markAnalyzed(
+        "INSERT OR REPLACE INTO analyzed_tracks (track_id, analyzer, version, filetime) "
+        "VALUES (?, ?, ?, ?)",
+        this->dbConnection);
 
-                        for ( ; plugin != analyzers.end(); ++plugin) {
-                            if ((*plugin)->End(store)) {
-                                successPlugins++;
-                            }
-                        }
+    int64_t lastId = 0;
 
-                        /* the analyzers can write metadata back to the DB, so if any of them
-                        completed successfully, then save the track. */
+    while (!this->Exited()) {
+        /* the next batch of tracks... */
 
-                        if (successPlugins>0) {
-                            track.Save(this->dbConnection, this->libraryPath);
-                        }
-                    }
+        std::vector<std::pair<int64_t, int64_t>> batch;
+
+        nextBatch.ResetAndUnbind();
+        nextBatch.BindInt64(0, lastId);
+        nextBatch.BindInt32(1, (int) ANALYZER_BATCH_SIZE);
+        while (nextBatch.Step() == db::Row) {
+            batch.push_back({ nextBatch.ColumnInt64(0), nextBatch.ColumnInt64(1) });
+        }
+
+        if (batch.empty()) {
+            break;
+        }
+
+        /* ...and which of them have already been analyzed, by which plugin
+        version, and at which file time. */
+
+        std::unordered_set<std::string> analyzed;
+
+        getAnalyzed.ResetAndUnbind();
+        getAnalyzed.BindInt64(0, batch.front().first);
+        getAnalyzed.BindInt64(1, batch.back().first);
+        while (getAnalyzed.Step() == db::Row) {
+            analyzed.insert(
+                std::to_string(getAnalyzed.ColumnInt64(0)) + "\t" +
+                std::to_string(getAnalyzed.ColumnInt64(1)) + "\t" +
+                getAnalyzed.ColumnText(2) + "\t" +
+                getAnalyzed.ColumnText(3));
+        }
+
+        lastId = batch.back().first;
+
+        std::vector<AnalyzerJobPtr> jobs;
+
+        for (auto& entry : batch) {
+            auto job = std::make_shared<AnalyzerJob>();
+            job->filetime = entry.second;
+            job->completed = job->save = false;
+
+            for (auto analyzer : analyzers) {
+                if (analyzed.find(analyzedKey(entry.first, entry.second, *analyzer)) == analyzed.end()) {
+                    job->analyzers.push_back(analyzer);
                 }
             }
 
-            if (store) {
-                store->Release();
+            if (!job->analyzers.empty()) {
+                job->track = std::make_shared<IndexerTrack>(entry.first);
+                if (LibraryTrack::Load(job->track.get(), this->dbConnection)) {
+                    jobs.push_back(job);
+                }
             }
         }
 
-        if (this->Exited()) {
-            return;
+        /* fan the batch out to the pool and wait for all of it */
+
+        std::mutex batchMutex;
+        std::condition_variable batchFinished;
+        size_t remaining = jobs.size();
+
+        for (auto job : jobs) {
+            io.post([job, exited, &instancePool, &batchMutex, &batchFinished, &remaining]() {
+                AnalyzerInstances instances = instancePool.Acquire();
+                analyzeTrack(*job, instances, exited);
+                instancePool.Release(std::move(instances));
+
+                std::unique_lock<std::mutex> lock(batchMutex);
+                if (--remaining == 0) {
+                    batchFinished.notify_all();
+                }
+            });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(batchMutex);
+            while (remaining > 0) {
+                batchFinished.wait(lock);
+            }
         }
 
-        getNextTrack.BindInt64(0, trackId);
+        /* write results back, and record what was analyzed so we don't
+        have to do it again. */
+
+        for (auto job : jobs) {
+            if (job->save) {
+                job->track->Save(this->dbConnection, this->libraryPath);
+            }
+
+            if (job->completed) {
+                for (auto analyzer : job->finished) {
+                    markAnalyzed.Reset();
+                    markAnalyzed.BindInt64(0, job->track->GetId());
+                    markAnalyzed.BindText(1, analyzer->name);
+                    markAnalyzed.BindText(2, analyzer->version);
+                    markAnalyzed.BindInt64(3, job->filetime);
+                    markAnalyzed.Step();
+                }
+            }
+        }
+
+        {
+            metrics::ScopedTimer timer(commitLatencyMetric);
+            this->trackTransaction->CommitAndRestart();
+        }
     }
+
+    work.reset();
+    io.stop();
+    threadPool.join_all();
 }
 
 bool Indexer::Exited() {
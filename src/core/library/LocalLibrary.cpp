@@ -38,19 +38,48 @@
 #include <core/config.h>
 #include <core/library/query/local/LocalQueryBase.h>
 #include <core/support/Common.h>
+#include <core/support/Metrics.h>
 #include <core/support/Preferences.h>
 #include <core/library/Indexer.h>
+#include <core/db/ScopedTransaction.h>
 #include <core/runtime/Message.h>
 #include <core/debug.h>
 
+#include <boost/filesystem.hpp>
+#include <unordered_map>
+
 static const std::string TAG = "LocalLibrary";
 static bool scheduleSyncDueToDbUpgrade = false;
 
+static musik::core::metrics::Gauge& queryQueueDepth = musik::core::metrics::GetGauge(
+    "musikcube_library_query_queue_depth",
+    "number of asynchronous library queries waiting to run");
+
+/* GetHistogram() takes the registry lock and builds a label map, which is
+too much to do for every query. histograms live for the lifetime of the
+process, so each thread that runs queries keeps its own lookup by name. */
+static musik::core::metrics::Histogram& queryDurationHistogram(const std::string& name) {
+    static thread_local std::unordered_map<std::string, musik::core::metrics::Histogram*> cache;
+
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        return *it->second;
+    }
+
+    auto& histogram = musik::core::metrics::GetHistogram(
+        "musikcube_library_query_duration_microseconds",
+        "time spent running library queries, by query type",
+        { { "query", name } });
+
+    cache[name] = &histogram;
+    return histogram;
+}
+
 using namespace musik::core;
 using namespace musik::core::library;
 using namespace musik::core::runtime;
 
-#define DATABASE_VERSION 8
+#define DATABASE_VERSION 10
 #define VERBOSE_LOGGING 0
 #define MESSAGE_QUERY_COMPLETED 5000
 
@@ -174,6 +203,7 @@ int LocalLibrary::Enqueue(QueryPtr query, unsigned int options, Callback callbac
         }
         else {
             queryQueue.push_back(context);
+            queryQueueDepth.Set((int64_t) queryQueue.size());
             queueCondition.notify_all();
 
             if (VERBOSE_LOGGING) {
@@ -200,6 +230,7 @@ LocalLibrary::QueryContextPtr LocalLibrary::GetNextQuery() {
     else {
         auto front = queryQueue.front();
         queryQueue.pop_front();
+        queryQueueDepth.Set((int64_t) queryQueue.size());
         return front;
     }
 }
@@ -221,7 +252,11 @@ void LocalLibrary::RunQuery(QueryContextPtr context, bool notify) {
             musik::debug::info(TAG, "query '" + query->Name() + "' running");
         }
 
-        query->Run(this->db);
+        {
+            metrics::ScopedTimer timer(queryDurationHistogram(query->Name()));
+
+            query->Run(this->db);
+        }
 
         if (notify) {
             if (this->messageQueue) {
@@ -347,6 +382,21 @@ static void upgradeV7ToV8(db::Connection& db) {
     scheduleSyncDueToDbUpgrade = true;
 }
 
+static void upgradeV8ToV9(db::Connection& db) {
+    db.Execute("ALTER TABLE directories ADD COLUMN parent_id INTEGER DEFAULT 0");
+    db.Execute("ALTER TABLE directories ADD COLUMN track_count INTEGER DEFAULT 0");
+    db.Execute("UPDATE directories SET parent_id=0 WHERE parent_id IS NULL");
+    db.Execute("CREATE INDEX IF NOT EXISTS directories_index1 ON directories (name)");
+    LocalLibrary::UpdateDirectoryTree(db);
+}
+
+static void upgradeV9ToV10(db::Connection& db) {
+    /* thumbnail checksums used to be a byte sum, and can't be compared with
+    the new content hash. zero means "unknown"; IndexerTrack recomputes them
+    lazily, from the file on disk, the next time it sees art of that size. */
+    db.Execute("UPDATE thumbnails SET checksum=0");
+}
+
 static void setVersion(db::Connection& db, int version) {
     db.Execute("DELETE FROM version");
 
@@ -445,7 +495,9 @@ void LocalLibrary::CreateDatabase(db::Connection &db){
     db.Execute(
         "CREATE TABLE IF NOT EXISTS directories ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT NOT NULL)");
+        "name TEXT NOT NULL,"
+        "parent_id INTEGER DEFAULT 0,"
+        "track_count INTEGER DEFAULT 0)");
 
     /* thumbnails */
     db.Execute(
@@ -554,6 +606,24 @@ void LocalLibrary::CreateDatabase(db::Connection &db){
             "id INTEGER PRIMARY KEY AUTOINCREMENT, "
             "track_id INTEGER)");
 
+    /* edits made to the play queue since last_session_play_queue was written */
+    db.Execute(
+        "CREATE TABLE IF NOT EXISTS last_session_play_queue_journal ( "
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "type INTEGER, "
+            "track_id INTEGER, "
+            "from_index INTEGER, "
+            "to_index INTEGER)");
+
+    /* which analyzer plugins (and versions) have processed which tracks */
+    db.Execute(
+        "CREATE TABLE IF NOT EXISTS analyzed_tracks ( "
+            "track_id INTEGER, "
+            "analyzer TEXT, "
+            "version TEXT, "
+            "filetime INTEGER, "
+            "PRIMARY KEY (track_id, analyzer))");
+
     /* upgrade playlist tracks table */
     if (lastVersion == 1) {
         upgradeV1toV2(db);
@@ -583,6 +653,14 @@ void LocalLibrary::CreateDatabase(db::Connection &db){
         upgradeV7ToV8(db);
     }
 
+    if (lastVersion >= 1 && lastVersion < 9) {
+        upgradeV8ToV9(db);
+    }
+
+    if (lastVersion >= 1 && lastVersion < 10) {
+        upgradeV9ToV10(db);
+    }
+
     /* ensure our version is set correctly */
     setVersion(db, DATABASE_VERSION);
 
@@ -596,6 +674,7 @@ void LocalLibrary::DropIndexes(db::Connection &db) {
     db.Execute("DROP INDEX IF EXISTS artist_index");
     db.Execute("DROP INDEX IF EXISTS album_index");
     db.Execute("DROP INDEX IF EXISTS thumbnail_index");
+    db.Execute("DROP INDEX IF EXISTS thumbnail_index2");
 
     db.Execute("DROP INDEX IF EXISTS trackgenre_index1");
     db.Execute("DROP INDEX IF EXISTS trackgenre_index2");
@@ -607,6 +686,10 @@ void LocalLibrary::DropIndexes(db::Connection &db) {
     db.Execute("DROP INDEX IF EXISTS metavalues_index1");
 
     db.Execute("DROP INDEX IF EXISTS tracks_external_id_index");
+    db.Execute("DROP INDEX IF EXISTS tracks_directory_id_index");
+
+    db.Execute("DROP INDEX IF EXISTS directories_index1");
+    db.Execute("DROP INDEX IF EXISTS directories_index2");
 
     db.Execute("DROP INDEX IF EXISTS playlist_tracks_index_1");
     db.Execute("DROP INDEX IF EXISTS playlist_tracks_index_2");
@@ -620,6 +703,7 @@ void LocalLibrary::CreateIndexes(db::Connection &db) {
     db.Execute("CREATE INDEX IF NOT EXISTS artist_index ON artists (sort_order)");
     db.Execute("CREATE INDEX IF NOT EXISTS album_index ON albums (sort_order)");
     db.Execute("CREATE INDEX IF NOT EXISTS thumbnail_index ON thumbnails (filesize)");
+    db.Execute("CREATE INDEX IF NOT EXISTS thumbnail_index2 ON thumbnails (filesize, checksum)");
 
     db.Execute("CREATE INDEX IF NOT EXISTS trackgenre_index1 ON track_genres (track_id,genre_id)");
     db.Execute("CREATE INDEX IF NOT EXISTS trackgenre_index2 ON track_genres (genre_id,track_id)");
@@ -635,6 +719,10 @@ void LocalLibrary::CreateIndexes(db::Connection &db) {
     db.Execute("CREATE INDEX IF NOT EXISTS metavalues_index4 ON meta_values (id, content)");
 
     db.Execute("CREATE INDEX IF NOT EXISTS tracks_external_id_index ON tracks (external_id)");
+    db.Execute("CREATE INDEX IF NOT EXISTS tracks_directory_id_index ON tracks (directory_id)");
+
+    db.Execute("CREATE INDEX IF NOT EXISTS directories_index1 ON directories (name)");
+    db.Execute("CREATE INDEX IF NOT EXISTS directories_index2 ON directories (parent_id, track_count)");
 
     db.Execute("CREATE INDEX IF NOT EXISTS playlist_tracks_index_1 ON playlist_tracks (track_external_id,playlist_id,sort_order)");
     db.Execute("CREATE INDEX IF NOT EXISTS playlist_tracks_index_2 ON playlist_tracks (track_external_id,sort_order)");
@@ -646,4 +734,129 @@ void LocalLibrary::InvalidateTrackMetadata(db::Connection& db) {
     db.Execute("DELETE FROM track_meta;");
     db.Execute("DELETE FROM meta_keys;");
     db.Execute("DELETE FROM meta_values;");
-}
\ No newline at end of file
+}
+
+static std::string parentDirectory(const std::string& directory) {
+    /* directories are stored normalized, with a trailing separator. strip
+    it so boost gives us the real parent, then normalize the result. the
+    filesystem root has no parent. */
+    std::string path = directory;
+    while (path.size() && (path.back() == '/' || path.back() == '\\')) {
+        path.pop_back();
+    }
+
+    std::string parent = boost::filesystem::path(path).parent_path().string();
+    if (!parent.size() || parent == path) {
+        return "";
+    }
+
+    return NormalizeDir(parent);
+}
+
+int64_t LocalLibrary::SaveDirectory(db::Connection& db, const std::string& directory) {
+    {
+        db::Statement find("SELECT id FROM directories WHERE name=?", db);
+        find.BindText(0, directory);
+        if (find.Step() == db::Row) {
+            return find.ColumnInt64(0);
+        }
+    }
+
+    /* new directory: make sure its ancestors exist first, so the hierarchy
+    can always be walked from any indexed root. */
+    int64_t parentId = 0;
+    std::string parent = parentDirectory(directory);
+    if (parent.size()) {
+        parentId = std::max((int64_t) 0, SaveDirectory(db, parent));
+    }
+
+    db::Statement insert("INSERT INTO directories (name, parent_id) VALUES (?, ?)", db);
+    insert.BindText(0, directory);
+    insert.BindInt64(1, parentId);
+
+    if (insert.Step() == db::Done) {
+        return db.LastInsertedId();
+    }
+
+    return -1;
+}
+
+void LocalLibrary::UpdateDirectoryTree(db::Connection& db) {
+    db::ScopedTransaction transaction(db);
+
+    /* link any directories that don't have a parent yet (e.g. rows that
+    predate the hierarchy). real roots will simply resolve to no parent. */
+    {
+        std::vector<std::pair<int64_t, std::string>> unlinked;
+
+        {
+            db::Statement stmt("SELECT id, name FROM directories WHERE parent_id=0", db);
+            while (stmt.Step() == db::Row) {
+                unlinked.push_back({ stmt.ColumnInt64(0), stmt.ColumnText(1) });
+            }
+        }
+
+        db::Statement update("UPDATE directories SET parent_id=? WHERE id=?", db);
+
+        for (auto& entry : unlinked) {
+            std::string parent = parentDirectory(entry.second);
+            if (parent.size()) {
+                int64_t parentId = SaveDirectory(db, parent);
+                if (parentId > 0 && parentId != entry.first) {
+                    update.Reset();
+                    update.BindInt64(0, parentId);
+                    update.BindInt64(1, entry.first);
+                    update.Step();
+                }
+            }
+        }
+    }
+
+    /* recalculate the number of tracks contained in each directory and all
+    of its descendants, by adding each directory's own tracks to every one
+    of its ancestors. */
+    struct Node { int64_t parentId, oldCount, newCount; };
+    std::unordered_map<int64_t, Node> nodes;
+
+    {
+        db::Statement stmt("SELECT id, parent_id, track_count FROM directories", db);
+        while (stmt.Step() == db::Row) {
+            nodes[stmt.ColumnInt64(0)] = { stmt.ColumnInt64(1), stmt.ColumnInt64(2), 0 };
+        }
+    }
+
+    {
+        db::Statement stmt(
+            "SELECT directory_id, COUNT(*) FROM tracks "
+            "WHERE directory_id IS NOT NULL "
+            "GROUP BY directory_id",
+            db);
+
+        while (stmt.Step() == db::Row) {
+            int64_t count = stmt.ColumnInt64(1);
+            auto it = nodes.find(stmt.ColumnInt64(0));
+
+            /* the depth guard protects against a (corrupt) cycle */
+            for (size_t depth = 0; it != nodes.end() && depth < 1024; depth++) {
+                it->second.newCount += count;
+                it = nodes.find(it->second.parentId);
+            }
+        }
+    }
+
+    {
+        db::Statement update("UPDATE directories SET track_count=? WHERE id=?", db);
+
+        for (auto& entry : nodes) {
+            if (entry.second.newCount != entry.second.oldCount) {
+                update.Reset();
+                update.BindInt64(0, entry.second.newCount);
+                update.BindInt64(1, entry.first);
+                update.Step();
+            }
+        }
+    }
+
+    /* a directory with no tracks has no descendants with tracks either */
+    db.Execute("DELETE FROM directories WHERE track_count=0");
+}
@@ -96,6 +96,10 @@ namespace musik { namespace core { namespace library {
             static void CreateIndexes(db::Connection &db);
             static void InvalidateTrackMetadata(db::Connection &db);
 
+            /* directory hierarchy */
+            static int64_t SaveDirectory(db::Connection &db, const std::string& directory);
+            static void UpdateDirectoryTree(db::Connection &db);
+
         private:
             class QueryCompletedMessage;
 
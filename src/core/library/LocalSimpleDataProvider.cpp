@@ -47,6 +47,7 @@
 #include <core/library/query/local/GetPlaylistQuery.h>
 #include <core/library/query/local/SavePlaylistQuery.h>
 #include <core/library/query/local/TrackMetadataQuery.h>
+#include <core/library/query/local/TrackMetadataBatchQuery.h>
 #include <core/library/query/local/TrackListQueryBase.h>
 #include <core/library/track/LibraryTrack.h>
 #include <core/library/LocalLibraryConstants.h>
@@ -94,6 +95,76 @@ static inline PredicateList toPredicateList(IValue** predicates, size_t count) {
     return predicateList;
 }
 
+static inline bool copyCursor(const std::string& cursor, char* dst, size_t size) {
+    if (!dst || cursor.size() + 1 > size) {
+        return false;
+    }
+    memcpy(dst, cursor.c_str(), cursor.size() + 1);
+    return true;
+}
+
+static ITrackList* queryTracksAfter(
+    ILibraryPtr library,
+    std::shared_ptr<TrackListQueryBase> query,
+    const char* cursor,
+    int limit,
+    char* nextCursor,
+    size_t nextCursorSize)
+{
+    if (!query->SetLimitAndCursor(limit, std::string(cursor ? cursor : ""))) {
+        musik::debug::warn(TAG, "invalid track list cursor");
+        return nullptr;
+    }
+
+    library->Enqueue(query, ILibrary::QuerySynchronous);
+
+    if (query->GetStatus() == IQuery::Finished) {
+        if (!copyCursor(query->GetNextCursor(), nextCursor, nextCursorSize)) {
+            musik::debug::err(TAG, "next track list cursor does not fit");
+            return nullptr;
+        }
+        return query->GetSdkResult();
+    }
+
+    return nullptr;
+}
+
+/* a read-only list over tracks whose metadata was already loaded in bulk */
+class LoadedTrackList : public ITrackList {
+    public:
+        LoadedTrackList(std::vector<TrackPtr>&& tracks)
+        : tracks(std::move(tracks)) {
+        }
+
+        virtual void Release() override {
+            delete this;
+        }
+
+        virtual size_t Count() const override {
+            return this->tracks.size();
+        }
+
+        virtual int64_t GetId(size_t index) const override {
+            return this->tracks.at(index)->GetId();
+        }
+
+        virtual int IndexOf(int64_t id) const override {
+            for (size_t i = 0; i < this->tracks.size(); i++) {
+                if (this->tracks[i]->GetId() == id) {
+                    return (int) i;
+                }
+            }
+            return -1;
+        }
+
+        virtual ITrack* GetTrack(size_t index) const override {
+            return this->tracks.at(index)->GetSdkValue();
+        }
+
+    private:
+        std::vector<TrackPtr> tracks;
+};
+
 /* QUERIES */
 
 class ExternalIdListToTrackListQuery : public TrackListQueryBase {
@@ -773,3 +844,117 @@ ITrackList* LocalSimpleDataProvider::QueryTracksByExternalId(
 
     return nullptr;
 }
+
+ITrackList* LocalSimpleDataProvider::QueryTracksAfter(
+    const char* query,
+    const char* cursor,
+    int limit,
+    char* nextCursor,
+    size_t nextCursorSize)
+{
+    try {
+        auto search = std::make_shared<SearchTrackListQuery>(
+            this->library, std::string(query ? query : ""));
+
+        return queryTracksAfter(
+            this->library, search, cursor, limit, nextCursor, nextCursorSize);
+    }
+    catch (...) {
+        musik::debug::err(TAG, "QueryTracksAfter failed");
+    }
+
+    return nullptr;
+}
+
+ITrackList* LocalSimpleDataProvider::QueryTracksByCategoriesAfter(
+    IValue** categories,
+    size_t categoryCount,
+    const char* filter,
+    const char* cursor,
+    int limit,
+    char* nextCursor,
+    size_t nextCursorSize)
+{
+    try {
+        PredicateList list = toPredicateList(categories, categoryCount);
+
+        auto query = std::make_shared<CategoryTrackListQuery>(
+            this->library, list, std::string(filter ? filter : ""));
+
+        return queryTracksAfter(
+            this->library, query, cursor, limit, nextCursor, nextCursorSize);
+    }
+    catch (...) {
+        musik::debug::err(TAG, "QueryTracksByCategoriesAfter failed");
+    }
+
+    return nullptr;
+}
+
+IMapList* LocalSimpleDataProvider::QueryAlbumsAfter(
+    const char* categoryIdName,
+    int64_t categoryIdValue,
+    const char* filter,
+    const char* cursor,
+    int limit,
+    char* nextCursor,
+    size_t nextCursorSize)
+{
+    try {
+        std::shared_ptr<AlbumListQuery> search(new AlbumListQuery(
+            std::string(categoryIdName ? categoryIdName : ""),
+            categoryIdValue,
+            std::string(filter ? filter : "")));
+
+        if (!search->SetLimitAndCursor(limit, std::string(cursor ? cursor : ""))) {
+            musik::debug::warn(TAG, "invalid album list cursor");
+            return nullptr;
+        }
+
+        this->library->Enqueue(search, ILibrary::QuerySynchronous);
+
+        if (search->GetStatus() == IQuery::Finished) {
+            if (!copyCursor(search->GetNextCursor(), nextCursor, nextCursorSize)) {
+                musik::debug::err(TAG, "next album list cursor does not fit");
+                return nullptr;
+            }
+            return search->GetSdkResult();
+        }
+    }
+    catch (...) {
+        musik::debug::err(TAG, "QueryAlbumsAfter failed");
+    }
+
+    return nullptr;
+}
+
+ITrackList* LocalSimpleDataProvider::QueryTracksByIds(
+    const int64_t* trackIds, size_t trackIdCount)
+{
+    try {
+        std::vector<int64_t> ids(trackIds, trackIds + trackIdCount);
+
+        auto query = std::make_shared<TrackMetadataBatchQuery>(ids, this->library);
+
+        this->library->Enqueue(query, ILibrary::QuerySynchronous);
+
+        if (query->GetStatus() == IQuery::Finished) {
+            auto result = query->GetResult();
+
+            std::vector<TrackPtr> tracks;
+            for (auto id : ids) {
+                auto it = result->find(id);
+                if (it != result->end()) {
+                    tracks.push_back(it->second);
+                }
+            }
+
+            return new LoadedTrackList(std::move(tracks));
+        }
+    }
+    catch (...) {
+        musik::debug::err(TAG, "QueryTracksByIds failed");
+    }
+
+    return nullptr;
+}
@@ -151,6 +151,35 @@ namespace musik { namespace core { namespace db { namespace local {
                 const int* sortOrders,
                 int count) override;
 
+            virtual musik::core::sdk::ITrackList* QueryTracksAfter(
+                const char* query,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) override;
+
+            virtual musik::core::sdk::ITrackList* QueryTracksByCategoriesAfter(
+                musik::core::sdk::IValue** categories,
+                size_t categoryCount,
+                const char* filter,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) override;
+
+            virtual musik::core::sdk::IMapList* QueryAlbumsAfter(
+                const char* categoryIdName,
+                int64_t categoryIdValue,
+                const char* filter,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) override;
+
+            virtual musik::core::sdk::ITrackList* QueryTracksByIds(
+                const int64_t* trackIds,
+                size_t trackIdCount) override;
+
         private:
             musik::core::ILibraryPtr library;
     };
@@ -68,6 +68,7 @@ AlbumListQuery::AlbumListQuery(
 AlbumListQuery::AlbumListQuery(
     const category::PredicateList predicates,
     const std::string& filter)
+: limit(-1)
 {
     RESET_RESULT(result);
 
@@ -92,6 +93,27 @@ musik::core::sdk::IMapList* AlbumListQuery::GetSdkResult() {
     return this->result->GetSdkValue();
 }
 
+/* reads the ALBUM_LIST_CURSOR_COLUMNS sort key from a row laid out like
+ALBUM_LIST_QUERY */
+static void readAlbumListCursor(Statement& stmt, QueryCursor& cursor) {
+    cursor.Add(stmt.ColumnText(1));
+    cursor.AddId(stmt.ColumnInt64(0));
+    cursor.AddId(stmt.ColumnInt64(2));
+}
+
+bool AlbumListQuery::SetLimitAndCursor(int limit, const std::string& cursor) {
+    QueryCursor decoded;
+
+    if (cursor.size() && !QueryCursor::Decode(cursor, category::ALBUM_LIST_CURSOR_KIND, decoded)) {
+        return false;
+    }
+
+    this->limit = limit;
+    this->cursor = decoded;
+    this->nextCursor = "";
+    return true;
+}
+
 bool AlbumListQuery::OnRun(Connection& db) {
     RESET_RESULT(result);
 
@@ -103,6 +125,8 @@ bool AlbumListQuery::OnRun(Connection& db) {
     std::string extended = InnerJoinExtended(this->extended, args);
     std::string regular = JoinRegular(this->regular, args, " AND ");
     std::string albumFilter;
+    std::string albumCursor;
+    std::string limitClause;
 
     if (this->filter.size()) {
         albumFilter = category::ALBUM_LIST_FILTER;
@@ -110,14 +134,49 @@ bool AlbumListQuery::OnRun(Connection& db) {
         args.push_back(category::StringArgument(this->filter));
     }
 
+    if (!this->cursor.Empty()) {
+        /* only fails for cursors too long to carry their key, if the anchor
+        album was removed or renamed since the cursor was issued */
+        if (!this->cursor.Resolve(
+            db,
+            category::ALBUM_LIST_CURSOR_ANCHOR_QUERY,
+            category::ALBUM_LIST_CURSOR_SIZE,
+            &readAlbumListCursor))
+        {
+            return false;
+        }
+
+        albumCursor = this->cursor.Predicate(category::ALBUM_LIST_CURSOR_COLUMNS);
+        this->cursor.Append(args);
+    }
+
+    if (this->limit > 0) {
+        /* one extra row tells us whether there's another page */
+        limitClause = "LIMIT " + std::to_string(this->limit + 1);
+    }
+
     category::ReplaceAll(query, "{{extended_predicates}}", extended);
     category::ReplaceAll(query, "{{regular_predicates}}", regular);
     category::ReplaceAll(query, "{{album_list_filter}}", albumFilter);
+    category::ReplaceAll(query, "{{album_list_cursor}}", albumCursor);
+    category::ReplaceAll(query, "{{limit}}", limitClause);
 
     Statement stmt(query.c_str(), db);
     Apply(stmt, args);
 
+    this->nextCursor = "";
+    QueryCursor last;
+
     while (stmt.Step() == Row) {
+        if (this->limit > 0 && result->Count() == (size_t) this->limit) {
+            /* the extra row: there's another page after this one */
+            this->nextCursor = last.Encode(category::ALBUM_LIST_CURSOR_KIND);
+            break;
+        }
+
+        if (this->limit > 0 && result->Count() == (size_t) this->limit - 1) {
+            readAlbumListCursor(stmt, last);
+        }
         std::shared_ptr<MetadataMap> row(new MetadataMap(
             stmt.ColumnInt64(0), stmt.ColumnText(1), "album"));
 
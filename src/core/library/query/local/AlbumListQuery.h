@@ -36,6 +36,7 @@
 
 #include <core/library/query/local/LocalQueryBase.h>
 #include <core/library/query/local/util/CategoryQueryUtil.h>
+#include <core/library/query/local/util/QueryCursor.h>
 #include <core/library/metadata/MetadataMapList.h>
 #include <core/db/Connection.h>
 
@@ -66,9 +67,16 @@ namespace musik { namespace core { namespace db { namespace local {
             musik::core::MetadataMapListPtr GetResult();
             musik::core::sdk::IMapList* GetSdkResult();
 
+            /* keyset pagination; see TrackListQueryBase::SetLimitAndCursor() */
+            bool SetLimitAndCursor(int limit, const std::string& cursor);
+            std::string GetNextCursor() { return this->nextCursor; }
+
         protected:
             virtual bool OnRun(musik::core::db::Connection &db);
 
+            int limit;
+            QueryCursor cursor;
+            std::string nextCursor;
             std::string filter;
             category::PredicateList regular, extended;
             musik::core::MetadataMapListPtr result;
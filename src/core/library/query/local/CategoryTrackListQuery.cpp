@@ -118,6 +118,13 @@ size_t CategoryTrackListQuery::GetQueryHash() {
     return this->hash;
 }
 
+bool CategoryTrackListQuery::SetLimitAndCursor(int limit, const std::string& cursor) {
+    return this->ApplyCursor(
+        limit,
+        cursor,
+        category::CATEGORY_TRACKLIST_CURSOR_KIND);
+}
+
 void CategoryTrackListQuery::PlaylistQuery(musik::core::db::Connection &db) {
     /* playlists are a special case. we already have a query for this, so
     delegate to that. */
@@ -135,6 +142,7 @@ void CategoryTrackListQuery::RegularQuery(musik::core::db::Connection &db) {
     std::string extended = InnerJoinExtended(this->extended, args);
     std::string regular = JoinRegular(this->regular, args, " AND ");
     std::string trackFilter;
+    std::string trackCursor;
     std::string limitAndOffset = this->GetLimitAndOffset();
 
     if (this->filter.size()) {
@@ -145,9 +153,15 @@ void CategoryTrackListQuery::RegularQuery(musik::core::db::Connection &db) {
         args.push_back(category::StringArgument(this->filter));
     }
 
+    if (!this->GetCursor().Empty()) {
+        trackCursor = this->GetCursor().Predicate(category::CATEGORY_TRACKLIST_CURSOR_COLUMNS);
+        this->GetCursor().Append(args);
+    }
+
     category::ReplaceAll(query, "{{extended_predicates}}", extended);
     category::ReplaceAll(query, "{{regular_predicates}}", regular);
     category::ReplaceAll(query, "{{tracklist_filter}}", trackFilter);
+    category::ReplaceAll(query, "{{tracklist_cursor}}", trackCursor);
     category::ReplaceAll(query, "{{limit_and_offset}}", limitAndOffset);
 
     Statement stmt(query.c_str(), db);
@@ -158,11 +172,21 @@ void CategoryTrackListQuery::RegularQuery(musik::core::db::Connection &db) {
 void CategoryTrackListQuery::ProcessResult(musik::core::db::Statement& trackQuery) {
     std::string lastAlbum;
     size_t index = 0;
+    QueryCursor last;
 
     while (trackQuery.Step() == Row) {
+        if (this->IsPastPage(index)) {
+            this->SetNextCursor(last.Encode(category::CATEGORY_TRACKLIST_CURSOR_KIND));
+            break;
+        }
+
         int64_t id = trackQuery.ColumnInt64(0);
         std::string album = trackQuery.ColumnText(1);
 
+        if (this->IsLastInPage(index)) {
+            ReadTrackListCursor(trackQuery, last);
+        }
+
         if (album != lastAlbum) {
             headers->insert(index);
             lastAlbum = album;
@@ -180,8 +204,15 @@ bool CategoryTrackListQuery::OnRun(Connection& db) {
     }
 
     switch (this->type) {
-        case Playlist: this->PlaylistQuery(db); break;
-        case Regular: this->RegularQuery(db); break;
+        case Playlist:
+            this->PlaylistQuery(db);
+            break;
+        case Regular:
+            if (!this->ResolveTrackListCursor(db)) {
+                return false;
+            }
+            this->RegularQuery(db);
+            break;
     }
 
     return true;
@@ -73,6 +73,7 @@ namespace musik { namespace core { namespace db { namespace local {
             virtual Result GetResult();
             virtual Headers GetHeaders();
             virtual size_t GetQueryHash();
+            virtual bool SetLimitAndCursor(int limit, const std::string& cursor);
 
         protected:
             virtual bool OnRun(musik::core::db::Connection &db);
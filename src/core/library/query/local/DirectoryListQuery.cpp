@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+#include "DirectoryListQuery.h"
+
+#include <core/support/Common.h>
+
+using namespace musik::core::db;
+using namespace musik::core::db::local;
+
+DirectoryListQuery::DirectoryListQuery(const std::string& directory) {
+    this->directory = musik::core::NormalizeDir(directory);
+    this->result = std::make_shared<std::vector<Entry>>();
+    this->indexed = false;
+}
+
+DirectoryListQuery::~DirectoryListQuery() {
+
+}
+
+DirectoryListQuery::Result DirectoryListQuery::GetResult() {
+    return this->result;
+}
+
+int64_t DirectoryListQuery::FindDirectoryId(Connection& db, const std::string& directory) {
+    {
+        Statement find("SELECT id FROM directories WHERE name=?", db);
+        find.BindText(0, directory);
+        if (find.Step() == db::Row) {
+            return find.ColumnInt64(0);
+        }
+    }
+
+    {
+        Statement find("SELECT id FROM directories WHERE name=? COLLATE NOCASE", db);
+        find.BindText(0, directory);
+        if (find.Step() == db::Row) {
+            return find.ColumnInt64(0);
+        }
+    }
+
+    return -1;
+}
+
+bool DirectoryListQuery::OnRun(musik::core::db::Connection &db) {
+    this->result = std::make_shared<std::vector<Entry>>();
+
+    int64_t id = FindDirectoryId(db, this->directory);
+    this->indexed = (id != -1);
+
+    if (!this->indexed) {
+        return true;
+    }
+
+    Statement stmt(
+        "SELECT d.name, d.track_count, EXISTS("
+        "  SELECT 1 FROM directories c WHERE c.parent_id=d.id AND c.track_count > 0) "
+        "FROM directories d "
+        "WHERE d.track_count > 0 AND d.parent_id=?",
+        db);
+
+    stmt.BindInt64(0, id);
+
+    while (stmt.Step() == db::Row) {
+        Entry entry;
+        entry.fullPath = stmt.ColumnText(0);
+        entry.trackCount = stmt.ColumnInt64(1);
+        entry.hasSubdirectories = stmt.ColumnInt32(2) != 0;
+
+        /* names are normalized with a trailing separator. take the leaf from
+        the stored path rather than from this->directory, which may differ
+        in case from what was indexed. */
+        std::string name = entry.fullPath;
+        while (name.size() && (name.back() == '/' || name.back() == '\\')) {
+            name.pop_back();
+        }
+
+        size_t separator = name.find_last_of("/\\");
+        entry.name = (separator == std::string::npos) ? name : name.substr(separator + 1);
+
+        if (!entry.name.size()) {
+            continue;
+        }
+
+        this->result->push_back(entry);
+    }
+
+    return true;
+}
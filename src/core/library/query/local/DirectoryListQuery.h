@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/library/query/local/LocalQueryBase.h>
+#include <core/db/Connection.h>
+
+#include <vector>
+#include <string>
+
+namespace musik { namespace core { namespace db { namespace local {
+
+    /* lists the immediate children of an indexed directory by walking the
+    directories table; it never touches the filesystem. */
+    class DirectoryListQuery : public musik::core::db::LocalQueryBase {
+        public:
+            struct Entry {
+                std::string name; /* leaf only */
+                std::string fullPath;
+                int64_t trackCount;
+                bool hasSubdirectories;
+            };
+
+            using Result = std::shared_ptr<std::vector<Entry>>;
+
+            DirectoryListQuery(const std::string& directory);
+            virtual ~DirectoryListQuery();
+
+            std::string Name() { return "DirectoryListQuery"; }
+
+            virtual Result GetResult();
+
+            /* false if the directory has no row in the directories table
+            (e.g. a root that hasn't been indexed yet). */
+            bool IsIndexed() const { return this->indexed; }
+
+            /* resolves a normalized directory to its id. falls back to a
+            case-insensitive match so paths that were typed or configured
+            with different casing still resolve. returns -1 if not found. */
+            static int64_t FindDirectoryId(
+                musik::core::db::Connection &db, const std::string& directory);
+
+        protected:
+            virtual bool OnRun(musik::core::db::Connection &db);
+
+            std::string directory;
+            Result result;
+            bool indexed;
+    };
+
+} } } }
@@ -35,7 +35,9 @@
 #include "pch.hpp"
 #include <core/library/LocalLibraryConstants.h>
 #include <core/i18n/Locale.h>
+#include <core/support/Common.h>
 #include "DirectoryTrackListQuery.h"
+#include "DirectoryListQuery.h"
 #include "CategoryTrackListQuery.h"
 
 using musik::core::db::Statement;
@@ -67,18 +69,47 @@ bool DirectoryTrackListQuery::OnRun(Connection& db) {
     result.reset(new musik::core::TrackList(this->library));
     headers.reset(new std::set<size_t>());
 
+    std::string directory = musik::core::NormalizeDir(this->directory);
+    int64_t directoryId = DirectoryListQuery::FindDirectoryId(db, directory);
+
+    /* walk the directory hierarchy down from the selected directory using
+    the parent_id index, instead of a LIKE prefix scan over every name. if
+    the directory itself has no row (e.g. a root that was configured with a
+    different spelling than what ended up in the table), fall back to a
+    case-insensitive prefix match. */
+    std::string subtree = (directoryId != -1)
+        ? " WITH RECURSIVE subtree(id) AS ("
+          "   SELECT ?"
+          "   UNION ALL"
+          "   SELECT d.id FROM directories d, subtree s WHERE d.parent_id=s.id)"
+        : " WITH subtree(id) AS ("
+          "   SELECT id FROM directories WHERE name LIKE ? ESCAPE '\\')";
+
     std::string query =
+        subtree +
         " SELECT t.id, al.name "
         " FROM tracks t, albums al, artists ar, genres gn "
-        " WHERE t.visible=1 AND directory_id IN ("
-        "   SELECT id FROM directories WHERE name LIKE ?)"
+        " WHERE t.visible=1 AND t.directory_id IN (SELECT id FROM subtree)"
         " AND t.album_id=al.id AND t.visual_genre_id=gn.id AND t.visual_artist_id=ar.id "
         " ORDER BY al.name, disc, track, ar.name ";
 
     query += this->GetLimitAndOffset();
 
     Statement select(query.c_str(), db);
-    select.BindText(0, this->directory + "%");
+
+    if (directoryId != -1) {
+        select.BindInt64(0, directoryId);
+    }
+    else {
+        std::string pattern;
+        for (char c : directory) {
+            if (c == '%' || c == '_' || c == '\\') {
+                pattern += '\\';
+            }
+            pattern += c;
+        }
+        select.BindText(0, pattern + "%");
+    }
 
     std::string lastAlbum;
     size_t index = 0;
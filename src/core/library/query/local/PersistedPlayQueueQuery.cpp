@@ -36,20 +36,58 @@
 #include "PersistedPlayQueueQuery.h"
 #include <core/db/Statement.h>
 #include <core/db/ScopedTransaction.h>
-#include <core/library/track/TrackList.h>
 
 using namespace musik::core;
 using namespace musik::core::db;
 using namespace musik::core::db::local;
+using namespace musik::core::sdk;
 
-PersistedPlayQueueQuery::PersistedPlayQueueQuery(
-    musik::core::ILibraryPtr library,
-    musik::core::audio::PlaybackService& playback,
-    Type type)
-: library(library)
-, playback(playback)
-, type(type)
-{
+static void replay(std::vector<int64_t>& ids, TrackListEditType type, int64_t id, size_t from, size_t to) {
+    /* mirrors the semantics of TrackList's editing methods */
+    size_t size = ids.size();
+
+    switch (type) {
+        case TrackListEditType::Add:
+            ids.push_back(id);
+            break;
+
+        case TrackListEditType::Insert:
+            if (from < size) {
+                ids.insert(ids.begin() + from, id);
+            }
+            else {
+                ids.push_back(id);
+            }
+            break;
+
+        case TrackListEditType::Swap:
+            if (from < size && to < size) {
+                std::swap(ids[from], ids[to]);
+            }
+            break;
+
+        case TrackListEditType::Move:
+            if (from < size && to < size && from != to) {
+                int64_t moved = ids[from];
+                ids.erase(ids.begin() + from);
+                ids.insert(ids.begin() + to, moved);
+            }
+            break;
+
+        case TrackListEditType::Delete:
+            if (from < size) {
+                ids.erase(ids.begin() + from);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+PersistedPlayQueueQuery::PersistedPlayQueueQuery(Type type)
+: type(type)
+, journalCount(0) {
 
 }
 
@@ -58,33 +96,62 @@ PersistedPlayQueueQuery::~PersistedPlayQueueQuery() {
 }
 
 bool PersistedPlayQueueQuery::OnRun(musik::core::db::Connection &db) {
-    ScopedTransaction transaction(db);
+    if (this->type == Type::Snapshot) {
+        ScopedTransaction transaction(db);
 
-    if (this->type == Type::Save) {
-        TrackList tracks(this->library);
-        this->playback.CopyTo(tracks);
+        db.Execute("DELETE FROM last_session_play_queue");
+        db.Execute("DELETE FROM last_session_play_queue_journal");
 
-        {
-            Statement deleteTracks("DELETE FROM last_session_play_queue", db);
-            deleteTracks.Step();
+        Statement insert("INSERT INTO last_session_play_queue (track_id) VALUES (?)", db);
+        for (int64_t id : this->trackIds) {
+            insert.Reset();
+            insert.BindInt64(0, id);
+            insert.Step();
         }
+    }
+    else if (this->type == Type::Append) {
+        ScopedTransaction transaction(db);
 
-        {
-            Statement insert("INSERT INTO last_session_play_queue (track_id) VALUES (?)", db);
-            for (size_t i = 0; i < tracks.Count(); i++) {
-                insert.Reset();
-                insert.BindInt64(0, tracks.GetId(i));
-                insert.Step();
-            }
+        Statement insert(
+            "INSERT INTO last_session_play_queue_journal "
+            "(type, track_id, from_index, to_index) VALUES (?, ?, ?, ?)", db);
+
+        for (auto& edit : this->edits) {
+            insert.Reset();
+            insert.BindInt32(0, (int) edit.type);
+            insert.BindInt64(1, edit.id);
+            insert.BindInt64(2, (int64_t) edit.from);
+            insert.BindInt64(3, (int64_t) edit.to);
+            insert.Step();
         }
     }
     else if (this->type == Type::Restore) {
-        auto editor = this->playback.Edit();
-        editor.Clear();
+        this->trackIds.clear();
+        this->journalCount = 0;
 
-        Statement query("SELECT track_id FROM last_session_play_queue ORDER BY id ASC", db);
-        while (query.Step() == db::Row) {
-            editor.Add(query.ColumnInt64(0));
+        {
+            Statement query("SELECT track_id FROM last_session_play_queue ORDER BY id ASC", db);
+            while (query.Step() == db::Row) {
+                this->trackIds.push_back(query.ColumnInt64(0));
+            }
+        }
+
+        {
+            Statement query(
+                "SELECT type, track_id, from_index, to_index "
+                "FROM last_session_play_queue_journal "
+                "ORDER BY id ASC", db);
+
+            while (query.Step() == db::Row) {
+                replay(
+                    this->trackIds,
+                    (TrackListEditType) query.ColumnInt32(0),
+                    query.ColumnInt64(1),
+                    (size_t) query.ColumnInt64(2),
+                    (size_t) query.ColumnInt64(3));
+
+                ++this->journalCount;
+            }
         }
     }
 
@@ -35,44 +35,60 @@
 #pragma once
 
 #include <core/library/query/local/LocalQueryBase.h>
-#include <core/audio/PlaybackService.h>
+#include <core/sdk/ITrackListEditor.h>
+
+#include <vector>
 
 namespace musik { namespace core { namespace db { namespace local {
 
+    /* the last session's play queue is stored as a snapshot of track ids,
+    plus a journal of the edits made since the snapshot was written. edits
+    are appended as they happen, so saving is proportional to the number of
+    changes rather than the length of the queue, and a crash loses at most
+    the edits that haven't been flushed yet. */
     class PersistedPlayQueueQuery : public musik::core::db::LocalQueryBase {
         public:
-            static PersistedPlayQueueQuery* Save(
-                musik::core::ILibraryPtr library,
-                musik::core::audio::PlaybackService& playback) 
-            {
-                return new PersistedPlayQueueQuery(library, playback, Type::Save);
+            using Edit = musik::core::sdk::TrackListEdit;
+
+            /* replaces the snapshot with the specified ids and truncates
+            the journal. */
+            static PersistedPlayQueueQuery* Snapshot(const std::vector<int64_t>& trackIds) {
+                auto result = new PersistedPlayQueueQuery(Type::Snapshot);
+                result->trackIds = trackIds;
+                return result;
             }
 
-            static PersistedPlayQueueQuery* Restore(
-                musik::core::ILibraryPtr library,
-                musik::core::audio::PlaybackService& playback)
-            {
-                return new PersistedPlayQueueQuery(library, playback, Type::Restore);
+            /* appends edits to the journal. */
+            static PersistedPlayQueueQuery* Append(const std::vector<Edit>& edits) {
+                auto result = new PersistedPlayQueueQuery(Type::Append);
+                result->edits = edits;
+                return result;
+            }
+
+            /* reads the snapshot and replays the journal over it. */
+            static PersistedPlayQueueQuery* Restore() {
+                return new PersistedPlayQueueQuery(Type::Restore);
             }
 
             virtual ~PersistedPlayQueueQuery();
 
             virtual std::string Name() { return "PersistedPlayQueueQuery"; }
 
+            const std::vector<int64_t>& GetTrackIds() const { return this->trackIds; }
+            size_t GetJournalCount() const { return this->journalCount; }
+
         protected:
             virtual bool OnRun(musik::core::db::Connection &db);
 
         private:
-            enum class Type { Save, Restore };
+            enum class Type { Snapshot, Append, Restore };
 
-            PersistedPlayQueueQuery(
-                musik::core::ILibraryPtr library,
-                musik::core::audio::PlaybackService& playback,
-                Type type);
+            PersistedPlayQueueQuery(Type type);
 
-            musik::core::ILibraryPtr library;
-            musik::core::audio::PlaybackService& playback;
             Type type;
+            std::vector<int64_t> trackIds;
+            std::vector<Edit> edits;
+            size_t journalCount;
     };
 
 } } } }
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+#include "PlaybackInfoQuery.h"
+
+using namespace musik::core::db;
+using namespace musik::core::db::local;
+using namespace musik::core::sdk;
+
+PlaybackInfoQuery::PlaybackInfoQuery(const std::vector<int64_t>& trackIds)
+: trackIds(trackIds) {
+}
+
+PlaybackInfoQuery::~PlaybackInfoQuery() {
+
+}
+
+PlaybackInfoQuery::Result PlaybackInfoQuery::GetResult() {
+    return this->result;
+}
+
+bool PlaybackInfoQuery::OnRun(musik::core::db::Connection &db) {
+    this->result = std::make_shared<std::unordered_map<int64_t, Entry>>();
+
+    if (!this->trackIds.size()) {
+        return true;
+    }
+
+    std::string placeholders;
+    for (size_t i = 0; i < this->trackIds.size(); i++) {
+        placeholders += (i == 0) ? "?" : ",?";
+    }
+
+    std::string query =
+        "SELECT t.id, t.filename, "
+        "  COALESCE(rg.album_gain, 1.0), COALESCE(rg.album_peak, 1.0), "
+        "  COALESCE(rg.track_gain, 1.0), COALESCE(rg.track_peak, 1.0) "
+        "FROM tracks t "
+        "LEFT OUTER JOIN replay_gain rg ON rg.track_id=t.id "
+        "WHERE t.id IN (" + placeholders + ")";
+
+    Statement stmt(query.c_str(), db);
+
+    for (size_t i = 0; i < this->trackIds.size(); i++) {
+        stmt.BindInt64((int) i, this->trackIds[i]);
+    }
+
+    while (stmt.Step() == db::Row) {
+        /* tracks without a replay_gain row get 1.0 across the board, which
+        means "no adjustment"; same as ReplayGainQuery. */
+        Entry entry;
+        entry.uri = stmt.ColumnText(1);
+        entry.replayGain.albumGain = stmt.ColumnFloat(2);
+        entry.replayGain.albumPeak = stmt.ColumnFloat(3);
+        entry.replayGain.trackGain = stmt.ColumnFloat(4);
+        entry.replayGain.trackPeak = stmt.ColumnFloat(5);
+
+        (*this->result)[stmt.ColumnInt64(0)] = entry;
+    }
+
+    return true;
+}
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/library/query/local/LocalQueryBase.h>
+#include <core/db/Connection.h>
+#include <core/sdk/ITagStore.h>
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace musik { namespace core { namespace db { namespace local {
+
+    /* everything the transport needs to start a track: its uri and replay
+    gain, for a batch of tracks in a single statement. used to prepare
+    upcoming play queue entries ahead of time. */
+    class PlaybackInfoQuery : public musik::core::db::LocalQueryBase {
+        public:
+            struct Entry {
+                std::string uri;
+                musik::core::sdk::ReplayGain replayGain;
+            };
+
+            using Result = std::shared_ptr<std::unordered_map<int64_t, Entry>>;
+
+            PlaybackInfoQuery(const std::vector<int64_t>& trackIds);
+            virtual ~PlaybackInfoQuery();
+
+            std::string Name() { return "PlaybackInfoQuery"; }
+
+            virtual Result GetResult();
+
+            const std::vector<int64_t>& GetTrackIds() { return this->trackIds; }
+
+        protected:
+            virtual bool OnRun(musik::core::db::Connection &db);
+
+            std::vector<int64_t> trackIds;
+            Result result;
+    };
+
+} } } }
@@ -38,6 +38,7 @@
 #include <core/i18n/Locale.h>
 #include <core/library/track/LibraryTrack.h>
 #include <core/library/LocalLibraryConstants.h>
+#include <core/library/query/local/util/CategoryQueryUtil.h>
 #include <core/db/Statement.h>
 
 #include <boost/algorithm/string/case_conv.hpp>
@@ -82,6 +83,14 @@ size_t SearchTrackListQuery::GetQueryHash() {
     return this->hash;
 }
 
+bool SearchTrackListQuery::SetLimitAndCursor(int limit, const std::string& cursor) {
+    /* same ordering as the category track list, so the cursors are compatible */
+    return this->ApplyCursor(
+        limit,
+        cursor,
+        category::CATEGORY_TRACKLIST_CURSOR_KIND);
+}
+
 bool SearchTrackListQuery::OnRun(Connection& db) {
     if (result) {
         result.reset(new musik::core::TrackList(this->library));
@@ -94,40 +103,59 @@ bool SearchTrackListQuery::OnRun(Connection& db) {
     size_t index = 0;
 
     std::string query;
+    category::ArgumentList args;
 
     if (hasFilter) {
         query =
-            "SELECT DISTINCT t.id, al.name "
-            "FROM tracks t, albums al, artists ar, genres gn "
+            "SELECT DISTINCT tracks.id, al.name, tracks.disc, CAST(tracks.track AS INTEGER), ar.name "
+            "FROM tracks, albums al, artists ar, genres gn "
             "WHERE "
-                " t.visible=1 AND "
-                "(t.title LIKE ? OR al.name LIKE ? OR ar.name LIKE ? OR gn.name LIKE ?) "
-                " AND t.album_id=al.id AND t.visual_genre_id=gn.id AND t.visual_artist_id=ar.id "
-            "ORDER BY al.name, disc, track, ar.name ";
+                " tracks.visible=1 AND "
+                "(tracks.title LIKE ? OR al.name LIKE ? OR ar.name LIKE ? OR gn.name LIKE ?) "
+                " AND tracks.album_id=al.id AND tracks.visual_genre_id=gn.id AND tracks.visual_artist_id=ar.id ";
+
+        args.push_back(category::StringArgument(this->filter));
+        args.push_back(category::StringArgument(this->filter));
+        args.push_back(category::StringArgument(this->filter));
+        args.push_back(category::StringArgument(this->filter));
     }
     else {
         query =
-            "SELECT DISTINCT t.id, al.name "
-            "FROM tracks t, albums al, artists ar, genres gn "
-            "WHERE t.visible=1 AND t.album_id=al.id AND t.visual_genre_id=gn.id AND t.visual_artist_id=ar.id "
-            "ORDER BY al.name, disc, track, ar.name ";
+            "SELECT DISTINCT tracks.id, al.name, tracks.disc, CAST(tracks.track AS INTEGER), ar.name "
+            "FROM tracks, albums al, artists ar, genres gn "
+            "WHERE tracks.visible=1 AND tracks.album_id=al.id AND tracks.visual_genre_id=gn.id AND tracks.visual_artist_id=ar.id ";
+    }
+
+    if (!this->ResolveTrackListCursor(db)) {
+        return false;
+    }
+
+    if (!this->GetCursor().Empty()) {
+        query += this->GetCursor().Predicate(category::CATEGORY_TRACKLIST_CURSOR_COLUMNS);
+        this->GetCursor().Append(args);
     }
 
+    query += "ORDER BY " + category::CATEGORY_TRACKLIST_CURSOR_COLUMNS + " ";
     query += this->GetLimitAndOffset();
 
     Statement trackQuery(query.c_str(), db);
+    category::Apply(trackQuery, args);
 
-    if (hasFilter) {
-        trackQuery.BindText(0, this->filter);
-        trackQuery.BindText(1, this->filter);
-        trackQuery.BindText(2, this->filter);
-        trackQuery.BindText(3, this->filter);
-    }
+    QueryCursor last;
 
     while (trackQuery.Step() == Row) {
+        if (this->IsPastPage(index)) {
+            this->SetNextCursor(last.Encode(category::CATEGORY_TRACKLIST_CURSOR_KIND));
+            break;
+        }
+
         int64_t id = trackQuery.ColumnInt64(0);
         std::string album = trackQuery.ColumnText(1);
 
+        if (this->IsLastInPage(index)) {
+            ReadTrackListCursor(trackQuery, last);
+        }
+
         if (!album.size()) {
             album = _TSTR("tracklist_unknown_album");
         }
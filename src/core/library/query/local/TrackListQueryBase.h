@@ -35,6 +35,7 @@
 #pragma once
 
 #include <core/library/query/local/LocalQueryBase.h>
+#include <core/library/query/local/util/QueryCursor.h>
 #include <core/db/Connection.h>
 #include <core/library/track/Track.h>
 #include <core/library/track/TrackList.h>
@@ -50,6 +51,7 @@ namespace musik { namespace core { namespace db { namespace local {
             TrackListQueryBase() {
                 this->limit = -1;
                 this->offset = 0;
+                this->keyset = false;
             }
 
             virtual ~TrackListQueryBase() { };
@@ -61,6 +63,22 @@ namespace musik { namespace core { namespace db { namespace local {
             virtual void SetLimitAndOffset(int limit, int offset = 0) {
                 this->limit = limit;
                 this->offset = offset;
+                this->keyset = false;
+            }
+
+            /* keyset pagination: up to `limit` tracks that sort after `cursor`,
+            which is either empty (first page) or a value previously returned by
+            GetNextCursor(). unlike an OFFSET, the cost of a page doesn't grow
+            with its depth. returns false if this query doesn't support cursors
+            or the cursor isn't one of ours. */
+            virtual bool SetLimitAndCursor(int limit, const std::string& cursor) {
+                return false;
+            }
+
+            /* the cursor for the page after this one, or empty if this was
+            the last page. only meaningful after SetLimitAndCursor(). */
+            virtual std::string GetNextCursor() {
+                return this->nextCursor;
             }
 
             virtual musik::core::sdk::ITrackList* GetSdkResult() {
@@ -69,6 +87,12 @@ namespace musik { namespace core { namespace db { namespace local {
 
         protected:
             std::string GetLimitAndOffset() {
+                if (this->keyset) {
+                    /* one extra row tells us whether there's another page */
+                    return this->limit > 0
+                        ? boost::str(boost::format("LIMIT %d") % (this->limit + 1))
+                        : "";
+                }
                 if (this->limit > 0 && this->offset >= 0) {
                     return boost::str(boost::format("LIMIT %d OFFSET %d")
                         % this->limit % this->offset);
@@ -76,8 +100,75 @@ namespace musik { namespace core { namespace db { namespace local {
                 return "";
             }
 
+            /* helper for SetLimitAndCursor() overrides: `kind` identifies
+            the query's sort key (see QueryCursor) */
+            bool ApplyCursor(
+                int limit,
+                const std::string& cursor,
+                const std::string& kind)
+            {
+                QueryCursor decoded;
+                if (cursor.size() && !QueryCursor::Decode(cursor, kind, decoded)) {
+                    return false;
+                }
+                this->limit = limit;
+                this->offset = 0;
+                this->keyset = true;
+                this->cursor = decoded;
+                this->nextCursor = "";
+                return true;
+            }
+
+            bool IsKeyset() {
+                return this->keyset;
+            }
+
+            /* true if `index` is the extra row fetched past the end of a
+            keyset page; callers stop there and publish the next cursor. */
+            bool IsPastPage(size_t index) {
+                return this->keyset && this->limit > 0 && index >= (size_t) this->limit;
+            }
+
+            /* true if `index` is the last row of a full keyset page, i.e. the
+            row whose sort key becomes the next cursor (if there is more). */
+            bool IsLastInPage(size_t index) {
+                return this->keyset && this->limit > 0 && index == (size_t) this->limit - 1;
+            }
+
+            const QueryCursor& GetCursor() {
+                return this->cursor;
+            }
+
+            /* reads the CATEGORY_TRACKLIST_CURSOR_COLUMNS sort key from a row
+            laid out like CATEGORY_TRACKLIST_QUERY */
+            static void ReadTrackListCursor(Statement& stmt, QueryCursor& cursor) {
+                cursor.Add(stmt.ColumnText(1)); /* raw, before "unknown album" */
+                cursor.Add(stmt.ColumnText(2));
+                cursor.Add(stmt.ColumnInt64(3));
+                cursor.Add(stmt.ColumnText(4));
+                cursor.AddId(stmt.ColumnInt64(0));
+            }
+
+            /* call before building the cursor predicate. returns false if the
+            cursor is malformed, or didn't carry its key and the anchor track
+            was removed or re-tagged since it was issued */
+            bool ResolveTrackListCursor(Connection& db) {
+                return this->cursor.Empty() || this->cursor.Resolve(
+                    db,
+                    category::CATEGORY_TRACKLIST_CURSOR_ANCHOR_QUERY,
+                    category::CATEGORY_TRACKLIST_CURSOR_SIZE,
+                    &ReadTrackListCursor);
+            }
+
+            void SetNextCursor(const std::string& nextCursor) {
+                this->nextCursor = nextCursor;
+            }
+
         private:
             int limit, offset;
+            bool keyset;
+            QueryCursor cursor;
+            std::string nextCursor;
 
             class WrappedTrackList : public musik::core::sdk::ITrackList {
                 public:
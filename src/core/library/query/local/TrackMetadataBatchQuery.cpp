@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+#include "TrackMetadataBatchQuery.h"
+
+#include <core/library/LocalLibraryConstants.h>
+#include <core/library/track/LibraryTrack.h>
+
+using namespace musik::core;
+using namespace musik::core::db;
+using namespace musik::core::db::local;
+using namespace musik::core::library;
+
+/* stays well below SQLITE_MAX_VARIABLE_NUMBER */
+static const size_t MAX_IDS_PER_STATEMENT = 256;
+
+static const std::string QUERY_PREFIX =
+    "SELECT DISTINCT t.id, t.track, t.disc, t.bpm, t.duration, t.filesize, t.title, "
+    "  t.filename, t.thumbnail_id, al.name AS album, alar.name AS album_artist, "
+    "  gn.name AS genre, ar.name AS artist, t.filetime, t.visual_genre_id, "
+    "  t.visual_artist_id, t.album_artist_id, t.album_id, t.source_id, t.external_id "
+    "FROM tracks t, albums al, artists alar, artists ar, genres gn "
+    "WHERE t.album_id=al.id AND t.album_artist_id=alar.id AND "
+    "  t.visual_genre_id=gn.id AND t.visual_artist_id=ar.id AND t.id IN (";
+
+/* in column order, starting after t.id */
+static const char* FIELDS[] = {
+    constants::Track::TRACK_NUM,
+    constants::Track::DISC_NUM,
+    constants::Track::BPM,
+    constants::Track::DURATION,
+    constants::Track::FILESIZE,
+    constants::Track::TITLE,
+    constants::Track::FILENAME,
+    constants::Track::THUMBNAIL_ID,
+    constants::Track::ALBUM,
+    constants::Track::ALBUM_ARTIST,
+    constants::Track::GENRE,
+    constants::Track::ARTIST,
+    constants::Track::FILETIME,
+    constants::Track::GENRE_ID,
+    constants::Track::ARTIST_ID,
+    constants::Track::ALBUM_ARTIST_ID,
+    constants::Track::ALBUM_ID,
+    constants::Track::SOURCE_ID,
+    constants::Track::EXTERNAL_ID
+};
+
+static const int FIELD_COUNT = (int) (sizeof(FIELDS) / sizeof(FIELDS[0]));
+
+TrackMetadataBatchQuery::TrackMetadataBatchQuery(
+    const std::vector<int64_t>& trackIds, ILibraryPtr library)
+: trackIds(trackIds)
+, library(library) {
+}
+
+TrackMetadataBatchQuery::~TrackMetadataBatchQuery() {
+
+}
+
+TrackMetadataBatchQuery::Result TrackMetadataBatchQuery::GetResult() {
+    return this->result;
+}
+
+bool TrackMetadataBatchQuery::OnRun(musik::core::db::Connection &db) {
+    this->result = std::make_shared<std::unordered_map<int64_t, TrackPtr>>();
+
+    for (size_t offset = 0; offset < this->trackIds.size(); offset += MAX_IDS_PER_STATEMENT) {
+        if (this->IsCanceled()) {
+            return false;
+        }
+
+        size_t count = std::min(MAX_IDS_PER_STATEMENT, this->trackIds.size() - offset);
+
+        std::string placeholders;
+        for (size_t i = 0; i < count; i++) {
+            placeholders += (i == 0) ? "?" : ",?";
+        }
+
+        std::string query = QUERY_PREFIX + placeholders + ")";
+        Statement stmt(query.c_str(), db);
+
+        for (size_t i = 0; i < count; i++) {
+            stmt.BindInt64((int) i, this->trackIds[offset + i]);
+        }
+
+        while (stmt.Step() == db::Row) {
+            int64_t id = stmt.ColumnInt64(0);
+            auto track = std::make_shared<LibraryTrack>(id, this->library);
+
+            for (int i = 0; i < FIELD_COUNT; i++) {
+                track->SetValue(FIELDS[i], stmt.ColumnText(i + 1));
+            }
+
+            (*this->result)[id] = track;
+        }
+    }
+
+    return true;
+}
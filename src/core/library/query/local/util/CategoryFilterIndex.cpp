@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+#include "CategoryFilterIndex.h"
+
+#include <utf8/utf8.h>
+#include <algorithm>
+
+using namespace musik::core::db::local;
+
+namespace {
+    struct Fold {
+        uint32_t first, last;
+        const char* value;
+    };
+
+    /* latin-1 supplement and latin extended-a, mapped to their lowercase
+    ascii base letters. sorted and non-overlapping, so it can be searched. */
+    static const Fold FOLDS[] = {
+        { 0x00C0, 0x00C5, "a" }, { 0x00C6, 0x00C6, "ae" }, { 0x00C7, 0x00C7, "c" },
+        { 0x00C8, 0x00CB, "e" }, { 0x00CC, 0x00CF, "i" }, { 0x00D0, 0x00D0, "d" },
+        { 0x00D1, 0x00D1, "n" }, { 0x00D2, 0x00D6, "o" }, { 0x00D8, 0x00D8, "o" },
+        { 0x00D9, 0x00DC, "u" }, { 0x00DD, 0x00DD, "y" }, { 0x00DE, 0x00DE, "th" },
+        { 0x00DF, 0x00DF, "ss" }, { 0x00E0, 0x00E5, "a" }, { 0x00E6, 0x00E6, "ae" },
+        { 0x00E7, 0x00E7, "c" }, { 0x00E8, 0x00EB, "e" }, { 0x00EC, 0x00EF, "i" },
+        { 0x00F0, 0x00F0, "d" }, { 0x00F1, 0x00F1, "n" }, { 0x00F2, 0x00F6, "o" },
+        { 0x00F8, 0x00F8, "o" }, { 0x00F9, 0x00FC, "u" }, { 0x00FD, 0x00FD, "y" },
+        { 0x00FE, 0x00FE, "th" }, { 0x00FF, 0x00FF, "y" }, { 0x0100, 0x0105, "a" },
+        { 0x0106, 0x010D, "c" }, { 0x010E, 0x0111, "d" }, { 0x0112, 0x011B, "e" },
+        { 0x011C, 0x0123, "g" }, { 0x0124, 0x0127, "h" }, { 0x0128, 0x0131, "i" },
+        { 0x0132, 0x0133, "ij" }, { 0x0134, 0x0135, "j" }, { 0x0136, 0x0138, "k" },
+        { 0x0139, 0x0142, "l" }, { 0x0143, 0x014B, "n" }, { 0x014C, 0x0151, "o" },
+        { 0x0152, 0x0153, "oe" }, { 0x0154, 0x0159, "r" }, { 0x015A, 0x0161, "s" },
+        { 0x0162, 0x0167, "t" }, { 0x0168, 0x0173, "u" }, { 0x0174, 0x0175, "w" },
+        { 0x0176, 0x0178, "y" }, { 0x0179, 0x017E, "z" }, { 0x017F, 0x017F, "s" }
+    };
+
+    static const Fold* FOLDS_END = FOLDS + sizeof(FOLDS) / sizeof(FOLDS[0]);
+
+    static void appendFolded(std::string& output, uint32_t cp) {
+        if (cp < 0x80) {
+            output += (char) tolower((int) cp);
+        }
+        else if (cp >= 0x0300 && cp <= 0x036F) {
+            /* combining diacritical mark (decomposed input); drop it */
+        }
+        else {
+            auto fold = std::lower_bound(FOLDS, FOLDS_END, cp,
+                [](const Fold& f, uint32_t cp) { return f.last < cp; });
+
+            if (fold != FOLDS_END && cp >= fold->first) {
+                output += fold->value;
+            }
+            else {
+                utf8::append(cp, std::back_inserter(output));
+            }
+        }
+    }
+}
+
+CategoryFilterIndex::CategoryFilterIndex(Result values)
+: values(values) {
+    const size_t count = values->Count();
+    this->normalized.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        this->normalized.push_back(Normalize(values->At(i)->ToString()));
+    }
+}
+
+std::string CategoryFilterIndex::Normalize(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+
+    auto it = value.begin();
+    auto end = value.end();
+    while (it != end) {
+        try {
+            appendFolded(result, utf8::next(it, end));
+        }
+        catch (const utf8::exception&) {
+            /* invalid sequence: keep the raw byte and move on */
+            result += (char) tolower((unsigned char) *it);
+            ++it;
+        }
+    }
+
+    return result;
+}
+
+CategoryFilterIndex::Result CategoryFilterIndex::Filter(const std::string& filter) {
+    const std::string needle = Normalize(filter);
+
+    if (needle.empty()) {
+        this->lastFilter.clear();
+        this->lastMatches.clear();
+        return this->values;
+    }
+
+    /* anything that matches the new filter also matched the last one if the
+    new filter contains it, so only the previous matches need to be scanned. */
+    const bool refine =
+        this->lastFilter.size() &&
+        needle.find(this->lastFilter) != std::string::npos;
+
+    std::vector<size_t> matches;
+
+    if (refine) {
+        for (size_t i : this->lastMatches) {
+            if (this->normalized[i].find(needle) != std::string::npos) {
+                matches.push_back(i);
+            }
+        }
+    }
+    else {
+        for (size_t i = 0; i < this->normalized.size(); i++) {
+            if (this->normalized[i].find(needle) != std::string::npos) {
+                matches.push_back(i);
+            }
+        }
+    }
+
+    Result result = std::make_shared<SdkValueList>();
+    for (size_t i : matches) {
+        result->Add(this->values->At(i));
+    }
+
+    this->lastFilter = needle;
+    this->lastMatches.swap(matches);
+    return result;
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/library/query/local/util/SdkWrappers.h>
+#include <string>
+#include <vector>
+
+namespace musik { namespace core { namespace db { namespace local {
+
+    /* a resident, pre-normalized copy of a category list (e.g. all artists)
+    that answers substring filters without going back to the database. the
+    most recent match set is retained, so a filter that extends the previous
+    one (the common case while typing) only rescans the previous matches.
+    not thread safe; intended to be owned and used by a single view. */
+    class CategoryFilterIndex {
+        public:
+            using Result = SdkValueList::Shared;
+
+            CategoryFilterIndex(Result values);
+
+            Result Filter(const std::string& filter);
+            size_t Count() const { return this->normalized.size(); }
+
+            /* lowercases and folds latin diacritics: "Björk" => "bjork" */
+            static std::string Normalize(const std::string& value);
+
+        private:
+            Result values;
+            std::vector<std::string> normalized;
+            std::string lastFilter;
+            std::vector<size_t> lastMatches;
+    };
+
+} } } }
@@ -172,8 +172,28 @@ namespace musik { namespace core { namespace db { namespace local {
         static const std::string CATEGORY_TRACKLIST_FILTER =
             " AND (tracks.title LIKE ? OR al.name LIKE ? OR ar.name LIKE ? OR gn.name LIKE ?) ";
 
+        /* the track list sort key, in ORDER BY order. track numbers are cast
+        because the indexer may store them as text. tracks.id comes last so the
+        key is unique, which is required for keyset (cursor) pagination. */
+        static const std::string CATEGORY_TRACKLIST_CURSOR_KIND = "tracks";
+
+        static const std::string CATEGORY_TRACKLIST_CURSOR_COLUMNS =
+            "al.name, tracks.disc, CAST(tracks.track AS INTEGER), ar.name, tracks.id";
+
+        static const size_t CATEGORY_TRACKLIST_CURSOR_SIZE = 5;
+
+        /* reloads the sort key of a cursor's anchor track, by id. the columns
+        match the first five of CATEGORY_TRACKLIST_QUERY. */
+        static const std::string CATEGORY_TRACKLIST_CURSOR_ANCHOR_QUERY =
+            "SELECT tracks.id, al.name, tracks.disc, CAST(tracks.track AS INTEGER), ar.name "
+            "FROM tracks, albums al, artists ar "
+            "WHERE "
+            "  tracks.id=? AND "
+            "  tracks.album_id=al.id AND "
+            "  tracks.visual_artist_id=ar.id";
+
         static const std::string CATEGORY_TRACKLIST_QUERY =
-            "SELECT DISTINCT tracks.id, al.name "
+            "SELECT DISTINCT tracks.id, al.name, tracks.disc, CAST(tracks.track AS INTEGER), ar.name "
             "FROM tracks, albums al, artists ar, genres gn "
             "{{extended_predicates}} "
             "WHERE "
@@ -183,7 +203,8 @@ namespace musik { namespace core { namespace db { namespace local {
             "  tracks.visual_artist_id=ar.id "
             "  {{regular_predicates}} "
             "  {{tracklist_filter}} "
-            "ORDER BY al.name, disc, track, ar.name "
+            "  {{tracklist_cursor}} "
+            "ORDER BY " + CATEGORY_TRACKLIST_CURSOR_COLUMNS + " "
             "{{limit_and_offset}} ";
 
         /* ALBUM_LIST_QUERY is like a specialized REGULAR_PROPERTY_QUERY used by
@@ -193,6 +214,27 @@ namespace musik { namespace core { namespace db { namespace local {
         static const std::string ALBUM_LIST_FILTER =
             " AND (LOWER(album) like ? OR LOWER(album_artist) like ?) ";
 
+        /* an album may appear once per album artist, so the artist id is part
+        of the (unique) sort key used for cursor pagination. */
+        static const std::string ALBUM_LIST_CURSOR_KIND = "albums";
+
+        static const std::string ALBUM_LIST_CURSOR_COLUMNS =
+            "albums.name, albums.id, tracks.album_artist_id";
+
+        static const size_t ALBUM_LIST_CURSOR_SIZE = 3;
+
+        /* reloads the sort key of a cursor's anchor album, by album and album
+        artist id. the columns match the first three of ALBUM_LIST_QUERY. */
+        static const std::string ALBUM_LIST_CURSOR_ANCHOR_QUERY =
+            "SELECT albums.id, albums.name, tracks.album_artist_id "
+            "FROM albums, tracks "
+            "WHERE "
+            "  albums.id=? AND "
+            "  tracks.album_artist_id=? AND "
+            "  tracks.album_id=albums.id AND "
+            "  tracks.visible=1 "
+            "LIMIT 1";
+
         static const std::string ALBUM_LIST_QUERY =
             "SELECT DISTINCT "
             "  albums.id, "
@@ -208,7 +250,9 @@ namespace musik { namespace core { namespace db { namespace local {
             "  tracks.visible=1 "
             "  {{regular_predicates}} "
             "  {{album_list_filter}} "
-            "ORDER BY albums.name ASC ";
+            "  {{album_list_cursor}} "
+            "ORDER BY " + ALBUM_LIST_CURSOR_COLUMNS + " "
+            "{{limit}} ";
 
         /* data types */
 
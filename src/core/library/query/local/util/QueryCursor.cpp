@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+#include "QueryCursor.h"
+
+using nlohmann::json;
+using namespace musik::core::db;
+using namespace musik::core::db::local;
+
+static const char* HEX = "0123456789abcdef";
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') { return c - '0'; }
+    if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+    if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+    return -1;
+}
+
+static std::string toHex(const std::string& raw) {
+    std::string result;
+    result.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+        result += HEX[c >> 4];
+        result += HEX[c & 0x0f];
+    }
+    return result;
+}
+
+QueryCursor::QueryCursor() {
+    this->Clear();
+}
+
+void QueryCursor::Clear() {
+    this->values = json::array();
+    this->ids.clear();
+    this->fingerprint.clear();
+}
+
+void QueryCursor::Add(const std::string& value) {
+    this->values.push_back(value);
+}
+
+void QueryCursor::Add(int64_t value) {
+    this->values.push_back(value);
+}
+
+void QueryCursor::AddId(int64_t value) {
+    this->values.push_back(value);
+    this->ids.push_back(value);
+}
+
+void QueryCursor::Append(category::ArgumentList& args) const {
+    for (auto& value : this->values) {
+        if (value.is_number_integer()) {
+            args.push_back(category::IdArgument(value.get<int64_t>()));
+        }
+        else {
+            args.push_back(category::StringArgument(value.get<std::string>()));
+        }
+    }
+}
+
+std::string QueryCursor::Fingerprint() const {
+    /* 64-bit FNV-1a. std::hash isn't stable across builds, and cursors
+    may outlive the process that issued them. */
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : this->values.dump()) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    std::string result;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        result += HEX[(hash >> shift) & 0x0f];
+    }
+    return result;
+}
+
+std::string QueryCursor::Encode(const std::string& kind) const {
+    std::string encoded = toHex(
+        json({ kind, this->ids, this->Fingerprint(), this->values }).dump());
+
+    if (encoded.size() <= MAX_ENCODED_LENGTH) {
+        return encoded;
+    }
+
+    /* the key has some very long names; fall back to the anchor ids only,
+    and reload the key when the cursor is resolved. */
+    return toHex(json({ kind, this->ids, this->Fingerprint() }).dump());
+}
+
+bool QueryCursor::Decode(
+    const std::string& encoded,
+    const std::string& kind,
+    QueryCursor& target)
+{
+    if (encoded.size() % 2 != 0) {
+        return false;
+    }
+
+    std::string raw;
+    raw.reserve(encoded.size() / 2);
+    for (size_t i = 0; i < encoded.size(); i += 2) {
+        int hi = hexValue(encoded[i]), lo = hexValue(encoded[i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        raw += (char) ((hi << 4) | lo);
+    }
+
+    try {
+        json parsed = json::parse(raw);
+
+        if (!parsed.is_array() || parsed.size() < 3 || parsed.size() > 4 ||
+            parsed[0] != kind || !parsed[1].is_array() ||
+            parsed[1].empty() || !parsed[2].is_string())
+        {
+            return false;
+        }
+
+        target.Clear();
+
+        for (auto& value : parsed[1]) {
+            if (!value.is_number_integer()) {
+                return false;
+            }
+            target.ids.push_back(value.get<int64_t>());
+        }
+
+        target.fingerprint = parsed[2].get<std::string>();
+
+        if (parsed.size() == 4) {
+            if (!parsed[3].is_array() || parsed[3].empty()) {
+                return false;
+            }
+
+            for (auto& value : parsed[3]) {
+                if (!value.is_number_integer() && !value.is_string()) {
+                    return false;
+                }
+            }
+
+            target.values = parsed[3];
+
+            if (target.Fingerprint() != target.fingerprint) {
+                return false; /* damaged or hand-edited */
+            }
+        }
+
+        return true;
+    }
+    catch (...) {
+        /* not json; fall through */
+    }
+
+    return false;
+}
+
+bool QueryCursor::Resolve(
+    Connection& db,
+    const std::string& sql,
+    size_t size,
+    Reader read)
+{
+    if (!this->values.empty()) {
+        /* the key came with the cursor; the anchor row may have been
+        removed or changed since, but that doesn't matter. */
+        return this->values.size() == size;
+    }
+
+    Statement stmt(sql.c_str(), db);
+
+    for (size_t i = 0; i < this->ids.size(); i++) {
+        stmt.BindInt64((int) i, this->ids[i]);
+    }
+
+    if (stmt.Step() != Row) {
+        return false; /* anchor row is gone */
+    }
+
+    QueryCursor resolved;
+    read(stmt, resolved);
+
+    if (resolved.Size() != size ||
+        resolved.ids != this->ids ||
+        resolved.Fingerprint() != this->fingerprint)
+    {
+        return false; /* anchor row's sort key changed */
+    }
+
+    this->values = resolved.values;
+    return true;
+}
+
+std::string QueryCursor::Predicate(const std::string& columns) const {
+    std::string placeholders;
+    for (size_t i = 0; i < this->values.size(); i++) {
+        placeholders += (i == 0) ? "?" : ", ?";
+    }
+    return " AND (" + columns + ") > (" + placeholders + ") ";
+}
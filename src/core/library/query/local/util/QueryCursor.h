@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/library/query/local/util/CategoryQueryUtil.h>
+#include <core/db/Connection.h>
+#include <core/db/Statement.h>
+#include <json.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace musik { namespace core { namespace db { namespace local {
+
+    /* an opaque position in a keyset-paginated result: the sort key values
+    of the last row returned, in ORDER BY order. the next page is selected
+    with a row-value predicate like "(c1, c2, id) > (?, ?, ?)", so it costs
+    the same regardless of how deep it is.
+
+    the encoded form carries the sort key itself, so a cursor stays valid
+    even if its anchor row is deleted or re-tagged in the meantime; paging
+    simply continues from where that row used to sort. it also holds the ids
+    that identify the anchor row and a fingerprint of the key. names are
+    unbounded, so if the key would make the cursor longer than
+    MAX_ENCODED_LENGTH it's left out, and Resolve() reloads it from the
+    anchor row instead (which then must still exist, unchanged). the encoded
+    form is also tagged with the kind of query it came from, so a cursor
+    can't be replayed against a different ordering. */
+    class QueryCursor {
+        public:
+            /* reads a row's sort key from a statement into a cursor */
+            using Reader = std::function<void(Statement&, QueryCursor&)>;
+
+            /* including the terminator, encoded cursors always fit in a
+            buffer of MAX_ENCODED_LENGTH + 1 bytes */
+            static const size_t MAX_ENCODED_LENGTH = 4095;
+
+            QueryCursor();
+
+            void Clear();
+            bool Empty() const { return this->ids.empty(); }
+            size_t Size() const { return this->values.size(); }
+
+            void Add(const std::string& value);
+            void Add(int64_t value);
+
+            /* a sort key value that also identifies the row */
+            void AddId(int64_t value);
+
+            /* binds the values, in order, for a predicate built by Predicate().
+            only valid for cursors that were built with Add*() or resolved. */
+            void Append(category::ArgumentList& args) const;
+
+            std::string Encode(const std::string& kind) const;
+
+            /* returns false if `encoded` is malformed or from another kind of
+            query. the result must be resolved before it's used. */
+            static bool Decode(
+                const std::string& encoded,
+                const std::string& kind,
+                QueryCursor& target);
+
+            /* makes the sort key available to Predicate() and Append(). if the
+            cursor carried its key, that's used as-is and nothing is queried.
+            otherwise runs `sql` with the decoded ids bound in order and reads
+            the first row with `read`. returns false if the key doesn't have
+            exactly `size` values, or had to be reloaded and the anchor row no
+            longer exists or no longer matches the fingerprint. */
+            bool Resolve(
+                Connection& db,
+                const std::string& sql,
+                size_t size,
+                Reader read);
+
+            /* e.g. " AND (al.name, tracks.id) > (?, ?) ". `columns` must list
+            one column per value, in the same order as the ORDER BY clause */
+            std::string Predicate(const std::string& columns) const;
+
+        private:
+            std::string Fingerprint() const;
+
+            nlohmann::json values;
+            std::vector<int64_t> ids;
+            std::string fingerprint; /* set by Decode() */
+    };
+
+} } } }
@@ -44,6 +44,7 @@
 
 #include <boost/lexical_cast.hpp>
 #include <unordered_map>
+#include <vector>
 
 using namespace musik::core;
 using namespace musik::core::sdk;
@@ -392,6 +393,9 @@ int64_t IndexerTrack::SaveThumbnail(db::Connection& connection, const std::strin
         if (thumbs.Step() == db::Row) {
             thumbnailId = thumbs.ColumnInt64(0); /* thumbnail already exists */
         }
+        else {
+            thumbnailId = this->ResolveLegacyThumbnail(connection, libraryDirectory, sum);
+        }
 
         if (thumbnailId == 0) { /* doesn't exist yet, let's insert the record and write the file */
             db::Statement insertThumb("INSERT INTO thumbnails (filesize,checksum) VALUES (?,?)", connection);
@@ -422,6 +426,66 @@ int64_t IndexerTrack::SaveThumbnail(db::Connection& connection, const std::strin
     return thumbnailId;
 }
 
+int64_t IndexerTrack::ResolveLegacyThumbnail(
+    db::Connection& connection, const std::string& libraryDirectory, int64_t sum)
+{
+    /* rows written before checksums were content hashes have checksum=0.
+    recompute them from disk, a file size at a time, as we run into them. */
+    int64_t thumbnailId = 0;
+    const int size = this->internalMetadata->thumbnailSize;
+
+    std::vector<int64_t> candidates;
+    {
+        db::Statement legacy("SELECT id FROM thumbnails WHERE filesize=? AND checksum=0", connection);
+        legacy.BindInt32(0, size);
+        while (legacy.Step() == db::Row) {
+            candidates.push_back(legacy.ColumnInt64(0));
+        }
+    }
+
+    if (candidates.empty()) {
+        return 0;
+    }
+
+    db::Statement update("UPDATE thumbnails SET checksum=? WHERE id=?", connection);
+    std::vector<char> data((size_t) size);
+
+    for (int64_t id : candidates) {
+        std::string filename = libraryDirectory + "thumbs/" + std::to_string(id) + ".jpg";
+
+#ifdef WIN32
+        FILE *thumbFile = _wfopen(u8to16(filename).c_str(), L"rb");
+#else
+        FILE *thumbFile = fopen(filename.c_str(), "rb");
+#endif
+
+        if (!thumbFile) {
+            continue;
+        }
+
+        size_t read = fread(data.data(), sizeof(char), data.size(), thumbFile);
+        fclose(thumbFile);
+
+        if (read != data.size()) {
+            continue;
+        }
+
+        int64_t checksum = Checksum(data.data(), (unsigned int) data.size());
+
+        update.Reset();
+        update.BindInt64(0, checksum);
+        update.BindInt64(1, id);
+        update.Step();
+
+        if (checksum == sum) {
+            thumbnailId = id;
+            break;
+        }
+    }
+
+    return thumbnailId;
+}
+
 void IndexerTrack::ProcessNonStandardMetadata(db::Connection& connection) {
     MetadataMap unknownFields(this->internalMetadata->metadata);
     removeKnownFields(unknownFields);
@@ -706,31 +770,25 @@ void IndexerTrack::SaveDirectory(db::Connection& db, const std::string& filename
             boost::filesystem::path(filename).parent_path().string());
 
         int64_t dirId = -1;
-        if (metadataIdCache.find("directoryId-" + dir) != metadataIdCache.end()) {
-            dirId = metadataIdCache["directoryId-" + dir];
+        std::string cacheKey = "directoryId-" + dir;
+        if (metadataIdCache.find(cacheKey) != metadataIdCache.end()) {
+            dirId = metadataIdCache[cacheKey];
         }
         else {
-            db::Statement find("SELECT id FROM directories WHERE name=?", db);
-            find.BindText(0, dir.c_str());
-            if (find.Step() == db::Row) {
-                dirId = find.ColumnInt64(0);
-            }
-            else {
-                db::Statement insert("INSERT INTO directories (name) VALUES (?)", db);
-                insert.BindText(0, dir);
-                if (insert.Step() == db::Done) {
-                    dirId = db.LastInsertedId();
-                }
-            }
-
+            /* also creates any missing ancestors, so the directory tree
+            stays walkable while we're still indexing */
+            dirId = library::LocalLibrary::SaveDirectory(db, dir);
             if (dirId != -1) {
-                db::Statement update("UPDATE tracks SET directory_id=? WHERE id=?", db);
-                update.BindInt64(0, dirId);
-                update.BindInt64(1, this->id);
-                update.Step();
+                metadataIdCache[cacheKey] = dirId;
             }
         }
 
+        if (dirId != -1) {
+            db::Statement update("UPDATE tracks SET directory_id=? WHERE id=?", db);
+            update.BindInt64(0, dirId);
+            update.BindInt64(1, this->id);
+            update.Step();
+        }
     }
     catch (...) {
         /* not much we can do, but we don't want the app to die if we're
@@ -62,10 +62,11 @@ namespace musik { namespace core {
             virtual std::string Uri();
             virtual int Uri(char* dst, int size);
 
-            virtual MetadataIteratorRange GetValues(const char* metakey);
-            virtual MetadataIteratorRange GetAllValues();
             virtual TrackPtr Copy();
 
+            MetadataIteratorRange GetValues(const char* metakey);
+            MetadataIteratorRange GetAllValues();
+
             virtual int64_t GetId();
             virtual void SetId(int64_t id) { this->id = id; }
 
@@ -104,6 +105,11 @@ namespace musik { namespace core {
                 db::Connection& connection,
                 const std::string& libraryDirectory);
 
+            int64_t ResolveLegacyThumbnail(
+                db::Connection& connection,
+                const std::string& libraryDirectory,
+                int64_t checksum);
+
             int64_t SaveGenre(db::Connection& connection);
 
             int64_t SaveArtist(db::Connection& connection);
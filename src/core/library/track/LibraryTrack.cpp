@@ -42,40 +42,196 @@
 #include <core/db/Statement.h>
 #include <core/library/LocalLibrary.h>
 
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
 using namespace musik::core;
 
+enum class FieldType : int { Int, String, Interned };
+
+struct LibraryTrack::Field {
+    const char* name;
+    FieldType type;
+    int index;
+    uint32_t bit;
+};
+
+#define FIELD(name, type, index, bit) { name, FieldType::type, index, 1u << bit }
+
+const LibraryTrack::Field LibraryTrack::FIELDS[] = {
+    FIELD("title", String, FieldTitle, 0),
+    FIELD("filename", String, FieldFilename, 1),
+    FIELD("album", Interned, FieldAlbum, 2),
+    FIELD("artist", Interned, FieldArtist, 3),
+    FIELD("genre", Interned, FieldGenre, 4),
+    FIELD("track", Int, FieldTrack, 5),
+    FIELD("disc", Int, FieldDisc, 6),
+    FIELD("duration", Int, FieldDuration, 7),
+    FIELD("filesize", Int, FieldFilesize, 8),
+    FIELD("thumbnail_id", Int, FieldThumbnailId, 9),
+    FIELD("filetime", Int, FieldFiletime, 10),
+    FIELD("visual_genre_id", Int, FieldVisualGenreId, 11),
+    FIELD("visual_artist_id", Int, FieldVisualArtistId, 12),
+    FIELD("album_artist_id", Int, FieldAlbumArtistId, 13),
+    FIELD("album_id", Int, FieldAlbumId, 14),
+};
+
+#undef FIELD
+
+/* album, artist and genre names are shared by many tracks, so we keep a
+single, reference counted copy of each and point at it. when the last track
+referencing a string goes away, it's removed from the table. the table is
+intentionally leaked so tracks that outlive static destruction are safe. */
+struct InternTable {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<const std::string>> strings;
+};
+
+static InternTable& internTable() {
+    static InternTable* table = new InternTable();
+    return *table;
+}
+
+static std::shared_ptr<const std::string> intern(const char* value) {
+    InternTable& table = internTable();
+    std::unique_lock<std::mutex> lock(table.mutex);
+
+    auto& entry = table.strings[value];
+    auto result = entry.lock();
+
+    if (!result) {
+        result = std::shared_ptr<const std::string>(
+            new std::string(value),
+            [](const std::string* str) {
+                InternTable& table = internTable();
+                {
+                    std::unique_lock<std::mutex> lock(table.mutex);
+                    auto it = table.strings.find(*str);
+                    /* may have been re-interned after we expired but before
+                    we got the lock; only erase our own (expired) entry. */
+                    if (it != table.strings.end() && it->second.expired()) {
+                        table.strings.erase(it);
+                    }
+                }
+                delete str;
+            });
+
+        entry = result;
+    }
+
+    return result;
+}
+
+/* only canonical integers are stored in an int slot, so reading the value
+back as a string returns exactly what was written. anything else ("01",
+"+1", " 1", "1.0", out of range) is kept verbatim in the overflow map. */
+static bool parseInt64(const char* value, int64_t& result) {
+    if (!value || !*value) {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = strtoll(value, &end, 10);
+
+    if (errno != 0 || *end != '\0') {
+        return false;
+    }
+
+    if (std::to_string(parsed) != value) {
+        return false;
+    }
+
+    result = (int64_t) parsed;
+    return true;
+}
+
+size_t LibraryTrack::InternedStringCount() {
+    InternTable& table = internTable();
+    std::unique_lock<std::mutex> lock(table.mutex);
+    return table.strings.size();
+}
+
 LibraryTrack::LibraryTrack()
-: id(0)
-, libraryId(0) {
+: LibraryTrack(0, 0) {
 }
 
 LibraryTrack::LibraryTrack(int64_t id, int libraryId)
 : id(id)
-, libraryId(libraryId) {
+, libraryId(libraryId)
+, fieldsSet(0) {
+    std::fill(std::begin(this->intFields), std::end(this->intFields), 0);
 }
 
 LibraryTrack::LibraryTrack(int64_t id, musik::core::ILibraryPtr library)
-: id(id)
-, libraryId(library->Id()) {
+: LibraryTrack(id, library->Id()) {
 }
 
 LibraryTrack::~LibraryTrack() {
 }
 
-std::string LibraryTrack::GetString(const char* metakey) {
-    std::unique_lock<std::mutex> lock(this->mutex);
-    MetadataMap::iterator metavalue = this->metadata.find(metakey);
-    if (metavalue != this->metadata.end()) {
+const LibraryTrack::Field* LibraryTrack::FindField(const char* metakey) {
+    for (const Field& field : FIELDS) {
+        if (strcmp(field.name, metakey) == 0) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+bool LibraryTrack::IsSet(const Field* field) {
+    return (this->fieldsSet & field->bit) != 0;
+}
+
+void LibraryTrack::MarkSet(const Field* field, bool set) {
+    if (set) {
+        this->fieldsSet |= field->bit;
+    }
+    else {
+        this->fieldsSet &= ~field->bit;
+    }
+}
+
+std::string LibraryTrack::GetStringInternal(const char* metakey) {
+    const Field* field = FindField(metakey);
+
+    if (field && this->IsSet(field)) {
+        switch (field->type) {
+            case FieldType::Int: return std::to_string(this->intFields[field->index]);
+            case FieldType::String: return this->stringFields[field->index];
+            case FieldType::Interned: return *this->internedFields[field->index];
+        }
+    }
+
+    MetadataMap::iterator metavalue = this->overflow.find(metakey);
+    if (metavalue != this->overflow.end()) {
         return metavalue->second;
     }
+
     return "";
 }
 
+std::string LibraryTrack::GetString(const char* metakey) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return this->GetStringInternal(metakey);
+}
+
 long long LibraryTrack::GetInt64(const char* key, long long defaultValue) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    const Field* field = FindField(key);
+    if (field && field->type == FieldType::Int && this->IsSet(field)) {
+        return this->intFields[field->index];
+    }
+
     try {
-        std::string value = GetString(key);
+        std::string value = this->GetStringInternal(key);
         if (value.size()) {
-            return std::stoll(GetString(key));
+            return std::stoll(value);
         }
     }
     catch (...) {
@@ -84,10 +240,17 @@ long long LibraryTrack::GetInt64(const char* key, long long defaultValue) {
 }
 
 int LibraryTrack::GetInt32(const char* key, unsigned int defaultValue) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    const Field* field = FindField(key);
+    if (field && field->type == FieldType::Int && this->IsSet(field)) {
+        return (int) this->intFields[field->index];
+    }
+
     try {
-        std::string value = GetString(key);
+        std::string value = this->GetStringInternal(key);
         if (value.size()) {
-            return std::stol(GetString(key));
+            return std::stol(value);
         }
     }
     catch (...) {
@@ -96,10 +259,17 @@ int LibraryTrack::GetInt32(const char* key, unsigned int defaultValue) {
 }
 
 double LibraryTrack::GetDouble(const char* key, double defaultValue) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    const Field* field = FindField(key);
+    if (field && field->type == FieldType::Int && this->IsSet(field)) {
+        return (double) this->intFields[field->index];
+    }
+
     try {
-        std::string value = GetString(key);
+        std::string value = this->GetStringInternal(key);
         if (value.size()) {
-            return std::stod(GetString(key));
+            return std::stod(value);
         }
     }
     catch (...) {
@@ -109,17 +279,60 @@ double LibraryTrack::GetDouble(const char* key, double defaultValue) {
 
 void LibraryTrack::SetValue(const char* metakey, const char* value) {
     std::unique_lock<std::mutex> lock(this->mutex);
-    this->metadata.insert(std::pair<std::string, std::string>(metakey,value));
+
+    const Field* field = FindField(metakey);
+
+    if (field) {
+        /* the first value wins. this matches the old multimap behavior,
+        where lookups always returned the first value inserted for a key. */
+        if (this->IsSet(field) || this->overflow.find(metakey) != this->overflow.end()) {
+            return;
+        }
+
+        switch (field->type) {
+            case FieldType::Int:
+                if (!parseInt64(value, this->intFields[field->index])) {
+                    break; /* not canonical; keep it verbatim in the overflow map */
+                }
+                this->MarkSet(field, true);
+                return;
+            case FieldType::String:
+                this->stringFields[field->index] = value;
+                this->MarkSet(field, true);
+                return;
+            case FieldType::Interned:
+                this->internedFields[field->index] = intern(value);
+                this->MarkSet(field, true);
+                return;
+        }
+    }
+
+    this->overflow.insert(std::pair<std::string, std::string>(metakey, value));
 }
 
 void LibraryTrack::ClearValue(const char* metakey) {
     std::unique_lock<std::mutex> lock(this->mutex);
-    this->metadata.erase(metakey);
+
+    const Field* field = FindField(metakey);
+    if (field) {
+        switch (field->type) {
+            case FieldType::Int: this->intFields[field->index] = 0; break;
+            case FieldType::String: this->stringFields[field->index].clear(); break;
+            case FieldType::Interned: this->internedFields[field->index].reset(); break;
+        }
+        this->MarkSet(field, false);
+    }
+
+    this->overflow.erase(metakey);
 }
 
 bool LibraryTrack::Contains(const char* metakey) {
     std::unique_lock<std::mutex> lock(this->mutex);
-    return this->metadata.find(metakey) != this->metadata.end();
+    const Field* field = FindField(metakey);
+    if (field && this->IsSet(field)) {
+        return true;
+    }
+    return this->overflow.find(metakey) != this->overflow.end();
 }
 
 void LibraryTrack::SetThumbnail(const char *data, long size) {
@@ -145,19 +358,6 @@ int LibraryTrack::Uri(char* dst, int size) {
     return CopyString(this->Uri(), dst, size);
 }
 
-Track::MetadataIteratorRange LibraryTrack::GetValues(const char* metakey) {
-    std::unique_lock<std::mutex> lock(this->mutex);
-    return this->metadata.equal_range(metakey);
-}
-
-Track::MetadataIteratorRange LibraryTrack::GetAllValues() {
-    return Track::MetadataIteratorRange(
-        this->metadata.begin(),
-        this->metadata.end());
-
-    return Track::MetadataIteratorRange();
-}
-
 int64_t LibraryTrack::GetId() {
     return this->id;
 }
@@ -39,6 +39,7 @@
 #include <core/library/LocalLibrary.h>
 #include <core/db/Connection.h>
 #include <mutex>
+#include <memory>
 
 namespace musik { namespace core {
 
@@ -71,16 +72,63 @@ namespace musik { namespace core {
             virtual int GetString(const char* key, char* dst, int size);
             virtual int Uri(char* dst, int size);
 
-            virtual MetadataIteratorRange GetValues(const char* metakey);
-            virtual MetadataIteratorRange GetAllValues();
             virtual TrackPtr Copy();
 
             static bool Load(Track *target, db::Connection &db);
 
+            /* number of distinct album, artist and genre strings currently
+            shared by live tracks */
+            static size_t InternedStringCount();
+
         private:
+            /* the well-known fields are stored in fixed, typed slots. integer
+            fields stay integers, and the heavily repeated album, artist and
+            genre strings are interned and shared across all tracks. only
+            extended tags (and values that don't fit their slot, including
+            non-canonical integers like "01") end up in the overflow map. */
+            enum IntField {
+                FieldTrack = 0,
+                FieldDisc,
+                FieldDuration,
+                FieldFilesize,
+                FieldThumbnailId,
+                FieldFiletime,
+                FieldVisualGenreId,
+                FieldVisualArtistId,
+                FieldAlbumArtistId,
+                FieldAlbumId,
+                IntFieldCount
+            };
+
+            enum StringField {
+                FieldTitle = 0,
+                FieldFilename,
+                StringFieldCount
+            };
+
+            enum InternedField {
+                FieldAlbum = 0,
+                FieldArtist,
+                FieldGenre,
+                InternedFieldCount
+            };
+
+            struct Field;
+
+            static const Field FIELDS[];
+            static const Field* FindField(const char* metakey);
+
+            bool IsSet(const Field* field);
+            void MarkSet(const Field* field, bool set);
+            std::string GetStringInternal(const char* metakey);
+
             int64_t id;
             int libraryId;
-            Track::MetadataMap metadata;
+            uint32_t fieldsSet;
+            int64_t intFields[IntFieldCount];
+            std::string stringFields[StringFieldCount];
+            std::shared_ptr<const std::string> internedFields[InternedFieldCount];
+            Track::MetadataMap overflow;
             std::mutex mutex;
     };
 
@@ -109,8 +109,6 @@ class SdkWrapper : public Track {
         virtual void SetId(int64_t id) override { NO_IMPL }
         virtual std::string GetString(const char* metakey) override { NO_IMPL }
         virtual std::string Uri() override { NO_IMPL }
-        virtual MetadataIteratorRange GetValues(const char* metakey) override { NO_IMPL }
-        virtual MetadataIteratorRange GetAllValues() override { NO_IMPL }
         virtual TrackPtr Copy() override { NO_IMPL }
         #undef NO_IMPL
 
@@ -91,8 +91,6 @@ namespace musik { namespace core {
             virtual void SetId(int64_t id) = 0;
             virtual std::string GetString(const char* metakey) = 0;
             virtual std::string Uri() = 0;
-            virtual MetadataIteratorRange GetValues(const char* metakey) = 0;
-            virtual MetadataIteratorRange GetAllValues() = 0;
             virtual TrackPtr Copy() = 0;
 
             /* for SDK interop */
@@ -40,6 +40,7 @@
 #include <core/library/LocalLibraryConstants.h>
 #include <core/library/track/Track.h>
 #include <core/library/query/local/TrackMetadataQuery.h>
+#include <core/library/query/local/TrackMetadataBatchQuery.h>
 #include <core/library/query/local/util/SdkWrappers.h>
 #include <core/db/Connection.h>
 #include <core/db/Statement.h>
@@ -54,18 +55,21 @@ using namespace musik::core::library;
 using namespace musik::core::db::local;
 using namespace musik::core::sdk;
 
-TrackList::TrackList(ILibraryPtr library) {
+TrackList::TrackList(ILibraryPtr library)
+: cacheSize(MAX_SIZE) {
     this->library = library;
 }
 
 TrackList::TrackList(TrackList* other)
 : ids(other->ids)
-, library(other->library) {
+, library(other->library)
+, cacheSize(MAX_SIZE) {
     this->library = library;
 }
 
 TrackList::TrackList(ILibraryPtr library, const int64_t* trackIds, size_t trackIdCount)
-: library(library) {
+: library(library)
+, cacheSize(MAX_SIZE) {
     if (trackIdCount > 0) {
         this->ids.insert(this->ids.end(), &trackIds[0], &trackIds[trackIdCount]);
     }
@@ -127,7 +131,7 @@ TrackPtr TrackList::Get(size_t index) const {
         auto id = this->ids.at(index);
         auto cached = this->GetFromCache(id);
 
-        if (cached) {
+        if (cached || this->notFound.find(id) != this->notFound.end()) {
             return cached;
         }
 
@@ -149,6 +153,96 @@ TrackPtr TrackList::Get(size_t index) const {
     return TrackPtr();
 }
 
+TrackPtr TrackList::GetIfCached(size_t index) const {
+    if (index < this->ids.size()) {
+        return this->GetFromCache(this->ids[index]);
+    }
+    return TrackPtr();
+}
+
+bool TrackList::IsMissing(size_t index) const {
+    return index < this->ids.size() &&
+        this->notFound.find(this->ids[index]) != this->notFound.end();
+}
+
+void TrackList::CacheWindow(size_t from, size_t to, bool async) {
+    to = std::min(to, this->ids.size());
+
+    std::vector<int64_t> missing;
+    for (size_t i = from; i < to; i++) {
+        auto id = this->ids[i];
+        if (this->cacheMap.find(id) == this->cacheMap.end() &&
+            this->pending.find(id) == this->pending.end() &&
+            this->notFound.find(id) == this->notFound.end())
+        {
+            missing.push_back(id);
+        }
+    }
+
+    if (!missing.size()) {
+        return;
+    }
+
+    auto query = std::make_shared<TrackMetadataBatchQuery>(missing, this->library);
+
+    /* the list may be swapped out and destroyed before an asynchronous query
+    finishes, so the callback holds a weak reference. lists that aren't owned
+    by a shared_ptr can't be referenced that way; load those inline. */
+    std::weak_ptr<TrackList> weak;
+    if (async) {
+        try {
+            weak = shared_from_this();
+        }
+        catch (const std::bad_weak_ptr&) {
+            async = false;
+        }
+    }
+
+    if (!async) {
+        this->library->Enqueue(query, ILibrary::QuerySynchronous);
+        if (query->GetStatus() == IQuery::Finished) {
+            this->CacheResult(*query);
+        }
+        return;
+    }
+
+    this->pending.insert(missing.begin(), missing.end());
+
+    this->library->Enqueue(query, 0, [weak, query](auto q) {
+        auto self = weak.lock();
+        if (self) {
+            for (auto id : query->GetTrackIds()) {
+                self->pending.erase(id);
+            }
+
+            if (query->GetStatus() == IQuery::Finished) {
+                self->CacheResult(*query);
+                self->WindowCached();
+            }
+        }
+    });
+}
+
+void TrackList::CacheResult(TrackMetadataBatchQuery& query) {
+    auto result = query.GetResult();
+
+    for (auto it : *result) {
+        this->AddToCache(it.first, it.second);
+    }
+
+    /* remember ids without a row, otherwise every redraw would request
+    them again. */
+    for (auto id : query.GetTrackIds()) {
+        if (result->find(id) == result->end()) {
+            this->notFound.insert(id);
+        }
+    }
+}
+
+void TrackList::SetCacheWindowSize(size_t size) {
+    this->cacheSize = std::max((size_t) MAX_SIZE, size);
+}
+
 ITrack* TrackList::GetTrack(size_t index) const {
     return this->Get(index)->GetSdkValue();
 }
@@ -187,6 +281,7 @@ void TrackList::Clear() {
 void TrackList::ClearCache() {
     this->cacheList.clear();
     this->cacheMap.clear();
+    this->notFound.clear();
 }
 
 void TrackList::Swap(TrackList& tl) {
@@ -217,7 +312,7 @@ void TrackList::AddToCache(int64_t key, TrackPtr value) const {
     cacheList.push_front(key);
     this->cacheMap[key] = std::make_pair(value, cacheList.begin());
 
-    if (this->cacheMap.size() > MAX_SIZE) {
+    while (this->cacheMap.size() > this->cacheSize) {
         auto last = cacheList.end();
         --last;
         cacheMap.erase(this->cacheMap.find(*last));
@@ -40,9 +40,16 @@
 #include <core/library/track/Track.h>
 #include <core/library/ILibrary.h>
 
+#include <sigslot/sigslot.h>
+
 #include <unordered_map>
+#include <unordered_set>
 #include <list>
 
+namespace musik { namespace core { namespace db { namespace local {
+    class TrackMetadataBatchQuery;
+} } } }
+
 namespace musik { namespace core {
 
     class TrackList :
@@ -74,6 +81,10 @@ namespace musik { namespace core {
 
             /* implementation specific */
             TrackPtr Get(size_t index) const;
+            TrackPtr GetIfCached(size_t index) const;
+            bool IsMissing(size_t index) const;
+            void CacheWindow(size_t from, size_t to, bool async);
+            void SetCacheWindowSize(size_t size);
             void ClearCache();
             void Swap(TrackList& list);
             void CopyFrom(const TrackList& from);
@@ -81,6 +92,10 @@ namespace musik { namespace core {
 
             musik::core::sdk::ITrackList* GetSdkValue();
 
+            /* raised on the library's message queue when an asynchronous
+            CacheWindow() request has been loaded */
+            sigslot::signal0<> WindowCached;
+
         private:
             typedef std::list<int64_t> CacheList;
             typedef std::pair<TrackPtr, CacheList::iterator> CacheValue;
@@ -88,10 +103,19 @@ namespace musik { namespace core {
 
             TrackPtr GetFromCache(int64_t key) const;
             void AddToCache(int64_t key, TrackPtr value) const;
+            void CacheResult(musik::core::db::local::TrackMetadataBatchQuery& query);
 
             /* lru cache structures */
             mutable CacheList cacheList;
             mutable CacheMap cacheMap;
+            size_t cacheSize;
+
+            /* ids with an outstanding asynchronous request */
+            std::unordered_set<int64_t> pending;
+
+            /* ids that were requested but have no row in the database.
+            they aren't requested again until the cache is cleared. */
+            mutable std::unordered_set<int64_t> notFound;
 
             std::vector<int64_t> ids;
             ILibraryPtr library;
@@ -48,6 +48,7 @@
 #include <core/library/LocalSimpleDataProvider.h>
 #include <core/runtime/Message.h>
 #include <core/support/Messages.h>
+#include <core/support/Metrics.h>
 
 #include <core/sdk/IIndexerNotifier.h>
 #include <core/sdk/IEnvironment.h>
@@ -103,7 +104,9 @@ static class Environment : public IEnvironment {
         }
 
         virtual IDecoder* GetDecoder(IDataStream* stream) override {
-            return streams::GetDecoderForDataStream(stream);
+            /* plugins ask for decoders to read (e.g. transcode) a stream,
+            not to play it back */
+            return streams::GetDecoderForDataStream(stream, DecodeIntent::Sequential);
         }
 
         virtual IEncoder* GetEncoder(const char* type) override {
@@ -228,6 +231,10 @@ static class Environment : public IEnvironment {
                 playback->ReloadOutput();
             }
         }
+
+        virtual size_t GetMetrics(MetricsFormat format, char* dst, size_t size) override {
+            return CopyString(metrics::Render(format), dst, size);
+        }
 } environment;
 
 namespace musik { namespace core { namespace plugin {
@@ -43,17 +43,32 @@ using namespace musik::core::runtime;
 
 using LockT = std::unique_lock<std::mutex>;
 
-MessageQueue::MessageQueue() {
+/* recycled nodes beyond this many are freed instead of pooled */
+static const size_t MAX_FREE_LIST_SIZE = 256;
+
+MessageQueue::MessageQueue()
+: receivers(std::make_shared<ReceiverList>())
+, nextSequence(0) {
     this->nextMessageTime.store(1);
 }
 
+MessageQueue::~MessageQueue() {
+    for (auto m : this->heap) {
+        delete m;
+    }
+
+    for (auto m : this->freeList) {
+        delete m;
+    }
+}
+
 void MessageQueue::WaitAndDispatch(int64_t timeoutMillis) {
     {
         LockT lock(this->queueMutex);
 
-        if (this->queue.size()) {
+        if (this->heap.size()) {
             auto waitTime = duration_cast<milliseconds>(
-                this->queue.front()->time -
+                this->heap.front()->time -
                 system_clock::now().time_since_epoch());
 
             if (timeoutMillis >= 0) {
@@ -80,10 +95,6 @@ void MessageQueue::WaitAndDispatch(int64_t timeoutMillis) {
     this->Dispatch();
 }
 
-MessageQueue::~MessageQueue() {
-
-}
-
 void MessageQueue::Dispatch() {
     milliseconds now = duration_cast<milliseconds>(
         system_clock::now().time_since_epoch());
@@ -94,87 +105,85 @@ void MessageQueue::Dispatch() {
         return; /* short circuit before any iteration. */
     }
 
-    using Iterator = std::list<EnqueuedMessage*>::iterator;
-
     {
         LockT lock(this->queueMutex);
 
-        this->nextMessageTime.store(-1);
-
-        Iterator it = this->queue.begin();
-
-        bool done = false;
-        while (!done && it != this->queue.end()) {
-            /* messages are time-ordered. pop and dispatch one at a time
-            until we get to a message that should be delivered in the future,
-            or the queue has been exhausted. */
-
-            EnqueuedMessage *m = (*it);
-
-            if (now >= m->time) {
-                this->dispatch.push_back(m);
-                it = this->queue.erase(it);
-            }
-            else {
-                done = true;
-            }
+        /* pop and dispatch until we get to a message that should be
+        delivered in the future, or the queue has been exhausted. */
+        while (this->heap.size() && now >= this->heap.front()->time) {
+            EnqueuedMessage* m = this->heap.front();
+            this->dispatch.push_back(m->message);
+            this->Dequeue(m);
+            this->Recycle(m);
         }
+
+        this->UpdateNextMessageTime();
     }
 
     /* dispatch outside of the critical section */
 
-    Iterator it = this->dispatch.begin();
-    while (it != this->dispatch.end()) {
-        this->Dispatch((*it)->message);
-        delete *it;
-        it++;
+    for (auto& message : this->dispatch) {
+        this->Dispatch(message);
     }
 
     this->dispatch.clear();
-
-    if (this->queue.size()) {
-        this->nextMessageTime.store((*this->queue.begin())->time.count());
-    }
 }
 
 void MessageQueue::RegisterForBroadcasts(IMessageTargetPtr target) {
     LockT lock(this->queueMutex);
-    this->receivers.insert(target);
+
+    /* a target registers at most once, otherwise it'd receive each
+    broadcast multiple times. */
+    for (auto& receiver : *this->receivers) {
+        if (receiver.lock() == target) {
+            return;
+        }
+    }
+
+    /* receivers are copy-on-write: dispatch holds on to whichever snapshot
+    was current when it started, without copying or locking. */
+    auto updated = std::make_shared<ReceiverList>(*this->receivers);
+    updated->push_back(target);
+    this->receivers = updated;
 }
 
 void MessageQueue::UnregisterForBroadcasts(IMessageTarget *target) {
     LockT lock(this->queueMutex);
-    for (auto it : this->receivers) {
-        auto shared = it.lock();
-        if (shared && shared.get() == target) {
-            this->receivers.erase(it);
-            return;
+
+    auto updated = std::make_shared<ReceiverList>();
+    for (auto& receiver : *this->receivers) {
+        auto shared = receiver.lock();
+        if (shared && shared.get() != target) {
+            updated->push_back(receiver);
         }
     }
+
+    this->receivers = updated;
 }
 
 int MessageQueue::Remove(IMessageTarget *target, int type) {
     LockT lock(this->queueMutex);
 
     int count = 0;
-    std::list<EnqueuedMessage*>::iterator it = this->queue.begin();
-    while (it != this->queue.end()) {
-        IMessagePtr current = (*it)->message;
-
-        if (current->Target() == target) {
-            if (type == -1 || type == current->Type()) {
-                delete (*it);
-                it = this->queue.erase(it);
+
+    auto it = this->targets.find(target);
+    if (it != this->targets.end()) {
+        EnqueuedMessage* m = it->second;
+        while (m) {
+            EnqueuedMessage* next = m->nextForTarget;
+
+            if (type == -1 || type == m->message->Type()) {
+                this->Dequeue(m); /* may invalidate `it` */
+                this->Recycle(m);
                 ++count;
-                continue;
             }
-        }
 
-        ++it;
+            m = next;
+        }
     }
 
-    if (this->queue.size()) {
-        this->nextMessageTime.store((*this->queue.begin())->time.count());
+    if (count) {
+        this->UpdateNextMessageTime();
     }
 
     return count;
@@ -183,18 +192,15 @@ int MessageQueue::Remove(IMessageTarget *target, int type) {
 bool MessageQueue::Contains(IMessageTarget *target, int type) {
     LockT lock(this->queueMutex);
 
-    std::list<EnqueuedMessage*>::iterator it = this->queue.begin();
-    while (it != this->queue.end()) {
-        IMessagePtr current = (*it)->message;
-
-        if (current->Target() == target) {
-            if (type == -1 || type == current->Type()) {
+    auto it = this->targets.find(target);
+    if (it != this->targets.end()) {
+        for (EnqueuedMessage* m = it->second; m; m = m->nextForTarget) {
+            if (type == -1 || type == m->message->Type()) {
                 return true;
             }
         }
-
-        ++it;
     }
+
     return false;
 }
 
@@ -214,32 +220,16 @@ void MessageQueue::Post(IMessagePtr message, int64_t delayMs) {
     milliseconds now = duration_cast<milliseconds>(
         system_clock::now().time_since_epoch());
 
-    EnqueuedMessage *m = new EnqueuedMessage();
+    EnqueuedMessage *m = this->Allocate();
     m->message = message;
     m->time = now + milliseconds(delayMs);
+    m->sequence = this->nextSequence++;
 
-    /* the queue is time ordered. start from the front of the queue, and
-    work our way back until we find the correct place to insert the new one */
-
-    typedef std::list<EnqueuedMessage*>::iterator Iterator;
-    Iterator curr = this->queue.begin();
-
-    while (curr != this->queue.end()) {
-        if ((*curr)->time <= m->time) {
-            curr++;
-        }
-        else {
-            break;
-        }
-    }
-
-    bool first = (curr == this->queue.begin());
+    this->Enqueue(m);
 
-    this->queue.insert(curr, m);
+    bool first = (this->heap.front() == m);
 
-    if (this->queue.size()) {
-        this->nextMessageTime.store((*this->queue.begin())->time.count());
-    }
+    this->UpdateNextMessageTime();
 
     if (first) {
         this->waitForDispatch.notify_all();
@@ -256,20 +246,16 @@ void MessageQueue::Dispatch(IMessagePtr message) {
         message->Target()->ProcessMessage(*message);
     }
     else {
-        std::set<IWeakMessageTarget, WeakPtrLess> copy;
+        std::shared_ptr<const ReceiverList> snapshot;
 
-        /* copy to dispatch outside of a lock */
         {
             LockT lock(this->queueMutex);
-            std::copy(
-                receivers.begin(),
-                receivers.end(),
-                std::inserter(copy, copy.begin()));
+            snapshot = this->receivers;
         }
 
         /* dispatch */
         bool prune = false;
-        for (auto receiver : copy) {
+        for (auto& receiver : *snapshot) {
             auto shared = receiver.lock();
             if (shared) {
                 shared->ProcessMessage(*message);
@@ -281,15 +267,134 @@ void MessageQueue::Dispatch(IMessagePtr message) {
 
         if (prune) { /* at least one of our weak_ptrs is dead. */
             LockT lock(this->queueMutex);
-            auto it = this->receivers.begin();
-            while (it != this->receivers.end()) {
-                if (it->expired()) {
-                    it = this->receivers.erase(it);
-                }
-                else {
-                    ++it;
+            auto updated = std::make_shared<ReceiverList>();
+            for (auto& receiver : *this->receivers) {
+                if (!receiver.expired()) {
+                    updated->push_back(receiver);
                 }
             }
+            this->receivers = updated;
         }
     }
 }
+
+/* everything below is called with queueMutex held */
+
+MessageQueue::EnqueuedMessage* MessageQueue::Allocate() {
+    if (this->freeList.size()) {
+        EnqueuedMessage* m = this->freeList.back();
+        this->freeList.pop_back();
+        return m;
+    }
+
+    return new EnqueuedMessage();
+}
+
+void MessageQueue::Recycle(EnqueuedMessage* m) {
+    m->message.reset();
+
+    if (this->freeList.size() < MAX_FREE_LIST_SIZE) {
+        this->freeList.push_back(m);
+    }
+    else {
+        delete m;
+    }
+}
+
+bool MessageQueue::Before(const EnqueuedMessage* a, const EnqueuedMessage* b) const {
+    if (a->time != b->time) {
+        return a->time < b->time;
+    }
+    return a->sequence < b->sequence;
+}
+
+void MessageQueue::Swap(size_t a, size_t b) {
+    std::swap(this->heap[a], this->heap[b]);
+    this->heap[a]->heapIndex = a;
+    this->heap[b]->heapIndex = b;
+}
+
+void MessageQueue::SiftUp(size_t index) {
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!Before(this->heap[index], this->heap[parent])) {
+            break;
+        }
+        this->Swap(index, parent);
+        index = parent;
+    }
+}
+
+void MessageQueue::SiftDown(size_t index) {
+    const size_t size = this->heap.size();
+    while (true) {
+        size_t left = index * 2 + 1, right = left + 1, smallest = index;
+        if (left < size && Before(this->heap[left], this->heap[smallest])) {
+            smallest = left;
+        }
+        if (right < size && Before(this->heap[right], this->heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        this->Swap(index, smallest);
+        index = smallest;
+    }
+}
+
+void MessageQueue::Enqueue(EnqueuedMessage* m) {
+    /* heap */
+    m->heapIndex = this->heap.size();
+    this->heap.push_back(m);
+    this->SiftUp(m->heapIndex);
+
+    /* per-target list; new messages go to the front */
+    EnqueuedMessage*& head = this->targets[m->message->Target()];
+    m->prevForTarget = nullptr;
+    m->nextForTarget = head;
+    if (head) {
+        head->prevForTarget = m;
+    }
+    head = m;
+}
+
+void MessageQueue::Dequeue(EnqueuedMessage* m) {
+    /* heap */
+    size_t index = m->heapIndex;
+    size_t last = this->heap.size() - 1;
+    if (index != last) {
+        this->Swap(index, last);
+        this->heap.pop_back();
+        this->SiftDown(index);
+        this->SiftUp(index);
+    }
+    else {
+        this->heap.pop_back();
+    }
+
+    /* per-target list */
+    if (m->prevForTarget) {
+        m->prevForTarget->nextForTarget = m->nextForTarget;
+    }
+    else {
+        auto target = m->message->Target();
+        if (m->nextForTarget) {
+            this->targets[target] = m->nextForTarget;
+        }
+        else {
+            this->targets.erase(target);
+        }
+    }
+
+    if (m->nextForTarget) {
+        m->nextForTarget->prevForTarget = m->prevForTarget;
+    }
+
+    m->prevForTarget = m->nextForTarget = nullptr;
+}
+
+void MessageQueue::UpdateNextMessageTime() {
+    this->nextMessageTime.store(this->heap.size()
+        ? this->heap.front()->time.count() : -1);
+}
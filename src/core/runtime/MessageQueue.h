@@ -36,12 +36,13 @@
 
 #include "IMessageQueue.h"
 
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <atomic>
-#include <set>
+#include <memory>
 
 namespace musik { namespace core { namespace runtime {
     class MessageQueue : public IMessageQueue {
@@ -66,25 +67,42 @@ namespace musik { namespace core { namespace runtime {
 
         private:
             typedef std::weak_ptr<IMessageTarget> IWeakMessageTarget;
+            typedef std::vector<IWeakMessageTarget> ReceiverList;
 
+            /* pending messages live in a binary min-heap ordered by delivery
+            time (then by post order, so messages due at the same time are
+            delivered fifo). each one is also linked into a per-target list,
+            so Remove(), Contains() and Debounce() only need to look at the
+            messages for a single target. nodes are recycled through a free
+            list instead of being allocated for every Post(). */
             struct EnqueuedMessage {
                 IMessagePtr message;
                 std::chrono::milliseconds time;
-            };
-
-            struct WeakPtrLess { /* https://stackoverflow.com/a/12875729 */
-                template <typename T>
-                bool operator() (const std::weak_ptr<T>& l, const std::weak_ptr<T>& r) const {
-                    return l.lock().get() < r.lock().get();
-                }
+                uint64_t sequence;
+                size_t heapIndex;
+                EnqueuedMessage* prevForTarget;
+                EnqueuedMessage* nextForTarget;
             };
 
             std::mutex queueMutex;
-            std::list<EnqueuedMessage*> queue;
-            std::list<EnqueuedMessage*> dispatch;
-            std::set<IWeakMessageTarget, WeakPtrLess> receivers;
+            std::vector<EnqueuedMessage*> heap;
+            std::vector<EnqueuedMessage*> freeList;
+            std::unordered_map<IMessageTarget*, EnqueuedMessage*> targets;
+            std::vector<IMessagePtr> dispatch;
+            std::shared_ptr<const ReceiverList> receivers;
             std::condition_variable_any waitForDispatch;
             std::atomic<int64_t> nextMessageTime;
+            uint64_t nextSequence;
+
+            EnqueuedMessage* Allocate();
+            void Recycle(EnqueuedMessage* m);
+            bool Before(const EnqueuedMessage* a, const EnqueuedMessage* b) const;
+            void Swap(size_t a, size_t b);
+            void SiftUp(size_t index);
+            void SiftDown(size_t index);
+            void Enqueue(EnqueuedMessage* m);
+            void Dequeue(EnqueuedMessage* m);
+            void UpdateNextMessageTime();
 
             void Dispatch(IMessagePtr message);
     };
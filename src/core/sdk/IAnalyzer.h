@@ -39,6 +39,11 @@
 
 namespace musik { namespace core { namespace sdk {
 
+    /* the indexer analyzes multiple tracks concurrently, with a separate
+    instance (from GetAudioAnalyzer()) per worker thread. a given instance
+    only ever processes one track at a time, from Start() through End(), but
+    different instances may be running at the same time, so they shouldn't
+    share mutable state. */
     class  IAnalyzer {
         public:
             virtual void Release() = 0;
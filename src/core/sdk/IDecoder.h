@@ -36,6 +36,7 @@
 
 #include "IDataStream.h"
 #include "IBuffer.h"
+#include "constants.h"
 
 namespace musik { namespace core { namespace sdk {
 
@@ -47,6 +48,10 @@ namespace musik { namespace core { namespace sdk {
             virtual double GetDuration() = 0;
             virtual bool Open(IDataStream *stream) = 0;
             virtual bool Exhausted() = 0;
+
+            /* sdk v18 */
+            /* called before Open() */
+            virtual void SetIntent(DecodeIntent intent) = 0;
     };
 
 } } }
@@ -66,6 +66,9 @@ namespace musik { namespace core { namespace sdk {
             virtual void SetTransportType(TransportType type) = 0;
             virtual void ReindexMetadata() = 0;
             virtual void RebuildMetadata() = 0;
+
+            /* sdk v16 */
+            virtual size_t GetMetrics(MetricsFormat format, char* dst, size_t size) = 0;
     };
 
 } } }
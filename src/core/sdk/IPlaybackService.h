@@ -89,6 +89,16 @@ namespace musik { namespace core { namespace sdk {
             /* sdk v13 */
             virtual void ReloadOutput() = 0;
             virtual ITrackList* Clone() = 0;
+
+            /* sdk v15 */
+            virtual uint64_t GetQueueRevision() = 0;
+
+            /* copies up to `count` edits applied after `sinceRevision` into
+            `target`, oldest first, and returns the total number available.
+            returns -1 if `sinceRevision` is no longer journaled (e.g. the
+            queue was replaced), in which case callers must re-read it. */
+            virtual int GetQueueEdits(
+                uint64_t sinceRevision, TrackListEdit* target, size_t count) = 0;
     };
 
 } } }
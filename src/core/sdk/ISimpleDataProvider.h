@@ -139,6 +139,45 @@ namespace musik { namespace core { namespace sdk {
                 const char** externalIds,
                 const int* sortOrders,
                 int count) = 0;
+
+            /* sdk v18. keyset-paginated variants of the queries above: at most
+            `limit` results that sort after `cursor`, which is either empty (the
+            first page) or a value previously written to `nextCursor`. the cost
+            of a page does not depend on its depth. cursors are opaque; on
+            return `nextCursor` holds the cursor for the following page, or an
+            empty string after the last one, and are always shorter than 4096
+            bytes. returns nullptr if the cursor is invalid, or the next one
+            doesn't fit in `nextCursorSize` bytes. */
+            virtual ITrackList* QueryTracksAfter(
+                const char* query,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) = 0;
+
+            virtual ITrackList* QueryTracksByCategoriesAfter(
+                IValue** categories,
+                size_t categoryCount,
+                const char* filter,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) = 0;
+
+            virtual IMapList* QueryAlbumsAfter(
+                const char* categoryIdName,
+                int64_t categoryIdValue,
+                const char* filter,
+                const char* cursor,
+                int limit,
+                char* nextCursor,
+                size_t nextCursorSize) = 0;
+
+            /* loads metadata for all of the specified tracks with a single
+            query. ids that don't exist are omitted from the result. */
+            virtual ITrackList* QueryTracksByIds(
+                const int64_t* trackIds,
+                size_t trackIdCount) = 0;
     };
 
 } } }
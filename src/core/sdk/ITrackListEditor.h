@@ -35,11 +35,32 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 namespace musik {
     namespace core {
         namespace sdk {
 
+            enum class TrackListEditType : int {
+                Insert = 0,
+                Swap = 1,
+                Move = 2,
+                Delete = 3,
+                Add = 4
+            };
+
+            /* a single, replayable edit operation. `revision` is the queue
+            revision after the edit was applied. for Insert and Add `id` is
+            the track id; for Swap and Move `from` and `to` are the indexes;
+            for Insert and Delete `to` is the index. */
+            struct TrackListEdit {
+                uint64_t revision;
+                TrackListEditType type;
+                int64_t id;
+                size_t from;
+                size_t to;
+            };
+
             class ITrackListEditor {
                 public:
                     virtual bool Insert(int64_t id, size_t index) = 0;
@@ -115,6 +115,21 @@ namespace musik {
                 Crossfade = 1
             };
 
+            enum class MetricsFormat : int {
+                Prometheus = 0,
+                Json = 1
+            };
+
+            enum class DspLayout : int {
+                Interleaved = 0,
+                Planar = 1
+            };
+
+            enum class DecodeIntent : int {
+                Playback = 0, /* may seek; worth preparing for it */
+                Sequential = 1 /* read once, start to finish (analysis, transcoding) */
+            };
+
             namespace category {
                 static const char* Album = "album";
                 static const char* Artist = "artist";
@@ -147,5 +162,5 @@ namespace musik {
                 static const char* ExternalId = "external_id";
             }
 
-            static const int SdkVersion = 14;
+            static const int SdkVersion = 18;
 } } }
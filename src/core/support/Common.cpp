@@ -42,6 +42,8 @@
 
 #include <boost/format.hpp>
 
+#include <openssl/md5.h>
+
 #ifdef WIN32
     #include <shellapi.h>
 #elif __APPLE__
@@ -221,12 +223,17 @@ namespace musik { namespace core {
     }
 
     int64_t Checksum(char *data,unsigned int bytes) {
-        int64_t sum = 0;
-        for(unsigned int i = 0; i < bytes; ++i) {
-            char ch = *(data + i);
-            sum += (int64_t) ch;
+        /* content hash, folded down to 64 bits so it fits in an INTEGER
+        column. a simple byte sum collides far too easily for this to be
+        useful when de-duping artwork. */
+        unsigned char digest[MD5_DIGEST_LENGTH];
+        MD5((const unsigned char*) data, bytes, digest);
+
+        uint64_t sum = 0;
+        for (size_t i = 0; i < sizeof(sum); ++i) {
+            sum = (sum << 8) | digest[i];
         }
-        return sum;
+        return (int64_t) sum;
     }
 
     size_t CopyString(const std::string& src, char* dst, size_t size) {
@@ -0,0 +1,307 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "pch.hpp"
+
+#include <core/support/Metrics.h>
+
+#include <json.hpp>
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+using namespace musik::core::sdk;
+
+namespace musik { namespace core { namespace metrics {
+
+    enum class Type : int {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<Labels, std::shared_ptr<Counter>> counters;
+        std::map<Labels, std::shared_ptr<Gauge>> gauges;
+        std::map<Labels, std::shared_ptr<Histogram>> histograms;
+    };
+
+    static const struct {
+        double value;
+        const char* quantile; /* prometheus label value */
+        const char* key; /* json key */
+    } PERCENTILES[] = {
+        { 0.5, "0.5", "p50" },
+        { 0.9, "0.9", "p90" },
+        { 0.99, "0.99", "p99" },
+        { 0.999, "0.999", "p999" }
+    };
+
+    static std::mutex registryMutex;
+
+    static std::map<std::string, Family>& registry() {
+        /* intentionally leaked: metrics may be updated by threads that
+        outlive static destruction */
+        static auto families = new std::map<std::string, Family>();
+        return *families;
+    }
+
+    template <typename T>
+    static T& getOrCreate(
+        Type type,
+        const std::string& name,
+        const std::string& help,
+        const Labels& labels,
+        std::map<Labels, std::shared_ptr<T>> Family::*member)
+    {
+        std::unique_lock<std::mutex> lock(registryMutex);
+
+        auto& families = registry();
+        auto it = families.find(name);
+        if (it == families.end()) {
+            it = families.insert({ name, Family() }).first;
+            it->second.type = type;
+            it->second.help = help;
+        }
+
+        auto& metrics = it->second.*member;
+        auto metric = metrics.find(labels);
+        if (metric == metrics.end()) {
+            metric = metrics.insert({ labels, std::make_shared<T>() }).first;
+        }
+
+        return *metric->second;
+    }
+
+    Counter& GetCounter(const std::string& name, const std::string& help, const Labels& labels) {
+        return getOrCreate<Counter>(Type::Counter, name, help, labels, &Family::counters);
+    }
+
+    Gauge& GetGauge(const std::string& name, const std::string& help, const Labels& labels) {
+        return getOrCreate<Gauge>(Type::Gauge, name, help, labels, &Family::gauges);
+    }
+
+    Histogram& GetHistogram(const std::string& name, const std::string& help, const Labels& labels) {
+        return getOrCreate<Histogram>(Type::Histogram, name, help, labels, &Family::histograms);
+    }
+
+    /* Histogram */
+
+    Histogram::Histogram() : count(0), sum(0), max(0) {
+        for (auto& bucket : this->buckets) {
+            bucket.store(0);
+        }
+    }
+
+    int Histogram::BucketIndex(uint64_t value) {
+        if (value < SubBuckets) {
+            return (int) value;
+        }
+
+        int msb = 0;
+        for (uint64_t v = value; v > 1; v >>= 1) {
+            ++msb;
+        }
+
+        /* the top SubBucketBits + 1 bits select the bucket */
+        int shift = msb - SubBucketBits;
+        int top = (int) (value >> shift);
+        return (shift + 1) * SubBuckets + (top - SubBuckets);
+    }
+
+    uint64_t Histogram::BucketValue(int index) {
+        /* the largest value that lands in the specified bucket */
+        if (index < SubBuckets) {
+            return (uint64_t) index;
+        }
+
+        int shift = (index / SubBuckets) - 1;
+        uint64_t top = (uint64_t) (SubBuckets + (index % SubBuckets));
+        return ((top + 1) << shift) - 1;
+    }
+
+    void Histogram::Record(uint64_t value) {
+        this->buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        this->count.fetch_add(1, std::memory_order_relaxed);
+        this->sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t current = this->max.load(std::memory_order_relaxed);
+        while (value > current &&
+            !this->max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uint64_t Histogram::Percentile(double percentile) const {
+        uint64_t total = this->Count();
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t target = (uint64_t) ((double) total * percentile);
+        target = std::max((uint64_t) 1, std::min(total, target));
+
+        uint64_t seen = 0;
+        for (int i = 0; i < BucketCount; i++) {
+            seen += this->buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                return std::min(BucketValue(i), this->Max());
+            }
+        }
+
+        return this->Max();
+    }
+
+    /* rendering */
+
+    static const char* typeName(Type type, MetricsFormat format) {
+        switch (type) {
+            case Type::Counter: return "counter";
+            case Type::Gauge: return "gauge";
+            case Type::Histogram:
+                /* prometheus calls pre-computed quantiles a summary */
+                return format == MetricsFormat::Prometheus ? "summary" : "histogram";
+        }
+        return "untyped";
+    }
+
+    static std::string escapeLabelValue(const std::string& value) {
+        std::string result;
+        for (char c : value) {
+            switch (c) {
+                case '\\': result += "\\\\"; break;
+                case '"': result += "\\\""; break;
+                case '\n': result += "\\n"; break;
+                default: result += c; break;
+            }
+        }
+        return result;
+    }
+
+    static std::string formatLabels(const Labels& labels, const std::string& extra = "") {
+        std::string result;
+        for (auto& kv : labels) {
+            result += (result.size() ? "," : "") + kv.first + "=\"" + escapeLabelValue(kv.second) + "\"";
+        }
+        if (extra.size()) {
+            result += (result.size() ? "," : "") + extra;
+        }
+        return result.size() ? "{" + result + "}" : "";
+    }
+
+    static std::string renderPrometheus(const std::map<std::string, Family>& families) {
+        std::ostringstream out;
+
+        for (auto& kv : families) {
+            const std::string& name = kv.first;
+            const Family& family = kv.second;
+
+            out << "# HELP " << name << " " << family.help << "\n";
+            out << "# TYPE " << name << " " << typeName(family.type, MetricsFormat::Prometheus) << "\n";
+
+            for (auto& counter : family.counters) {
+                out << name << formatLabels(counter.first) << " " << counter.second->Value() << "\n";
+            }
+
+            for (auto& gauge : family.gauges) {
+                out << name << formatLabels(gauge.first) << " " << gauge.second->Value() << "\n";
+            }
+
+            for (auto& histogram : family.histograms) {
+                auto& h = *histogram.second;
+                for (auto& p : PERCENTILES) {
+                    std::string quantile = std::string("quantile=\"") + p.quantile + "\"";
+                    out << name << formatLabels(histogram.first, quantile) << " " << h.Percentile(p.value) << "\n";
+                }
+                out << name << "_sum" << formatLabels(histogram.first) << " " << h.Sum() << "\n";
+                out << name << "_count" << formatLabels(histogram.first) << " " << h.Count() << "\n";
+            }
+        }
+
+        return out.str();
+    }
+
+    static std::string renderJson(const std::map<std::string, Family>& families) {
+        nlohmann::json result = nlohmann::json::object();
+
+        for (auto& kv : families) {
+            const Family& family = kv.second;
+            nlohmann::json samples = nlohmann::json::array();
+
+            for (auto& counter : family.counters) {
+                samples.push_back({ { "labels", counter.first }, { "value", counter.second->Value() } });
+            }
+
+            for (auto& gauge : family.gauges) {
+                samples.push_back({ { "labels", gauge.first }, { "value", gauge.second->Value() } });
+            }
+
+            for (auto& histogram : family.histograms) {
+                auto& h = *histogram.second;
+                nlohmann::json sample = {
+                    { "labels", histogram.first },
+                    { "count", h.Count() },
+                    { "sum", h.Sum() },
+                    { "max", h.Max() }
+                };
+                for (auto& p : PERCENTILES) {
+                    sample[p.key] = h.Percentile(p.value);
+                }
+                samples.push_back(sample);
+            }
+
+            result[kv.first] = {
+                { "type", typeName(family.type, MetricsFormat::Json) },
+                { "help", family.help },
+                { "samples", samples }
+            };
+        }
+
+        return result.dump();
+    }
+
+    std::string Render(MetricsFormat format) {
+        std::unique_lock<std::mutex> lock(registryMutex);
+
+        if (format == MetricsFormat::Json) {
+            return renderJson(registry());
+        }
+
+        return renderPrometheus(registry());
+    }
+
+} } }
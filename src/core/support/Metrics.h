@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/sdk/constants.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+
+/* a small process-wide metrics registry. metrics are looked up (and created
+on demand) by name and labels; lookups take a lock, but the returned metric
+lives for the lifetime of the process, so callers on hot paths should look
+it up once and hold on to the reference. updating a metric never locks. */
+
+namespace musik { namespace core { namespace metrics {
+
+    using Labels = std::map<std::string, std::string>;
+
+    class Counter {
+        public:
+            Counter() : value(0) { }
+            void Increment(uint64_t delta = 1) { value.fetch_add(delta, std::memory_order_relaxed); }
+            uint64_t Value() const { return value.load(std::memory_order_relaxed); }
+
+        private:
+            std::atomic<uint64_t> value;
+    };
+
+    class Gauge {
+        public:
+            Gauge() : value(0) { }
+            void Set(int64_t value) { this->value.store(value, std::memory_order_relaxed); }
+            void Add(int64_t delta) { value.fetch_add(delta, std::memory_order_relaxed); }
+            int64_t Value() const { return value.load(std::memory_order_relaxed); }
+
+        private:
+            std::atomic<int64_t> value;
+    };
+
+    /* HDR-style histogram: each power of two is split into SubBuckets linear
+    buckets, so any recorded value is reported with at most 1/SubBuckets
+    relative error, across the full 64 bit range, in a fixed ~4kb. */
+    class Histogram {
+        public:
+            static const int SubBucketBits = 3;
+            static const int SubBuckets = 1 << SubBucketBits;
+            static const int BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+            Histogram();
+
+            void Record(uint64_t value);
+            uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+            uint64_t Sum() const { return sum.load(std::memory_order_relaxed); }
+            uint64_t Max() const { return max.load(std::memory_order_relaxed); }
+            uint64_t Percentile(double percentile) const;
+
+        private:
+            static int BucketIndex(uint64_t value);
+            static uint64_t BucketValue(int index);
+
+            std::atomic<uint64_t> buckets[BucketCount];
+            std::atomic<uint64_t> count, sum, max;
+    };
+
+    /* records the lifetime of the instance, in microseconds */
+    class ScopedTimer {
+        public:
+            ScopedTimer(Histogram& histogram)
+            : histogram(histogram), start(std::chrono::steady_clock::now()) { }
+
+            ~ScopedTimer() {
+                this->histogram.Record((uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - this->start).count());
+            }
+
+        private:
+            Histogram& histogram;
+            std::chrono::steady_clock::time_point start;
+    };
+
+    Counter& GetCounter(const std::string& name, const std::string& help, const Labels& labels = Labels());
+    Gauge& GetGauge(const std::string& name, const std::string& help, const Labels& labels = Labels());
+    Histogram& GetHistogram(const std::string& name, const std::string& help, const Labels& labels = Labels());
+
+    std::string Render(musik::core::sdk::MetricsFormat format);
+
+} } }
@@ -91,10 +91,18 @@ namespace musik {
             void LoadPlaybackContext(Prefs prefs, ILibraryPtr library, PlaybackService& playback) {
                 if (prefs->GetBool(keys::SaveSessionOnExit, true)) {
                     auto query = std::shared_ptr<PersistedPlayQueueQuery>(
-                        PersistedPlayQueueQuery::Restore(library, playback));
+                        PersistedPlayQueueQuery::Restore());
 
                     library->Enqueue(query, ILibrary::QuerySynchronous);
 
+                    if (query->GetStatus() == db::IQuery::Finished) {
+                        TrackList tracks(library);
+                        for (int64_t id : query->GetTrackIds()) {
+                            tracks.Add(id);
+                        }
+                        playback.RestoreQueue(tracks, query->GetJournalCount());
+                    }
+
                     int index = prefs->GetInt(keys::LastPlayQueueIndex, -1);
                     if (index >= 0) {
                         double time = prefs->GetDouble(keys::LastPlayQueueTime, 0.0f);
@@ -114,10 +122,9 @@ namespace musik {
                         prefs->SetDouble(keys::LastPlayQueueTime, 0.0f);
                     }
 
-                    auto query = std::shared_ptr<PersistedPlayQueueQuery>(
-                        PersistedPlayQueueQuery::Save(library, playback));
-
-                    library->Enqueue(query, ILibrary::QuerySynchronous);
+                    /* the queue is journaled as it's edited; just flush
+                    whatever hasn't been written yet. */
+                    playback.PersistQueue(true);
                 }
             }
         }
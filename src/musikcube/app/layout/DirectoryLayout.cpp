@@ -66,6 +66,7 @@ DirectoryLayout::DirectoryLayout(
 , playback(playback)
 , library(library)
 , queryHash(0)
+, pendingSelection(DirectoryAdapter::NO_INDEX)
 , hasSubdirectories(true) {
     this->InitializeWindows();
     this->library->Indexer()->Progress.connect(this, &DirectoryLayout::OnIndexerProgress);
@@ -101,9 +102,10 @@ void DirectoryLayout::InitializeWindows() {
             std::placeholders::_3,
             std::placeholders::_4);
 
-    this->adapter = std::make_shared<DirectoryAdapter>();
+    this->adapter = std::make_shared<DirectoryAdapter>(this->library);
     this->adapter->SetAllowEscapeRoot(false);
     this->adapter->SetItemDecorator(decorator);
+    this->adapter->Loaded.connect(this, &DirectoryLayout::OnDirectoryListLoaded);
 
     this->directoryList.reset(new ListWindow());
     this->directoryList->SetFrameTitle(_TSTR("browse_title_directory"));
@@ -126,6 +128,7 @@ void DirectoryLayout::SetDirectory(const std::string& directory) {
     this->rootDirectory = directory;
     this->adapter->SetRootDirectory(directory);
     this->directoryList->SetSelectedIndex(0);
+    this->pendingSelection = 0;
     this->UpdateTitle();
     this->Refresh(true);
 }
@@ -141,6 +144,28 @@ void DirectoryLayout::OnIndexerProgress(int count) {
     this->Requery(true);
 }
 
+void DirectoryLayout::OnDirectoryListLoaded(DirectoryAdapter* adapter) {
+    bool hadSubdirectories = this->hasSubdirectories;
+    this->hasSubdirectories = this->adapter->HasSubDirectories();
+    if (hadSubdirectories != this->hasSubdirectories) {
+        this->Layout();
+    }
+
+    this->directoryList->OnAdapterChanged();
+
+    if (this->pendingSelection != DirectoryAdapter::NO_INDEX) {
+        size_t index = this->pendingSelection;
+        this->pendingSelection = DirectoryAdapter::NO_INDEX;
+        this->directoryList->SetSelectedIndex(index);
+        if (!this->directoryList->IsEntryVisible(index)) {
+            this->directoryList->ScrollTo(index);
+        }
+    }
+
+    this->UpdateTitle();
+    this->Requery();
+}
+
 void DirectoryLayout::RequeryTrackList(ListWindow *view) {
     size_t selected = this->directoryList->GetSelectedIndex();
     std::string fullPath = "";
@@ -192,8 +217,8 @@ void DirectoryLayout::UpdateTitle() {
 }
 
 void DirectoryLayout::Refresh(bool requery) {
+    /* the listing completes asynchronously; see OnDirectoryListLoaded() */
     this->adapter->Refresh();
-    this->hasSubdirectories = this->adapter->HasSubDirectories();
     if (requery) { this->Requery(); }
 }
 
@@ -232,12 +257,9 @@ bool DirectoryLayout::KeyPress(const std::string& key) {
                 index = IsParentRoot() ? 1 : 0;
             }
 
-            this->directoryList->SetSelectedIndex(index);
-            if (!this->directoryList->IsEntryVisible(index)) {
-                this->directoryList->ScrollTo(index);
-            }
-
-            this->Requery();
+            /* the new listing is queried asynchronously; the selection is
+            applied once it arrives. */
+            this->pendingSelection = index;
         }
     }
     else if (Hotkeys::Is(Hotkeys::ContextMenu, key)) {
@@ -91,6 +91,7 @@ namespace musik {
                     size_t oldIndex);
 
                 void OnIndexerProgress(int count);
+                void OnDirectoryListLoaded(DirectoryAdapter* adapter);
 
                 musik::core::audio::PlaybackService& playback;
                 musik::core::ILibraryPtr library;
@@ -99,6 +100,7 @@ namespace musik {
                 std::shared_ptr<cursespp::ListWindow> directoryList;
                 std::shared_ptr<TrackListView> trackList;
                 size_t queryHash;
+                size_t pendingSelection;
                 bool hasSubdirectories;
         };
     }
@@ -35,12 +35,16 @@
 #include "stdafx.h"
 
 #include <core/support/Common.h>
+#include <core/library/query/local/DirectoryListQuery.h>
 #include <cursespp/Text.h>
 #include <cursespp/ScrollAdapterBase.h>
 #include <cursespp/SingleLineEntry.h>
 
 #include "DirectoryAdapter.h"
 
+using namespace musik::core;
+using namespace musik::core::db;
+using namespace musik::core::db::local;
 using namespace musik::cube;
 using namespace cursespp;
 using namespace boost::filesystem;
@@ -110,20 +114,93 @@ static void buildDirectoryList(
     std::sort(target.begin(), target.end(), std::locale(""));
 }
 
+static void buildLibraryDirectoryList(
+    std::vector<DirectoryListQuery::Entry> entries,
+    std::vector<std::string>& target,
+    std::vector<bool>& hasChildren)
+{
+    target.clear();
+    hasChildren.clear();
+
+    std::locale locale("");
+    std::sort(entries.begin(), entries.end(),
+        [&locale](const DirectoryListQuery::Entry& a, const DirectoryListQuery::Entry& b) {
+            return locale(a.name, b.name);
+        });
+
+    for (auto& entry : entries) {
+        target.push_back(entry.name);
+        hasChildren.push_back(entry.hasSubdirectories);
+    }
+}
+
 static std::string normalizePath(boost::filesystem::path path) {
     return musik::core::NormalizeDir(path.string());
 }
 
-DirectoryAdapter::DirectoryAdapter() {
+DirectoryAdapter::DirectoryAdapter(ILibraryPtr library)
+: library(library)
+, fromFilesystem(false) {
     this->showDotfiles = false;
+
+    if (this->library) {
+        this->library->QueryCompleted.connect(this, &DirectoryAdapter::OnQueryCompleted);
+    }
+
     this->dir = musik::core::GetHomeDirectory();
-    buildDirectoryList(dir, subdirs, showDotfiles);
+    this->BuildDirectoryList();
 }
 
 DirectoryAdapter::~DirectoryAdapter() {
 
 }
 
+void DirectoryAdapter::BuildDirectoryList() {
+    if (this->library) {
+        /* keep showing the current listing while refreshing the same
+        directory; otherwise clear it so we never show stale children
+        under a new path while the query is in flight. */
+        if (normalizePath(this->dir) != this->loadedDir) {
+            this->subdirs.clear();
+            this->subdirsHaveChildren.clear();
+            this->fromFilesystem = false;
+        }
+
+        this->activeQuery = std::make_shared<DirectoryListQuery>(this->dir.string());
+        this->library->Enqueue(this->activeQuery);
+    }
+    else {
+        buildDirectoryList(this->dir, this->subdirs, this->showDotfiles);
+    }
+}
+
+void DirectoryAdapter::OnQueryCompleted(musik::core::db::IQuery* query) {
+    auto active = this->activeQuery;
+    if (active &&
+        query == active.get() &&
+        active->GetStatus() == IQuery::Finished)
+    {
+        this->activeQuery.reset();
+        this->loadedDir = normalizePath(this->dir);
+
+        if (active->IsIndexed()) {
+            this->fromFilesystem = false;
+            buildLibraryDirectoryList(
+                *active->GetResult(), this->subdirs, this->subdirsHaveChildren);
+        }
+        else {
+            /* the directory isn't in the library's tree yet (e.g. a root that
+            hasn't finished its first index). show what's on disk instead of
+            an empty list. */
+            this->fromFilesystem = true;
+            this->subdirsHaveChildren.clear();
+            buildDirectoryList(this->dir, this->subdirs, this->showDotfiles);
+        }
+
+        this->Loaded(this);
+    }
+}
+
 void DirectoryAdapter::SetAllowEscapeRoot(bool allow) {
     this->allowEscapeRoot = allow;
 }
@@ -157,7 +234,7 @@ size_t DirectoryAdapter::Select(cursespp::ListWindow* window) {
     }
 #endif
 
-    buildDirectoryList(dir, subdirs, showDotfiles);
+    this->BuildDirectoryList();
     window->OnAdapterChanged();
 
     return selectedIndex;
@@ -172,7 +249,7 @@ void DirectoryAdapter::SetRootDirectory(const std::string& directory) {
         rootDir = boost::filesystem::path();
     }
 
-    buildDirectoryList(dir, subdirs, showDotfiles);
+    this->BuildDirectoryList();
 }
 
 std::string DirectoryAdapter::GetFullPathAt(size_t index) {
@@ -182,6 +259,10 @@ std::string DirectoryAdapter::GetFullPathAt(size_t index) {
     }
 
     index = (hasParent ? index - 1 : index);
+    if (index >= this->subdirs.size()) {
+        return ""; /* listing is still loading */
+    }
+
     return normalizePath((dir / this->subdirs[index]).string());
 }
 
@@ -190,7 +271,7 @@ std::string DirectoryAdapter::GetLeafAt(size_t index) {
         return "..";
     }
 
-    return this->subdirs[index];
+    return index < this->subdirs.size() ? this->subdirs[index] : "";
 }
 
 size_t DirectoryAdapter::IndexOf(const std::string& leaf) {
@@ -211,7 +292,7 @@ size_t DirectoryAdapter::GetEntryCount() {
 void DirectoryAdapter::SetDotfilesVisible(bool visible) {
     if (showDotfiles != visible) {
         showDotfiles = visible;
-        buildDirectoryList(dir, subdirs, showDotfiles);
+        this->BuildDirectoryList();
     }
 }
 
@@ -230,7 +311,7 @@ std::string DirectoryAdapter::GetCurrentPath() {
 }
 
 void DirectoryAdapter::Refresh() {
-    buildDirectoryList(dir, subdirs, showDotfiles);
+    this->BuildDirectoryList();
 }
 
 bool DirectoryAdapter::ShowParentPath() {
@@ -250,10 +331,23 @@ bool DirectoryAdapter::HasSubDirectories(size_t index) {
     }
 
     index = hasParent ? index - 1 : index;
+
+    if (this->library && !this->fromFilesystem) {
+        return index < this->subdirsHaveChildren.size() && this->subdirsHaveChildren[index];
+    }
+
+    if (index >= this->subdirs.size()) {
+        return false;
+    }
+
     return hasSubdirectories(this->dir / this->subdirs[index], this->showDotfiles);
 }
 
 bool DirectoryAdapter::HasSubDirectories() {
+    if (this->library) {
+        return this->subdirs.size() > 0;
+    }
+
     return hasSubdirectories(this->dir, this->showDotfiles);
 }
 
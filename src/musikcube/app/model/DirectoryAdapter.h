@@ -36,17 +36,29 @@
 
 #include <cursespp/ScrollAdapterBase.h>
 #include <cursespp/ListWindow.h>
+#include <core/library/ILibrary.h>
+#include <core/library/query/local/DirectoryListQuery.h>
+#include <sigslot/sigslot.h>
 #include <boost/filesystem.hpp>
 #include <vector>
 #include <stack>
 
 namespace musik {
     namespace cube {
-        class DirectoryAdapter : public cursespp::ScrollAdapterBase {
+        class DirectoryAdapter :
+            public cursespp::ScrollAdapterBase,
+            public sigslot::has_slots<>
+        {
             public:
                 static const size_t NO_INDEX = (size_t)-1;
 
-                DirectoryAdapter();
+                /* library mode only: listings are queried asynchronously. this
+                is raised on the ui thread once a new listing has been applied. */
+                sigslot::signal1<DirectoryAdapter*> Loaded;
+
+                /* if a library is specified, directories are listed from its
+                indexed directory tree instead of from the filesystem. */
+                DirectoryAdapter(musik::core::ILibraryPtr library = musik::core::ILibraryPtr());
                 virtual ~DirectoryAdapter();
 
                 virtual size_t GetEntryCount();
@@ -67,9 +79,19 @@ namespace musik {
 
             private:
                 bool ShowParentPath();
+                void BuildDirectoryList();
+                void OnQueryCompleted(musik::core::db::IQuery* query);
+
+                using DirectoryListQueryPtr =
+                    std::shared_ptr<musik::core::db::local::DirectoryListQuery>;
 
+                musik::core::ILibraryPtr library;
+                DirectoryListQueryPtr activeQuery;
+                std::string loadedDir;
+                bool fromFilesystem;
                 boost::filesystem::path dir, rootDir;
                 std::vector<std::string> subdirs;
+                std::vector<bool> subdirsHaveChildren;
                 std::stack<size_t> selectedIndexStack;
                 bool showDotfiles, allowEscapeRoot;
         };
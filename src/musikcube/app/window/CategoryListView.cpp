@@ -77,6 +77,10 @@ CategoryListView::CategoryListView(
     this->selectAfterQuery = -1LL;
     this->library = library;
     this->library->QueryCompleted.connect(this, &CategoryListView::OnQueryCompleted);
+    this->library->Indexer()->Progress.connect(this, &CategoryListView::OnIndexerProgress);
+    this->library->Indexer()->Finished.connect(this, &CategoryListView::OnIndexerProgress);
+    this->indexStale = true;
+    this->rebuildingIndex = false;
     this->fieldName = fieldName;
     this->fieldIdColumn = getFieldIdColumn(fieldName);
     this->adapter = new Adapter(*this);
@@ -97,15 +101,49 @@ void CategoryListView::RequeryWithField(
     const std::string& filter,
     const int64_t selectAfterQuery)
 {
+    this->selectAfterQuery = selectAfterQuery;
+    this->filter = filter;
+
+    /* if the index for this field is already being rebuilt, let it finish;
+    OnQueryCompleted() applies whatever the filter is by then. otherwise
+    every keystroke would restart the full, unfiltered query. */
+    if (this->activeQuery &&
+        this->rebuildingIndex &&
+        !this->indexStale &&
+        this->fieldName == fieldName &&
+        this->activeQuery->GetStatus() != IQuery::Failed &&
+        this->activeQuery->GetStatus() != IQuery::Canceled)
+    {
+        return;
+    }
+
     if (this->activeQuery) {
         this->activeQuery->Cancel();
     }
 
+    this->rebuildingIndex = false;
     this->fieldName = fieldName;
     this->fieldIdColumn = getFieldIdColumn(fieldName);
-    this->selectAfterQuery = selectAfterQuery;
-    this->filter = filter;
-    this->activeQuery.reset(new CategoryListQuery(fieldName, filter));
+
+    /* playlists and other uncommon fields always go to the database. */
+    if (this->fieldIdColumn.empty()) {
+        this->activeQuery.reset(new CategoryListQuery(fieldName, filter));
+        this->library->Enqueue(activeQuery);
+        return;
+    }
+
+    if (this->index && !this->indexStale && this->indexFieldName == fieldName) {
+        this->SetMetadata(this->index->Filter(filter));
+        return;
+    }
+
+    /* (re)build the index from the unfiltered list; the filter is applied
+    in memory when the query completes. */
+    this->indexStale = false;
+    this->indexFieldName = fieldName;
+    this->index.reset();
+    this->rebuildingIndex = true;
+    this->activeQuery.reset(new CategoryListQuery(fieldName));
     this->library->Enqueue(activeQuery);
 }
 
@@ -146,6 +184,11 @@ std::string CategoryListView::GetFilter() {
     return this->filter;
 }
 
+void CategoryListView::OnIndexerProgress(int count) {
+    /* called from the indexer thread; the next requery will rebuild */
+    this->indexStale = true;
+}
+
 void CategoryListView::OnTrackChanged(size_t index, musik::core::TrackPtr track) {
     this->playing = track;
     this->OnAdapterChanged();
@@ -223,33 +266,49 @@ bool CategoryListView::KeyPress(const std::string& key) {
     return ListWindow::KeyPress(key);
 }
 
-void CategoryListView::OnQueryCompleted(IQuery* query) {
-    auto active = this->activeQuery;
-    if (active && query == active.get()) {
-        int selectedIndex = -1;
-        if (this->selectAfterQuery != -1LL) {
-            selectedIndex = active->GetIndexOf(this->selectAfterQuery);
+void CategoryListView::SetMetadata(CategoryListQuery::Result metadata) {
+    this->metadata = metadata;
+
+    int selectedIndex = -1;
+    if (this->selectAfterQuery != -1LL) {
+        for (size_t i = 0; i < metadata->Count(); i++) {
+            if (metadata->At(i)->GetId() == this->selectAfterQuery) {
+                selectedIndex = (int) i;
+                break;
+            }
         }
+    }
 
-        if (this->activeQuery &&
-            this->activeQuery->GetId() == query->GetId() &&
-            this->activeQuery->GetStatus() == IQuery::Finished)
-        {
-            this->metadata = activeQuery->GetResult();
-            activeQuery.reset();
+    if (selectedIndex >= 0) {
+        this->SetSelectedIndex(selectedIndex);
 
-            if (selectedIndex >= 0) {
-                this->SetSelectedIndex(selectedIndex);
+        /* scroll down just a bit more to reveal the item above so
+        there's indication the user can scroll. */
+        if (!this->IsEntryVisible(selectedIndex)) {
+            this->ScrollTo(selectedIndex == 0 ? selectedIndex : selectedIndex - 1);
+        }
+    }
 
-                /* scroll down just a bit more to reveal the item above so
-                there's indication the user can scroll. */
-                if (!this->IsEntryVisible(selectedIndex)) {
-                    this->ScrollTo(selectedIndex == 0 ? selectedIndex : selectedIndex - 1);
-                }
-            }
+    this->OnAdapterChanged();
+    this->OnInvalidated();
+}
 
-            this->OnAdapterChanged();
-            this->OnInvalidated();
+void CategoryListView::OnQueryCompleted(IQuery* query) {
+    auto active = this->activeQuery;
+    if (active &&
+        query == active.get() &&
+        active->GetId() == query->GetId() &&
+        active->GetStatus() == IQuery::Finished)
+    {
+        this->activeQuery.reset();
+        this->rebuildingIndex = false;
+
+        if (this->fieldIdColumn.size()) {
+            this->index.reset(new CategoryFilterIndex(active->GetResult()));
+            this->SetMetadata(this->index->Filter(this->filter));
+        }
+        else {
+            this->SetMetadata(active->GetResult());
         }
     }
 }
@@ -260,6 +319,7 @@ IScrollAdapter& CategoryListView::GetScrollAdapter() {
 
 CategoryListView::Adapter::Adapter(CategoryListView &parent)
     : parent(parent) {
+    this->SetLineCounter([](size_t) -> size_t { return 1; });
 }
 
 size_t CategoryListView::Adapter::GetEntryCount() {
@@ -40,12 +40,14 @@
 #include <cursespp/ScrollAdapterBase.h>
 
 #include <core/library/query/local/CategoryListQuery.h>
+#include <core/library/query/local/util/CategoryFilterIndex.h>
 
 #include <core/audio/PlaybackService.h>
 #include <core/library/IQuery.h>
 #include <core/library/ILibrary.h>
 #include <core/runtime/IMessage.h>
 
+#include <atomic>
 #include <mutex>
 
 namespace musik {
@@ -106,7 +108,9 @@ namespace musik {
 
             private:
                 void OnTrackChanged(size_t index, musik::core::TrackPtr track);
+                void OnIndexerProgress(int count);
                 void ScrollToPlaying();
+                void SetMetadata(musik::core::db::local::CategoryListQuery::Result metadata);
 
                 musik::core::audio::PlaybackService& playback;
                 Adapter *adapter;
@@ -120,6 +124,14 @@ namespace musik {
                 std::string filter;
                 int64_t selectAfterQuery;
                 musik::core::db::local::CategoryListQuery::Result metadata;
+
+                /* all values for the current field, used to answer filters
+                in memory. rebuilt from the database when the field changes
+                or the indexer touches the library. */
+                std::shared_ptr<musik::core::db::local::CategoryFilterIndex> index;
+                std::string indexFieldName;
+                std::atomic<bool> indexStale;
+                bool rebuildingIndex;
         };
     }
 }
@@ -53,6 +53,10 @@
 
 #define WINDOW_MESSAGE_SCROLL_TO_PLAYING 1003
 
+/* number of pages loaded in the direction of travel; one page is always
+kept loaded behind the viewport. */
+#define PREFETCH_PAGES 3
+
 using namespace musik::core;
 using namespace musik::core::audio;
 using namespace musik::core::db;
@@ -89,6 +93,7 @@ TrackListView::TrackListView(
     this->formatter = formatter;
     this->decorator = decorator;
     this->trackNumType = TrackNumType::Metadata;
+    this->lastHydratedIndex = 0;
 }
 
 TrackListView::~TrackListView() {
@@ -101,6 +106,48 @@ void TrackListView::Requery(std::shared_ptr<TrackListQueryBase> query) {
     this->library->Enqueue(this->query);
 }
 
+void TrackListView::SetTracks(std::shared_ptr<TrackList> tracks) {
+    if (this->tracks) {
+        this->tracks->WindowCached.disconnect(this);
+    }
+
+    this->tracks = tracks;
+    this->lastHydratedIndex = 0;
+
+    if (this->tracks) {
+        this->tracks->WindowCached.connect(this, &TrackListView::OnWindowCached);
+    }
+}
+
+void TrackListView::Hydrate(size_t rawIndex, size_t pageSize) {
+    if (!this->tracks || !this->tracks->Count()) {
+        return;
+    }
+
+    size_t count = this->tracks->Count();
+    size_t first = std::min(count - 1, this->headers.AdapterToTrackListIndex(rawIndex));
+    size_t page = std::max((size_t) 1, pageSize);
+
+    /* prefetch further in whichever direction the user is scrolling */
+    bool forward = first >= this->lastHydratedIndex;
+    this->lastHydratedIndex = first;
+
+    size_t behind = forward ? page : page * PREFETCH_PAGES;
+    size_t ahead = forward ? page * PREFETCH_PAGES : page;
+    size_t from = first > behind ? first - behind : 0;
+    size_t to = std::min(count, first + page + ahead);
+
+    this->tracks->SetCacheWindowSize((to - from) * 2);
+
+    /* visible rows first, so they don't wait behind the prefetch */
+    this->tracks->CacheWindow(first, std::min(count, first + page), true);
+    this->tracks->CacheWindow(from, to, true);
+}
+
+void TrackListView::OnWindowCached() {
+    this->Redraw();
+}
+
 void TrackListView::SelectFirstTrack() {
     this->SetSelectedIndex(this->headers.HeaderAt(0) ? 1 : 0);
 }
@@ -118,7 +165,7 @@ void TrackListView::OnQueryCompleted(IQuery* query) {
             bool hadTracks = this->tracks && this->tracks->Count() > 0;
             bool prevQuerySame = this->lastQueryHash == this->query->GetQueryHash();
 
-            this->tracks = this->query->GetResult();
+            this->SetTracks(this->query->GetResult());
             this->headers.Set(this->query->GetHeaders());
             this->lastQueryHash = this->query->GetQueryHash();
 
@@ -147,7 +194,7 @@ std::shared_ptr<TrackList> TrackListView::GetTrackList() {
 
 void TrackListView::SetTrackList(std::shared_ptr<TrackList> trackList) {
     if (this->tracks != trackList) {
-        this->tracks = trackList;
+        this->SetTracks(trackList);
         this->ScrollToTop();
         this->SelectFirstTrack();
     }
@@ -157,7 +204,7 @@ void TrackListView::SetTrackList(std::shared_ptr<TrackList> trackList) {
 
 void TrackListView::Clear() {
     this->query.reset();
-    this->tracks.reset(new TrackList(this->library));
+    this->SetTracks(std::make_shared<TrackList>(this->library));
     this->headers.Reset();
     this->OnAdapterChanged();
 }
@@ -285,58 +332,58 @@ IScrollAdapter& TrackListView::GetScrollAdapter() {
 
 TrackListView::Adapter::Adapter(TrackListView &parent)
 : parent(parent) {
+    /* tracks and album headers are always a single line */
+    this->SetLineCounter([](size_t) -> size_t { return 1; });
+}
+
+void TrackListView::Adapter::DrawPage(
+    ScrollableWindow* window, size_t index, IScrollAdapter::ScrollPosition& result)
+{
+    this->parent.Hydrate(index, this->GetHeight());
+    ScrollAdapterBase::DrawPage(window, index, result);
 }
 
 /* * * * TrackListView::HeaderCalculator * * * */
 
 void TrackListView::HeaderCalculator::Set(Headers rawOffsets) {
-    this->rawOffsets = rawOffsets;
-    this->absoluteOffsets.reset();
+    this->Reset();
     if (rawOffsets) {
-        this->absoluteOffsets.reset(new std::set<size_t>());
+        /* sorted, so offsets can be found with a binary search instead of
+        walking every header above the index */
+        this->rawOffsets.assign(rawOffsets->begin(), rawOffsets->end());
+        this->absoluteOffsets.reserve(this->rawOffsets.size());
         size_t i = 0;
-        for (auto val : (*this->rawOffsets)) {
-            this->absoluteOffsets->insert(val + i);
+        for (auto val : this->rawOffsets) {
+            this->absoluteOffsets.push_back(val + i);
             i++;
         }
     }
 }
 
 void TrackListView::HeaderCalculator::Reset() {
-    this->absoluteOffsets.reset();
-    this->rawOffsets.reset();
+    this->absoluteOffsets.clear();
+    this->rawOffsets.clear();
 }
 
 size_t TrackListView::HeaderCalculator::AdapterToTrackListIndex(size_t index) {
-    return this->ApplyHeaderOffset(index, this->absoluteOffsets, -1);
+    return index - this->CountAtOrBefore(index, this->absoluteOffsets);
 }
 
 size_t TrackListView::HeaderCalculator::TrackListToAdapterIndex(size_t index) {
-    return this->ApplyHeaderOffset(index, this->rawOffsets, 1);
+    return index + this->CountAtOrBefore(index, this->rawOffsets);
 }
 
-size_t TrackListView::HeaderCalculator::ApplyHeaderOffset(size_t index, Headers offsets, int delta) {
-    size_t result = index;
-    if (offsets) {
-        for (auto offset : (*offsets)) {
-            if (offset <= index) {
-                result += delta;
-            }
-            else {
-                break;
-            }
-        }
-    }
-    return result;
+size_t TrackListView::HeaderCalculator::CountAtOrBefore(size_t index, const Offsets& offsets) {
+    return std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin();
 }
 
 size_t TrackListView::HeaderCalculator::Count() {
-    return this->absoluteOffsets ? this->absoluteOffsets->size() : 0;
+    return this->absoluteOffsets.size();
 }
 
 bool TrackListView::HeaderCalculator::HeaderAt(size_t index) {
-    return this->absoluteOffsets &&
-        this->absoluteOffsets->find(index) != this->absoluteOffsets->end();
+    return std::binary_search(
+        this->absoluteOffsets.begin(), this->absoluteOffsets.end(), index);
 }
 
 /* * * * TrackListView::Adapter * * * */
@@ -403,12 +450,14 @@ IScrollAdapter::EntryPtr TrackListView::Adapter::GetEntry(cursespp::ScrollableWi
         /* the next track at the next logical index will have the album
         tracks we're interesetd in. */
         auto trackIndex = this->parent.headers.AdapterToTrackListIndex(rawIndex + 1);
-        TrackPtr track = parent.tracks->Get(trackIndex);
+        TrackPtr track = parent.tracks->GetIfCached(trackIndex);
 
-        if (track) {
-            std::string album = track->GetString(constants::Track::ALBUM);
+        {
+            /* still loading: render an empty header; it's redrawn when the
+            track arrives. */
+            std::string album = track ? track->GetString(constants::Track::ALBUM) : "";
 
-            if (!album.size()) {
+            if (track && !album.size()) {
                 album = _TSTR("tracklist_unknown_album");
             }
 
@@ -426,7 +475,20 @@ IScrollAdapter::EntryPtr TrackListView::Adapter::GetEntry(cursespp::ScrollableWi
     }
 
     size_t trackIndex = this->parent.headers.AdapterToTrackListIndex(rawIndex);
-    TrackPtr track = parent.tracks->Get(trackIndex);
+    TrackPtr track = parent.tracks->GetIfCached(trackIndex);
+
+    if (!track && trackIndex < parent.tracks->Count() && !parent.tracks->IsMissing(trackIndex)) {
+        /* not loaded yet. Hydrate() has already requested it; show a
+        placeholder row so scrolling never blocks on the database. */
+        std::shared_ptr<TrackListEntry> entry(
+            new TrackListEntry(std::string(this->GetWidth(), ' '), trackIndex, RowType::Track));
+
+        entry->SetAttrs(selected
+            ? COLOR_PAIR(CURSESPP_HIGHLIGHTED_LIST_ITEM)
+            : CURSESPP_DEFAULT_COLOR);
+
+        return entry;
+    }
 
     if (!track) {
         auto entry = std::shared_ptr<SingleLineEntry>(new SingleLineEntry("track missing"));
@@ -129,6 +129,11 @@ namespace musik {
                         virtual size_t GetEntryCount();
                         virtual EntryPtr GetEntry(cursespp::ScrollableWindow* window, size_t index);
 
+                        virtual void DrawPage(
+                            cursespp::ScrollableWindow* window,
+                            size_t index,
+                            cursespp::IScrollAdapter::ScrollPosition& result);
+
                     private:
                         TrackListView &parent;
                         IScrollAdapter::ScrollPosition spos;
@@ -146,13 +151,18 @@ namespace musik {
                         size_t Count();
 
                     private:
-                        size_t ApplyHeaderOffset(size_t index, Headers offsets, int delta);
+                        typedef std::vector<size_t> Offsets;
+
+                        size_t CountAtOrBefore(size_t index, const Offsets& offsets);
 
-                        Headers absoluteOffsets;
-                        Headers rawOffsets;
+                        Offsets absoluteOffsets;
+                        Offsets rawOffsets;
                 };
 
                 void OnTrackChanged(size_t index, musik::core::TrackPtr track);
+                void OnWindowCached();
+                void SetTracks(std::shared_ptr<musik::core::TrackList> tracks);
+                void Hydrate(size_t rawIndex, size_t pageSize);
 
                 void ScrollToPlaying();
                 void SelectFirstTrack();
@@ -169,6 +179,7 @@ namespace musik {
                 RowDecorator decorator;
                 std::chrono::milliseconds lastChanged;
                 TrackNumType trackNumType;
+                size_t lastHydratedIndex;
         };
     }
 }
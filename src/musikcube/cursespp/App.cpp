@@ -266,6 +266,7 @@ void App::Run(ILayoutPtr layout) {
 
     MEVENT mouseEvent;
     int64_t ch;
+    int readTimeoutMs;
     std::string kn;
 
     this->state.input = nullptr;
@@ -273,6 +274,8 @@ void App::Run(ILayoutPtr layout) {
 
     this->ChangeLayout(layout);
 
+    ch = ERR;
+
     while (!this->quit && !disconnected) {
         kn = "";
 
@@ -283,13 +286,28 @@ void App::Run(ILayoutPtr layout) {
             goto process;
         }
 
-        timeout(IDLE_TIMEOUT_MS);
+#ifdef WIN32
+        readTimeoutMs = IDLE_TIMEOUT_MS;
+#else
+        /* if the last read came back empty, sleep until there's input, a
+        message is posted or comes due, or a pending resize settles. if it
+        returned a key, curses may have more buffered, so don't wait. the
+        read itself never blocks. */
+        readTimeoutMs = 0;
+
+        if (ch == ERR) {
+            Window::WaitForEvents(resizeAt
+                ? std::max((int64_t) 0, resizeAt - App::Now()) : -1);
+        }
+#endif
+
+        timeout(readTimeoutMs);
 
         if (this->state.input) {
             /* if the focused window is an input, allow it to draw a cursor */
             WINDOW *c = this->state.focused->GetContent();
             keypad(c, TRUE);
-            wtimeout(c, IDLE_TIMEOUT_MS);
+            wtimeout(c, readTimeoutMs);
             ch = wgetch(c);
         }
         else {
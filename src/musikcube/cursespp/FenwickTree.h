@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace cursespp {
+    /* prefix sums over a list of non-negative counts (e.g. entry heights)
+    with O(log n) point updates, prefix queries and "which index contains
+    line n" searches. appending is also O(log n). */
+    class FenwickTree {
+        public:
+            FenwickTree() {
+                this->Clear();
+            }
+
+            void Clear() {
+                this->values.clear();
+                this->tree.assign(1, 0);
+            }
+
+            size_t Size() const {
+                return this->values.size();
+            }
+
+            size_t Get(size_t index) const {
+                return this->values.at(index);
+            }
+
+            /* appends a value to the end of the list */
+            void Push(size_t value) {
+                this->values.push_back(value);
+                size_t i = this->values.size();
+                size_t node = value;
+
+                /* this node covers (i - lowbit(i), i]; everything in that
+                range except the new value is already in the tree */
+                for (size_t child = i - 1; child > i - (i & (0 - i)); child -= (child & (0 - child))) {
+                    node += this->tree[child];
+                }
+
+                this->tree.push_back(node);
+            }
+
+            void Set(size_t index, size_t value) {
+                size_t prev = this->values.at(index);
+                this->values[index] = value;
+
+                for (size_t i = index + 1; i < this->tree.size(); i += (i & (0 - i))) {
+                    this->tree[i] += value;
+                    this->tree[i] -= prev;
+                }
+            }
+
+            /* sum of the first `count` values */
+            size_t Prefix(size_t count) const {
+                size_t sum = 0;
+                for (size_t i = std::min(count, this->values.size()); i > 0; i -= (i & (0 - i))) {
+                    sum += this->tree[i];
+                }
+                return sum;
+            }
+
+            size_t Total() const {
+                return this->Prefix(this->values.size());
+            }
+
+            /* the smallest count such that Prefix(count) >= sum, or Size()
+            if the total is smaller than sum */
+            size_t LowerBound(size_t sum) const {
+                if (sum == 0) {
+                    return 0;
+                }
+
+                size_t size = this->values.size();
+                size_t step = 1;
+                while (step * 2 <= size) {
+                    step *= 2;
+                }
+
+                size_t position = 0;
+                for (; step > 0; step /= 2) {
+                    size_t next = position + step;
+                    if (next <= size && this->tree[next] < sum) {
+                        position = next;
+                        sum -= this->tree[next];
+                    }
+                }
+
+                return position + 1 > size ? size : position + 1;
+            }
+
+        private:
+            std::vector<size_t> values;
+            std::vector<size_t> tree; /* 1-based */
+    };
+}
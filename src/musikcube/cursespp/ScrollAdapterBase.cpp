@@ -45,6 +45,7 @@ typedef IScrollAdapter::EntryPtr EntryPtr;
 ScrollAdapterBase::ScrollAdapterBase() {
     this->height = 0;
     this->width = 0;
+    this->lineCountsWidth = 0;
 }
 
 ScrollAdapterBase::~ScrollAdapterBase() {
@@ -60,6 +61,35 @@ size_t ScrollAdapterBase::GetLineCount() {
     return -1;
 }
 
+void ScrollAdapterBase::SetLineCounter(LineCounter counter) {
+    this->lineCounter = counter;
+    this->InvalidateLineCounts();
+}
+
+void ScrollAdapterBase::InvalidateLineCounts() {
+    this->lineCounts.Clear();
+}
+
+bool ScrollAdapterBase::UpdateLineCounts() {
+    if (!this->lineCounter) {
+        return false;
+    }
+
+    size_t count = this->GetEntryCount();
+
+    if (this->lineCountsWidth != this->width || count < this->lineCounts.Size()) {
+        this->lineCounts.Clear();
+        this->lineCountsWidth = this->width;
+    }
+
+    /* appended entries (or everything, after a reset) */
+    for (size_t i = this->lineCounts.Size(); i < count; i++) {
+        this->lineCounts.Push(this->lineCounter(i));
+    }
+
+    return true;
+}
+
 size_t ScrollAdapterBase::GetVisibleItems(
     cursespp::ScrollableWindow* window,
     size_t desiredTopIndex,
@@ -67,6 +97,31 @@ size_t ScrollAdapterBase::GetVisibleItems(
 {
     size_t actualTopIndex = desiredTopIndex;
 
+    if (this->UpdateLineCounts()) {
+        /* if there aren't enough lines below the requested index to fill
+        the view, start at the first entry that lets the last one land on
+        the bottom line. */
+        size_t total = this->lineCounts.Total();
+        size_t below = total - this->lineCounts.Prefix(desiredTopIndex);
+
+        if (below < this->height) {
+            actualTopIndex = (total > this->height)
+                ? this->lineCounts.LowerBound(total - this->height)
+                : 0;
+        }
+
+        int remaining = (int) this->height;
+        size_t entryCount = this->lineCounts.Size();
+        for (size_t i = actualTopIndex; i < entryCount && remaining > 0; i++) {
+            EntryPtr entry = this->GetEntry(window, i);
+            entry->SetWidth(this->width);
+            remaining -= (int) this->lineCounts.Get(i);
+            target.push_back(entry);
+        }
+
+        return actualTopIndex;
+    }
+
     /* ensure we have enough data to draw from the specified position
     to the end. if we don't try to back up a bit until we can fill
     the buffer */
@@ -36,6 +36,7 @@
 
 #include "curses_config.h"
 #include "IScrollAdapter.h"
+#include "FenwickTree.h"
 #include <deque>
 
 namespace cursespp {
@@ -47,6 +48,11 @@ namespace cursespp {
                 size_t,
                 EntryPtr)> ItemDecorator;
 
+            /* returns the number of lines the entry at the specified index
+            occupies at the current width, without the caller having to
+            build it. */
+            typedef std::function<size_t(size_t)> LineCounter;
+
             ScrollAdapterBase();
             virtual ~ScrollAdapterBase();
 
@@ -63,6 +69,13 @@ namespace cursespp {
 
             virtual void SetItemDecorator(ItemDecorator decorator) { this->decorator = decorator; }
 
+            /* when set, the adapter keeps a prefix sum of entry heights and
+            lays out pages with O(log n) lookups; only visible entries are
+            built. the index is rebuilt when the width changes and extended
+            when entries are appended; subclasses whose existing entries
+            change must call InvalidateLineCounts(). */
+            virtual void SetLineCounter(LineCounter counter);
+
         protected:
             size_t GetVisibleItems(
                 cursespp::ScrollableWindow* window,
@@ -71,11 +84,18 @@ namespace cursespp {
 
             virtual ItemDecorator GetItemDecorator() { return this->decorator; }
 
+            void InvalidateLineCounts();
+
             size_t GetWidth() { return this->width; }
             size_t GetHeight() { return this->height; }
 
         private:
+            bool UpdateLineCounts();
+
             size_t width, height;
             ItemDecorator decorator;
+            LineCounter lineCounter;
+            FenwickTree lineCounts;
+            size_t lineCountsWidth;
     };
 }
@@ -50,6 +50,13 @@ typedef IScrollAdapter::EntryPtr EntryPtr;
 SimpleScrollAdapter::SimpleScrollAdapter() {
     this->maxEntries = MAX_ENTRY_COUNT;
     this->selectable = false;
+
+    /* entries are already built, but wrapping makes their heights vary */
+    this->SetLineCounter([this](size_t index) -> size_t {
+        auto entry = this->entries.at(index);
+        entry->SetWidth(this->GetWidth());
+        return entry->GetLineCount();
+    });
 }
 
 SimpleScrollAdapter::~SimpleScrollAdapter() {
@@ -62,6 +69,7 @@ void SimpleScrollAdapter::SetSelectable(bool selectable) {
 
 void SimpleScrollAdapter::Clear() {
     this->entries.clear();
+    this->InvalidateLineCounts();
 }
 
 size_t SimpleScrollAdapter::GetEntryCount() {
@@ -94,8 +102,13 @@ void SimpleScrollAdapter::AddEntry(std::shared_ptr<IEntry> entry) {
     entry->SetWidth(this->GetWidth());
     entries.push_back(entry);
 
-    while (entries.size() > this->maxEntries) {
-        entries.pop_front();
+    if (entries.size() > this->maxEntries) {
+        while (entries.size() > this->maxEntries) {
+            entries.pop_front();
+        }
+
+        /* every remaining entry moved up */
+        this->InvalidateLineCounts();
     }
 }
 
@@ -44,16 +44,120 @@
 #include <core/runtime/Message.h>
 #include <core/runtime/MessageQueue.h>
 
+#ifndef WIN32
+#include <atomic>
+#include <chrono>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace cursespp;
 using namespace musik::core::runtime;
 
+#ifndef WIN32
+/* a MessageQueue that writes to a pipe whenever something is posted. this
+lets the App's main loop sleep in poll() on stdin and the pipe, instead of
+waking up every IDLE_TIMEOUT_MS to check for work. */
+class WakeableMessageQueue : public MessageQueue {
+    public:
+        WakeableMessageQueue() {
+            this->pending.store(false);
+            if (pipe(this->pipeFd) == 0) {
+                for (int i = 0; i < 2; i++) {
+                    fcntl(this->pipeFd[i], F_SETFL, fcntl(this->pipeFd[i], F_GETFL) | O_NONBLOCK);
+                    fcntl(this->pipeFd[i], F_SETFD, FD_CLOEXEC);
+                }
+            }
+            else {
+                this->pipeFd[0] = this->pipeFd[1] = -1;
+            }
+        }
+
+        virtual ~WakeableMessageQueue() {
+            if (this->pipeFd[0] != -1) {
+                close(this->pipeFd[0]);
+                close(this->pipeFd[1]);
+            }
+        }
+
+        virtual void Post(IMessagePtr message, int64_t delayMs = 0) override {
+            MessageQueue::Post(message, delayMs);
+
+            /* one wakeup byte is enough; the loop will dispatch everything
+            that's due, and recalculate the next deadline. */
+            if (this->pipeFd[1] != -1 && !this->pending.exchange(true)) {
+                char c = 0;
+                if (write(this->pipeFd[1], &c, 1) < 0) {
+                    this->pending.store(false);
+                }
+            }
+        }
+
+        void Wait(int64_t maxWaitMs) {
+            int64_t timeoutMs = maxWaitMs;
+            int64_t next = this->GetNextMessageTime();
+
+            if (next >= 0) {
+                using namespace std::chrono;
+
+                int64_t now = duration_cast<milliseconds>(
+                    system_clock::now().time_since_epoch()).count();
+
+                int64_t delay = std::max((int64_t) 0, next - now);
+                timeoutMs = (timeoutMs < 0) ? delay : std::min(timeoutMs, delay);
+            }
+
+            struct pollfd fds[2];
+            fds[0].fd = STDIN_FILENO;
+            fds[0].events = POLLIN;
+            fds[1].fd = this->pipeFd[0];
+            fds[1].events = POLLIN;
+
+            /* if we failed to create the pipe, fall back to the old
+            behavior of waking up periodically. */
+            int count = 2;
+            if (this->pipeFd[0] == -1) {
+                count = 1;
+                if (timeoutMs < 0 || timeoutMs > IDLE_TIMEOUT_MS) {
+                    timeoutMs = IDLE_TIMEOUT_MS;
+                }
+            }
+
+            /* EINTR is fine; signals (e.g. SIGWINCH) should wake us up. */
+            poll(fds, count, (int) std::min(timeoutMs, (int64_t) INT32_MAX));
+
+            if (count > 1 && (fds[1].revents & POLLIN)) {
+                /* drain first, then clear the flag. clearing it first lets a
+                Post() write a new byte that we'd immediately swallow, leaving
+                pending set with nothing in the pipe -- and no more wakeups. a
+                Post() that lands between the two only enqueues; the caller
+                dispatches everything that's due right after we return. */
+                char buffer[64];
+                while (read(this->pipeFd[0], buffer, sizeof(buffer)) > 0) {
+                    /* drain */
+                }
+                this->pending.store(false);
+            }
+        }
+
+    private:
+        int pipeFd[2];
+        std::atomic<bool> pending;
+};
+#endif
+
 static int NEXT_ID = 0;
 
 static bool drawPending = false;
 static bool freeze = false;
 static Window* top = nullptr;
 
+#ifdef WIN32
 static MessageQueue messageQueue;
+#else
+static WakeableMessageQueue messageQueue;
+#endif
 static std::shared_ptr<INavigationKeys> keys;
 
 #define ENABLE_BOUNDS_CHECK 1
@@ -108,6 +212,12 @@ IMessageQueue& Window::MessageQueue() {
     return messageQueue;
 }
 
+#ifndef WIN32
+void Window::WaitForEvents(int64_t maxWaitMs) {
+    messageQueue.Wait(maxWaitMs);
+}
+#endif
+
 Window::Window(IWindow *parent) {
     this->frame = this->content = 0;
     this->framePanel = this->contentPanel = 0;
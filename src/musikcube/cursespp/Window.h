@@ -130,6 +130,12 @@ namespace cursespp {
 
             static musik::core::runtime::IMessageQueue& MessageQueue();
 
+#ifndef WIN32
+            /* blocks until there's input on stdin, a message is posted or
+            comes due, or maxWaitMs elapses (-1 waits indefinitely) */
+            static void WaitForEvents(int64_t maxWaitMs = -1);
+#endif
+
         protected:
 
             void BroadcastMessage(int messageType, int64_t user1 = 0, int64_t user2 = 0, int64_t delay = 0);
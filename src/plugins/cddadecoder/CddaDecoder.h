@@ -53,6 +53,7 @@ class CddaDecoder : public IDecoder {
         virtual double GetDuration() override;
         virtual bool GetBuffer(IBuffer *buffer) override;
         virtual bool Exhausted() override { return this->exhausted; }
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
     private:
         CddaDataStream* data;
@@ -61,6 +61,7 @@ class FfmpegDecoder: public musik::core::sdk::IDecoder {
         virtual double GetDuration() override;
         virtual bool Open(musik::core::sdk::IDataStream *stream) override;
         virtual bool Exhausted() override;
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
         IDataStream* Stream() { return this->stream; }
 
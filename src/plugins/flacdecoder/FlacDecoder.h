@@ -53,6 +53,7 @@ class FlacDecoder: public musik::core::sdk::IDecoder {
         virtual double GetDuration() override;
         virtual bool Open(musik::core::sdk::IDataStream *stream) override;
         virtual bool Exhausted() override { return this->exhausted; }
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
     private:
         static FLAC__StreamDecoderReadStatus FlacRead(
@@ -49,6 +49,7 @@ class M4aDecoder : public musik::core::sdk::IDecoder {
         virtual double GetDuration() override;
         virtual bool Open(musik::core::sdk::IDataStream *stream) override;
         virtual bool Exhausted() override { return this->exhausted; }
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
     private:
         NeAACDecHandle decoder;
@@ -0,0 +1,715 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Mp3SeekIndex.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+using namespace musik::core::sdk;
+
+#define INDEX_MAGIC "MCMP3IDX"
+#define INDEX_VERSION 2
+#define SCAN_CHUNK_SIZE 65536
+#define MAX_FRAME_SIZE 4096
+#define MAX_URI_LENGTH 65536
+#define MAX_QUEUED_BUILDS 8
+#define MAX_CACHED_INDEXES 1000
+#define BUILDS_PER_PRUNE 64
+
+namespace {
+    struct BuildJob {
+        std::string uri;
+        std::shared_ptr<std::promise<std::shared_ptr<Mp3SeekIndex>>> promise;
+    };
+}
+
+static std::mutex cacheMutex;
+static std::condition_variable workerCondition;
+static std::string cacheDirectory;
+static IEnvironment* environment = nullptr;
+static std::set<std::string> building; /* queued or in progress */
+static std::deque<BuildJob> jobs;
+static std::unique_ptr<std::thread> worker;
+static std::atomic<bool> workerExit(false);
+
+namespace {
+    struct FrameHeader {
+        int version; /* 1 = MPEG1, 2 = MPEG2, 3 = MPEG2.5 */
+        int layer;
+        int sampleRate;
+        int samplesPerFrame;
+        int length;
+        bool mono;
+    };
+
+    /* reads the stream in large chunks and lets the scanner address it by
+    absolute byte offset. frames are small and mostly visited in order, so
+    this ends up being a single sequential pass over the file. */
+    class ScanBuffer {
+        public:
+            ScanBuffer(IDataStream* stream)
+            : stream(stream), start(0), streamLength(stream->Length()) {
+                this->data.reserve(SCAN_CHUNK_SIZE);
+            }
+
+            const unsigned char* Get(int64_t offset, size_t count) {
+                if (offset < 0 || offset + (int64_t) count > this->streamLength) {
+                    return nullptr;
+                }
+
+                int64_t end = this->start + (int64_t) this->data.size();
+                if (offset < this->start || offset + (int64_t) count > end) {
+                    if (!this->stream->SetPosition((PositionType) offset)) {
+                        return nullptr;
+                    }
+
+                    this->data.resize(SCAN_CHUNK_SIZE);
+                    PositionType read = this->stream->Read(&this->data[0], SCAN_CHUNK_SIZE);
+                    this->data.resize(read > 0 ? (size_t) read : 0);
+                    this->start = offset;
+
+                    if (this->data.size() < count) {
+                        return nullptr;
+                    }
+                }
+
+                return &this->data[(size_t) (offset - this->start)];
+            }
+
+            int64_t Length() const {
+                return this->streamLength;
+            }
+
+        private:
+            IDataStream* stream;
+            std::vector<unsigned char> data;
+            int64_t start;
+            int64_t streamLength;
+    };
+}
+
+static const int BITRATES[2][3][15] = {
+    { /* MPEG1 */
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 }
+    },
+    { /* MPEG2, MPEG2.5 */
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+    }
+};
+
+static const int SAMPLE_RATES[3][3] = {
+    { 44100, 48000, 32000 },
+    { 22050, 24000, 16000 },
+    { 11025, 12000, 8000 }
+};
+
+static bool parseFrameHeader(const unsigned char* h, FrameHeader& header) {
+    if (h[0] != 0xff || (h[1] & 0xe0) != 0xe0) {
+        return false;
+    }
+
+    int versionBits = (h[1] >> 3) & 0x03;
+    int layerBits = (h[1] >> 1) & 0x03;
+    int bitrateIndex = (h[2] >> 4) & 0x0f;
+    int sampleRateIndex = (h[2] >> 2) & 0x03;
+    int padding = (h[2] >> 1) & 0x01;
+
+    /* reserved values, and free format (which we can't walk without
+    decoding) aren't supported */
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 ||
+        bitrateIndex == 15 || sampleRateIndex == 3)
+    {
+        return false;
+    }
+
+    header.version = (versionBits == 3) ? 1 : (versionBits == 2) ? 2 : 3;
+    header.layer = 4 - layerBits;
+    header.sampleRate = SAMPLE_RATES[header.version - 1][sampleRateIndex];
+    header.mono = ((h[3] >> 6) & 0x03) == 3;
+
+    int bitrate = BITRATES[header.version == 1 ? 0 : 1][header.layer - 1][bitrateIndex] * 1000;
+
+    if (header.layer == 1) {
+        header.samplesPerFrame = 384;
+        header.length = (12 * bitrate / header.sampleRate + padding) * 4;
+    }
+    else if (header.layer == 2 || header.version == 1) {
+        header.samplesPerFrame = 1152;
+        header.length = 144 * bitrate / header.sampleRate + padding;
+    }
+    else {
+        header.samplesPerFrame = 576;
+        header.length = 72 * bitrate / header.sampleRate + padding;
+    }
+
+    return header.length > 4;
+}
+
+static bool sameStream(const FrameHeader& a, const FrameHeader& b) {
+    return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+}
+
+/* mpg123 doesn't count a leading Xing/Info/VBRI frame as audio, so we
+can't either, or every offset in the index would be off by one frame. */
+static bool isInfoFrame(const unsigned char* frame, const FrameHeader& header) {
+    if (header.layer != 3) {
+        return false;
+    }
+
+    size_t sideInfo = (header.version == 1)
+        ? (header.mono ? 17 : 32)
+        : (header.mono ? 9 : 17);
+
+    const unsigned char* tag = frame + 4 + sideInfo;
+    if ((size_t) header.length >= 4 + sideInfo + 4 &&
+        (memcmp(tag, "Xing", 4) == 0 || memcmp(tag, "Info", 4) == 0))
+    {
+        return true;
+    }
+
+    return header.length >= 36 + 4 && memcmp(frame + 36, "VBRI", 4) == 0;
+}
+
+static int64_t skipId3v2(ScanBuffer& buffer) {
+    int64_t offset = 0;
+    const unsigned char* h;
+
+    /* there may be more than one... */
+    while ((h = buffer.Get(offset, 10)) != nullptr && memcmp(h, "ID3", 3) == 0) {
+        int64_t size =
+            ((int64_t) (h[6] & 0x7f) << 21) |
+            ((int64_t) (h[7] & 0x7f) << 14) |
+            ((int64_t) (h[8] & 0x7f) << 7) |
+            ((int64_t) (h[9] & 0x7f));
+
+        offset += 10 + size + ((h[5] & 0x10) ? 10 : 0);
+    }
+
+    return offset;
+}
+
+/* finds the next offset with a valid frame header that's followed by
+another valid, compatible frame header. this avoids syncing on false
+0xfff patterns inside garbage or leftover tag data. */
+static int64_t sync(
+    ScanBuffer& buffer,
+    int64_t offset,
+    const FrameHeader* reference,
+    FrameHeader& header)
+{
+    const unsigned char* h;
+    FrameHeader next;
+
+    while ((h = buffer.Get(offset, 4)) != nullptr) {
+        if (parseFrameHeader(h, header) && (!reference || sameStream(*reference, header))) {
+            const unsigned char* n = buffer.Get(offset + header.length, 4);
+
+            if (!n || (parseFrameHeader(n, next) && sameStream(header, next))) {
+                return offset;
+            }
+        }
+
+        ++offset;
+    }
+
+    return -1;
+}
+
+void Mp3SeekIndex::SetCacheDirectory(const std::string& path) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+    cacheDirectory = path;
+}
+
+void Mp3SeekIndex::SetEnvironment(IEnvironment* env) {
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        environment = env;
+    }
+
+    /* no new builds can be queued without an environment, so once the
+    worker is joined it stays down */
+    if (!env) {
+        Shutdown();
+    }
+}
+
+void Mp3SeekIndex::Shutdown() {
+    std::unique_ptr<std::thread> thread;
+
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        workerExit = true;
+        thread = std::move(worker);
+    }
+
+    workerCondition.notify_all();
+
+    /* Build() checks workerExit as it goes, so this won't wait for a long
+    scan to complete */
+    if (thread) {
+        thread->join();
+    }
+
+    std::deque<BuildJob> abandoned;
+
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        abandoned.swap(jobs);
+        building.clear();
+        workerExit = false;
+    }
+
+    for (auto& job : abandoned) {
+        job.promise->set_value(std::shared_ptr<Mp3SeekIndex>());
+    }
+}
+
+bool Mp3SeekIndex::CanIndex(IDataStream* stream) {
+    if (!stream || !stream->Seekable() || stream->Length() <= 0) {
+        return false;
+    }
+
+    /* remote streams (http, https, and the server's transcoders) always
+    have a scheme; local files are plain paths. CanPrefetch() can't be used
+    to tell them apart because LocalFileStream supports prefetching too. */
+    const char* uri = stream->Uri();
+    return uri && *uri && strstr(uri, "://") == nullptr;
+}
+
+int64_t Mp3SeekIndex::ModifiedTime(const std::string& uri) {
+    boost::system::error_code ec;
+    std::time_t time = boost::filesystem::last_write_time(uri, ec);
+    return ec ? -1 : (int64_t) time;
+}
+
+std::string Mp3SeekIndex::CacheFilename(const std::string& uri) {
+    std::unique_lock<std::mutex> lock(cacheMutex);
+
+    if (!cacheDirectory.size()) {
+        return "";
+    }
+
+    return cacheDirectory + std::to_string(std::hash<std::string>()(uri)) + ".idx";
+}
+
+std::shared_ptr<Mp3SeekIndex> Mp3SeekIndex::Build(IDataStream* stream) {
+    if (!stream || !stream->Seekable() || stream->Length() <= 0) {
+        return std::shared_ptr<Mp3SeekIndex>();
+    }
+
+    PositionType originalPosition = stream->Position();
+
+    auto result = std::make_shared<Mp3SeekIndex>();
+    result->streamLength = stream->Length();
+
+    /* read before scanning, so a file modified mid-scan won't match */
+    result->modifiedTime = ModifiedTime(stream->Uri());
+
+    ScanBuffer buffer(stream);
+    FrameHeader first, header;
+
+    int64_t offset = sync(buffer, skipId3v2(buffer), nullptr, first);
+
+    if (offset >= 0) {
+        const unsigned char* frame = buffer.Get(offset, std::min(first.length, MAX_FRAME_SIZE));
+        if (frame && isInfoFrame(frame, first)) {
+            offset = sync(buffer, offset + first.length, &first, header);
+            first = header;
+        }
+    }
+
+    if (offset >= 0) {
+        result->sampleRate = first.sampleRate;
+        result->samplesPerFrame = first.samplesPerFrame;
+
+        /* roughly one entry per second of audio */
+        result->step = std::max(1, first.sampleRate / first.samplesPerFrame);
+
+        const unsigned char* h;
+
+        while (offset >= 0 && !workerExit && (h = buffer.Get(offset, 4)) != nullptr) {
+            if (memcmp(h, "TAG", 3) == 0 && buffer.Length() - offset == 128) {
+                break; /* trailing id3v1 tag */
+            }
+
+            if (!parseFrameHeader(h, header) || !sameStream(first, header)) {
+                /* junk in the middle of the stream, try to find our way
+                back to the next frame */
+                offset = sync(buffer, offset + 1, &first, header);
+                continue;
+            }
+
+            if (result->frameCount % result->step == 0) {
+                result->offsets.push_back(offset);
+            }
+
+            ++result->frameCount;
+            offset += header.length;
+        }
+    }
+
+    stream->SetPosition(originalPosition);
+
+    if (result->frameCount == 0 || workerExit) {
+        return std::shared_ptr<Mp3SeekIndex>();
+    }
+
+    result->Save(stream->Uri());
+
+    return result;
+}
+
+/* reads the header shared by every index file: everything needed to tell
+which file it belongs to, and whether that file has changed since. */
+static bool readHeader(FILE* file, std::string& uri, int64_t& streamLength, int64_t& modifiedTime) {
+    char magic[8];
+    int32_t version = 0;
+    uint32_t uriLength = 0;
+
+    if (fread(magic, sizeof(magic), 1, file) != 1 ||
+        memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 ||
+        version != INDEX_VERSION ||
+        fread(&uriLength, sizeof(uriLength), 1, file) != 1 ||
+        uriLength > MAX_URI_LENGTH)
+    {
+        return false;
+    }
+
+    uri.assign(uriLength, '\0');
+
+    return
+        (uriLength == 0 || fread(&uri[0], uriLength, 1, file) == 1) &&
+        fread(&streamLength, sizeof(streamLength), 1, file) == 1 &&
+        fread(&modifiedTime, sizeof(modifiedTime), 1, file) == 1;
+}
+
+/* removes index files that are orphaned (the file is gone), stale (the file
+changed), or unreadable, then the least recently used ones until we're back
+under MAX_CACHED_INDEXES. Load() bumps an index's mtime when it's used. */
+void Mp3SeekIndex::Prune(const std::string& directory) {
+    namespace fs = boost::filesystem;
+
+    std::vector<std::pair<std::time_t, fs::path>> entries;
+    boost::system::error_code ec;
+
+    fs::directory_iterator end;
+    for (fs::directory_iterator it(directory, ec); !ec && it != end && !workerExit; it.increment(ec)) {
+        const fs::path path = it->path();
+
+        if (path.extension() != ".idx") {
+            continue;
+        }
+
+        std::string uri;
+        int64_t streamLength = 0, indexedTime = -1;
+        bool current = false;
+
+        FILE* file = fopen(path.string().c_str(), "rb");
+        if (file) {
+            current = readHeader(file, uri, streamLength, indexedTime);
+            fclose(file);
+        }
+
+        if (current) {
+            boost::system::error_code sizeError;
+            uintmax_t size = fs::file_size(uri, sizeError);
+            current = !sizeError &&
+                (int64_t) size == streamLength &&
+                indexedTime != -1 &&
+                ModifiedTime(uri) == indexedTime;
+        }
+
+        boost::system::error_code removeError;
+        if (!current) {
+            fs::remove(path, removeError);
+        }
+        else {
+            std::time_t lastUsed = fs::last_write_time(path, removeError);
+            entries.push_back({ removeError ? 0 : lastUsed, path });
+        }
+    }
+
+    if (entries.size() > MAX_CACHED_INDEXES) {
+        std::sort(entries.begin(), entries.end());
+        size_t extra = entries.size() - MAX_CACHED_INDEXES;
+        for (size_t i = 0; i < extra; i++) {
+            boost::system::error_code removeError;
+            fs::remove(entries[i].second, removeError);
+        }
+    }
+}
+
+/* a single worker builds indexes one at a time, so opening a lot of files
+at once (e.g. scrolling through a playlist) can't fan out into a thread
+per file. it's started on demand and joined by Shutdown(). */
+static void workerLoop() {
+    size_t builds = 0;
+
+    while (!workerExit) {
+        std::string directory;
+        BuildJob job;
+        IEnvironment* env = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(cacheMutex);
+
+            directory = cacheDirectory;
+
+            if (builds % BUILDS_PER_PRUNE != 0 || !directory.size()) {
+                while (!workerExit && jobs.empty()) {
+                    workerCondition.wait(lock);
+                }
+
+                if (workerExit) {
+                    return;
+                }
+
+                job = jobs.front();
+                jobs.pop_front();
+                env = environment;
+            }
+        }
+
+        if (!job.promise) {
+            /* the first pass (and every BUILDS_PER_PRUNE builds after that)
+            cleans up the cache before picking up more work */
+            Mp3SeekIndex::Prune(directory);
+            ++builds;
+            continue;
+        }
+
+        std::shared_ptr<Mp3SeekIndex> result;
+
+        /* the decoder's stream belongs to the decoder's thread, so the
+        scan gets its own. the environment itself outlives us; the plugin
+        is only unloaded after Shutdown() joins this thread. */
+        IDataStream* stream = env ? env->GetDataStream(job.uri.c_str()) : nullptr;
+
+        if (stream) {
+            try {
+                result = Mp3SeekIndex::Build(stream);
+            }
+            catch (...) {
+            }
+
+            stream->Release();
+        }
+
+        ++builds;
+
+        {
+            std::unique_lock<std::mutex> lock(cacheMutex);
+            building.erase(job.uri);
+        }
+
+        job.promise->set_value(result);
+    }
+}
+
+Mp3SeekIndex::Future Mp3SeekIndex::BuildAsync(const std::string& uri) {
+    auto promise = std::make_shared<std::promise<std::shared_ptr<Mp3SeekIndex>>>();
+    Future future = promise->get_future().share();
+    std::shared_ptr<std::promise<std::shared_ptr<Mp3SeekIndex>>> dropped;
+
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+
+        if (!environment || workerExit || building.find(uri) != building.end()) {
+            return Future();
+        }
+
+        /* the queue is bounded. the most recently opened file is the one
+        most likely to be seeked, so drop the oldest request to make room. */
+        if (jobs.size() >= MAX_QUEUED_BUILDS) {
+            dropped = jobs.front().promise;
+            building.erase(jobs.front().uri);
+            jobs.pop_front();
+        }
+
+        jobs.push_back({ uri, promise });
+        building.insert(uri);
+
+        if (!worker) {
+            worker.reset(new std::thread(&workerLoop));
+        }
+    }
+
+    workerCondition.notify_one();
+
+    if (dropped) {
+        dropped->set_value(std::shared_ptr<Mp3SeekIndex>());
+    }
+
+    return future;
+}
+
+std::shared_ptr<Mp3SeekIndex> Mp3SeekIndex::Load(IDataStream* stream) {
+    if (!stream) {
+        return std::shared_ptr<Mp3SeekIndex>();
+    }
+
+    std::string uri = stream->Uri();
+    std::string filename = CacheFilename(uri);
+
+    if (!filename.size()) {
+        return std::shared_ptr<Mp3SeekIndex>();
+    }
+
+    FILE* file = fopen(filename.c_str(), "rb");
+
+    if (!file) {
+        return std::shared_ptr<Mp3SeekIndex>();
+    }
+
+    auto result = std::make_shared<Mp3SeekIndex>();
+
+    std::string storedUri;
+    uint64_t count = 0;
+
+    bool valid =
+        readHeader(file, storedUri, result->streamLength, result->modifiedTime) &&
+        storedUri == uri &&
+        result->streamLength == (int64_t) stream->Length() &&
+        result->modifiedTime != -1 &&
+        result->modifiedTime == ModifiedTime(uri) &&
+        fread(&result->sampleRate, sizeof(result->sampleRate), 1, file) == 1 &&
+        fread(&result->samplesPerFrame, sizeof(result->samplesPerFrame), 1, file) == 1 &&
+        fread(&result->step, sizeof(result->step), 1, file) == 1 &&
+        fread(&result->frameCount, sizeof(result->frameCount), 1, file) == 1 &&
+        fread(&count, sizeof(count), 1, file) == 1 &&
+        result->sampleRate > 0 && result->samplesPerFrame > 0 && result->step > 0 &&
+        count == (uint64_t) ((result->frameCount + result->step - 1) / result->step);
+
+    if (valid && count > 0) {
+        result->offsets.resize((size_t) count);
+        valid = fread(&result->offsets[0], sizeof(int64_t), (size_t) count, file) == count;
+    }
+
+    fclose(file);
+
+    /* touch valid indexes so pruning can evict the least recently used
+    ones first. invalid ones will be rebuilt, and replaced, anyway. */
+    boost::system::error_code ec;
+    if (valid) {
+        boost::filesystem::last_write_time(filename, time(nullptr), ec);
+    }
+    else {
+        boost::filesystem::remove(filename, ec);
+    }
+
+    return valid ? result : std::shared_ptr<Mp3SeekIndex>();
+}
+
+bool Mp3SeekIndex::Save(const std::string& uri) {
+    std::string filename = CacheFilename(uri);
+
+    /* without a modified time we can't tell if the file changed out from
+    under us, so don't cache it. */
+    if (!filename.size() || this->modifiedTime == -1) {
+        return false;
+    }
+
+    FILE* file = fopen(filename.c_str(), "wb");
+
+    if (!file) {
+        return false;
+    }
+
+    int32_t version = INDEX_VERSION;
+    uint32_t uriLength = (uint32_t) uri.size();
+    uint64_t count = (uint64_t) this->offsets.size();
+
+    bool success =
+        fwrite(INDEX_MAGIC, 8, 1, file) == 1 &&
+        fwrite(&version, sizeof(version), 1, file) == 1 &&
+        fwrite(&uriLength, sizeof(uriLength), 1, file) == 1 &&
+        (uriLength == 0 || fwrite(uri.c_str(), uriLength, 1, file) == 1) &&
+        fwrite(&this->streamLength, sizeof(this->streamLength), 1, file) == 1 &&
+        fwrite(&this->modifiedTime, sizeof(this->modifiedTime), 1, file) == 1 &&
+        fwrite(&this->sampleRate, sizeof(this->sampleRate), 1, file) == 1 &&
+        fwrite(&this->samplesPerFrame, sizeof(this->samplesPerFrame), 1, file) == 1 &&
+        fwrite(&this->step, sizeof(this->step), 1, file) == 1 &&
+        fwrite(&this->frameCount, sizeof(this->frameCount), 1, file) == 1 &&
+        fwrite(&count, sizeof(count), 1, file) == 1 &&
+        (count == 0 || fwrite(&this->offsets[0], sizeof(int64_t), (size_t) count, file) == count);
+
+    fclose(file);
+
+    if (!success) {
+        boost::system::error_code ec;
+        boost::filesystem::remove(filename, ec);
+    }
+
+    return success;
+}
+
+bool Mp3SeekIndex::Apply(mpg123_handle* decoder) {
+    if (!decoder || this->offsets.empty()) {
+        return false;
+    }
+
+    /* mpg123 wants off_t, which may be narrower than what we store */
+    std::vector<off_t> table(this->offsets.begin(), this->offsets.end());
+
+    return mpg123_set_index(
+        decoder,
+        &table[0],
+        (off_t) this->step,
+        table.size()) == MPG123_OK;
+}
+
+double Mp3SeekIndex::GetDuration() const {
+    if (this->sampleRate <= 0) {
+        return 0.0;
+    }
+
+    return (double) (this->frameCount * this->samplesPerFrame) / (double) this->sampleRate;
+}
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/sdk/IDataStream.h>
+#include <core/sdk/IEnvironment.h>
+
+#include <mpg123.h>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/* a compact table of MPEG frame byte offsets, one entry roughly every
+second of audio. it's built by walking the frame headers once (no
+decoding), cached on disk, and handed to mpg123 via mpg123_set_index() so
+seeks in long VBR files jump straight to the right byte offset instead of
+feeding the file in from the start. the frame count also gives us an
+exact duration. */
+class Mp3SeekIndex {
+    public:
+        using Future = std::shared_future<std::shared_ptr<Mp3SeekIndex>>;
+
+        static void SetCacheDirectory(const std::string& path);
+        static void SetEnvironment(musik::core::sdk::IEnvironment* environment);
+
+        /* only local files are indexed; we don't want to pull an entire
+        remote stream down just to build an index. */
+        static bool CanIndex(musik::core::sdk::IDataStream* stream);
+
+        /* returns the cached index for the stream, or nullptr if there's
+        no valid one on disk. */
+        static std::shared_ptr<Mp3SeekIndex> Load(musik::core::sdk::IDataStream* stream);
+
+        /* scans the stream's frame headers and writes the result to the
+        cache. the stream's position is restored before returning. */
+        static std::shared_ptr<Mp3SeekIndex> Build(musik::core::sdk::IDataStream* stream);
+
+        /* queues a build on the background worker, which opens its own
+        stream for the uri. the queue is bounded; if it's full the oldest
+        request is dropped (its future resolves to nullptr). returns an
+        invalid future if the same uri is already queued, or no environment
+        is available. */
+        static Future BuildAsync(const std::string& uri);
+
+        /* stops and joins the background worker; pending builds resolve to
+        nullptr. called when the environment is torn down. */
+        static void Shutdown();
+
+        /* removes orphaned and stale index files from the cache directory,
+        then the least recently used ones if there are too many. runs on
+        the background worker. */
+        static void Prune(const std::string& directory);
+
+        bool Apply(mpg123_handle* decoder);
+        double GetDuration() const;
+
+    private:
+        static std::string CacheFilename(const std::string& uri);
+        static int64_t ModifiedTime(const std::string& uri);
+
+        bool Save(const std::string& uri);
+
+        std::vector<int64_t> offsets;
+        int64_t step{ 1 };
+        int64_t frameCount{ 0 };
+        int64_t streamLength{ 0 };
+        int64_t modifiedTime{ -1 };
+        int32_t sampleRate{ 0 };
+        int32_t samplesPerFrame{ 0 };
+};
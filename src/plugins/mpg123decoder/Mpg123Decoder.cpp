@@ -34,6 +34,7 @@
 
 #include "Mpg123Decoder.h"
 #include <stdio.h>
+#include <chrono>
 
 #define STREAM_FEED_SIZE 2048 * 2
 #define MPG123_DECODER_DEBUG 0
@@ -50,6 +51,7 @@ Mpg123Decoder::Mpg123Decoder()
 , sampleRate(44100)
 , channels(2)
 , fileStream(NULL)
+, intent(DecodeIntent::Playback)
 , lastMpg123Status(MPG123_NEED_MORE) {
     this->decoder = mpg123_new(NULL, NULL);
     this->sampleSizeBytes = sizeof(float);
@@ -67,7 +69,15 @@ void Mpg123Decoder::Destroy() {
     delete this;
 }
 
+void Mpg123Decoder::SetIntent(DecodeIntent intent) {
+    this->intent = intent;
+}
+
 double Mpg123Decoder::GetDuration() {
+    if (this->seekIndex) {
+        return this->seekIndex->GetDuration();
+    }
+
     if (this->decoder) {
         return (double) mpg123_length(this->decoder) / (double) this->sampleRate;
     }
@@ -76,13 +86,22 @@ double Mpg123Decoder::GetDuration() {
 }
 
 double Mpg123Decoder::SetPosition(double second) {
+    /* if the index we started building in Open() is ready, hand it to
+    mpg123; from then on mpg123_feedseek() can compute the exact byte
+    offset for any frame without feeding the file in. until then, seeks
+    fall back to mpg123's own (fuzzy) seeking. */
+    if (!this->seekIndex && this->pendingSeekIndex.valid() &&
+        this->pendingSeekIndex.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        this->seekIndex = this->pendingSeekIndex.get();
+        this->pendingSeekIndex = Mp3SeekIndex::Future();
+        if (this->seekIndex && !this->seekIndex->Apply(this->decoder)) {
+            this->seekIndex.reset();
+        }
+    }
+
     off_t seekToFileOffset = 0;
     off_t seekToSampleOffset = (off_t) (second * (double)this->sampleRate);
-    off_t *indexOffset = 0;
-    off_t indexSet = 0;
-    size_t indexFill = 0;
-    int err = mpg123_index(this->decoder, &indexOffset, &indexSet, &indexFill);
-
     off_t seekedTo = 0;
     int feedMore = 20;
     while((seekedTo = mpg123_feedseek(
@@ -209,6 +228,22 @@ bool Mpg123Decoder::Open(IDataStream *fileStream){
                 MPG123_STEREO,
                 MPG123_ENC_FLOAT_32);
 
+            /* if we've indexed this file before, use it right away. note
+            this needs to happen after mpg123_open_feed(), which resets
+            the decoder's internal index. otherwise, index it in the
+            background so the first seek doesn't have to scan the file. streams
+            that are only read start to finish (analysis, transcoding) won't
+            seek, so they don't queue a build. */
+            if (Mp3SeekIndex::CanIndex(this->fileStream)) {
+                this->seekIndex = Mp3SeekIndex::Load(this->fileStream);
+                if (this->seekIndex && !this->seekIndex->Apply(this->decoder)) {
+                    this->seekIndex.reset();
+                }
+                if (!this->seekIndex && this->intent == DecodeIntent::Playback) {
+                    this->pendingSeekIndex = Mp3SeekIndex::BuildAsync(this->fileStream->Uri());
+                }
+            }
+
             return true;
         }
     }
@@ -37,6 +37,8 @@
 #include <core/sdk/IDecoder.h>
 #include <core/sdk/IDataStream.h>
 
+#include "Mp3SeekIndex.h"
+
 #include <mpg123.h>
 
 class Mpg123Decoder : public musik::core::sdk::IDecoder {
@@ -49,6 +51,7 @@ class Mpg123Decoder : public musik::core::sdk::IDecoder {
         virtual bool GetBuffer(musik::core::sdk::IBuffer *buffer);
         virtual void Destroy();
         virtual double GetDuration();
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent);
 
     private:
         bool Feed();
@@ -56,6 +59,9 @@ class Mpg123Decoder : public musik::core::sdk::IDecoder {
     private:
         musik::core::sdk::IDataStream *fileStream;
         mpg123_handle *decoder;
+        std::shared_ptr<Mp3SeekIndex> seekIndex;
+        Mp3SeekIndex::Future pendingSeekIndex;
+        musik::core::sdk::DecodeIntent intent;
 
         unsigned long cachedLength;
         long sampleRate;
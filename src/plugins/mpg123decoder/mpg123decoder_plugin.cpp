@@ -34,7 +34,11 @@
 
 #include "stdafx.h"
 #include <core/sdk/IPlugin.h>
+#include <core/sdk/IEnvironment.h>
 #include "Mpg123DecoderFactory.h"
+#include "Mp3SeekIndex.h"
+
+#include <boost/filesystem.hpp>
 
 #ifdef WIN32
 #define DLLEXPORT __declspec(dllexport)
@@ -67,3 +71,21 @@ extern "C" DLLEXPORT musik::core::sdk::IPlugin* GetPlugin() {
 extern "C" DLLEXPORT musik::core::sdk::IDecoderFactory* GetDecoderFactory() {
     return new Mpg123DecoderFactory();
 }
+
+extern "C" DLLEXPORT void SetEnvironment(musik::core::sdk::IEnvironment* environment) {
+    if (environment) {
+        char buffer[2048];
+        environment->GetPath(musik::core::sdk::PathData, buffer, sizeof(buffer));
+        std::string path = std::string(buffer) + "/cache/mp3index/";
+
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(path, ec);
+
+        Mp3SeekIndex::SetCacheDirectory(ec ? "" : path);
+    }
+    else {
+        Mp3SeekIndex::SetCacheDirectory("");
+    }
+
+    Mp3SeekIndex::SetEnvironment(environment);
+}
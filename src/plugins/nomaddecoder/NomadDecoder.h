@@ -52,6 +52,7 @@ class NomadDecoder : public musik::core::sdk::IDecoder {
         virtual double GetDuration() override;
         virtual void Release() override;
         virtual bool Exhausted() override { return this->exhausted; }
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
     private:
         size_t GetId3v2HeaderLength(musik::core::sdk::IDataStream *stream);
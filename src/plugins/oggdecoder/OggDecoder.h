@@ -51,6 +51,7 @@ class OggDecoder : public IDecoder {
         virtual double GetDuration() override;
         virtual bool Open(musik::core::sdk::IDataStream *fileStream) override;
         virtual bool Exhausted() override { return this->exhausted; }
+        virtual void SetIntent(musik::core::sdk::DecodeIntent intent) override { }
 
         /* libvorbis callbacks */
         static size_t OggRead(void *buffer, size_t nofParts, size_t partSize, void *datasource);
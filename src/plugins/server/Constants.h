@@ -35,8 +35,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "Util.h"
 
+#include <core/sdk/constants.h>
+#include <core/sdk/ITrackListEditor.h>
+
 //#define ENABLE_DEBUG 1
 
 namespace defaults {
@@ -47,6 +51,10 @@ namespace defaults {
     static const bool use_ipv6 = false;
     static const bool transcoder_synchronous = false;
     static const bool transcoder_synchronous_fallback = false;
+    static const int http_server_thread_pool_size = 0;
+    static const int http_server_connection_limit = 0;
+    static const int http_server_per_ip_connection_limit = 0;
+    static const int http_server_connection_timeout = 0;
 }
 
 namespace prefs {
@@ -58,6 +66,10 @@ namespace prefs {
     static const std::string transcoder_cache_count = "transcoder_cache_count";
     static const std::string transcoder_synchronous = "transcoder_synchronous";
     static const std::string transcoder_synchronous_fallback = "transcoder_synchronous_fallback";
+    static const std::string http_server_thread_pool_size = "http_server_thread_pool_size";
+    static const std::string http_server_connection_limit = "http_server_connection_limit";
+    static const std::string http_server_per_ip_connection_limit = "http_server_per_ip_connection_limit";
+    static const std::string http_server_connection_timeout = "http_server_connection_timeout";
 }
 
 namespace message {
@@ -137,6 +149,21 @@ namespace key {
     static const std::string replaygain_mode = "replaygain_mode";
     static const std::string preamp_gain = "preamp_gain";
     static const std::string time = "time";
+    static const std::string encoding = "encoding";
+    static const std::string track_fields = "track_fields";
+    static const std::string message_keys = "message_keys";
+    static const std::string from_revision = "from_revision";
+    static const std::string revision = "revision";
+    static const std::string edits = "edits";
+    static const std::string from = "from";
+    static const std::string to = "to";
+    static const std::string track = "track";
+    static const std::string stream = "stream";
+    static const std::string chunk_size = "chunk_size";
+    static const std::string partial = "partial";
+    static const std::string total = "total";
+    static const std::string cursor = "cursor";
+    static const std::string next_cursor = "next_cursor";
 }
 
 namespace value {
@@ -149,6 +176,13 @@ namespace value {
     static const std::string rebuild = "rebuild";
     static const std::string live = "live";
     static const std::string snapshot = "snapshot";
+    static const std::string json = "json";
+    static const std::string msgpack = "msgpack";
+    static const std::string insert = "insert";
+    static const std::string swap = "swap";
+    static const std::string move = "move";
+    static const std::string remove = "delete";
+    static const std::string add = "add";
 }
 
 namespace type {
@@ -199,6 +233,9 @@ namespace request {
     static const std::string set_transport_type = "set_transport_type";
     static const std::string snapshot_play_queue = "snapshot_play_queue";
     static const std::string invalidate_play_queue_snapshot = "invalidate_play_queue_snapshot";
+    static const std::string query_play_queue_edits = "query_play_queue_edits";
+    static const std::string get_metrics = "get_metrics";
+    static const std::string cancel_query = "cancel_query";
 }
 
 namespace fragment {
@@ -206,6 +243,7 @@ namespace fragment {
     static const std::string id = "id";
     static const std::string external_id = "external_id";
     static const std::string thumbnail = "thumbnail";
+    static const std::string metrics = "metrics";
 }
 
 namespace broadcast {
@@ -232,9 +270,97 @@ static auto REPLAYGAIN_MODE_TO_STRING = makeBimap<musik::core::sdk::ReplayGainMo
     { musik::core::sdk::ReplayGainMode::Track, "track" },
 });
 
+static auto TRACK_LIST_EDIT_TYPE_TO_STRING = makeBimap<musik::core::sdk::TrackListEditType, std::string>({
+    { musik::core::sdk::TrackListEditType::Insert, value::insert },
+    { musik::core::sdk::TrackListEditType::Swap, value::swap },
+    { musik::core::sdk::TrackListEditType::Move, value::move },
+    { musik::core::sdk::TrackListEditType::Delete, value::remove },
+    { musik::core::sdk::TrackListEditType::Add, value::add },
+});
+
 static auto TRANSPORT_TYPE_TO_STRING = makeBimap<musik::core::sdk::TransportType, std::string>({
     { musik::core::sdk::TransportType::Gapless, "gapless" },
     { musik::core::sdk::TransportType::Crossfade, "crossfade" },
 });
 
-static const int ApiVersion = 15;
+/* when a client negotiates a binary encoding, track records are sent as
+positional arrays instead of objects; the index of each key in this list is
+its field id. the list is returned to the client during authentication. NEVER
+re-order existing entries, only append new ones. */
+static const std::vector<std::string> TRACK_FIELDS = {
+    key::id,
+    key::external_id,
+    key::title,
+    key::track_num,
+    key::album,
+    key::album_id,
+    key::album_artist,
+    key::album_artist_id,
+    key::artist,
+    key::artist_id,
+    key::genre,
+    key::genre_id,
+    key::thumbnail_id
+};
+
+/* when a client negotiates a binary encoding, message envelope keys and the
+top-level keys of a message's options are sent as the (stringified) index of
+the key in this list. the list is returned to the client during
+authentication. NEVER re-order existing entries, only append new ones. */
+static const std::vector<std::string> MESSAGE_KEYS = {
+    message::name,
+    message::type,
+    message::id,
+    message::options,
+    message::device_id,
+    key::data,
+    key::count,
+    key::limit,
+    key::offset,
+    key::filter,
+    key::category,
+    key::category_id,
+    key::ids,
+    key::index,
+    key::success,
+    key::error,
+    key::state,
+    key::volume,
+    key::position,
+    key::repeat_mode,
+    key::shuffled,
+    key::muted,
+    key::play_queue_count,
+    key::play_queue_position,
+    key::playing_duration,
+    key::playing_current_time,
+    key::playing_track,
+    key::predicates,
+    key::predicate_category,
+    key::predicate_id,
+    key::external_ids,
+    key::ids_only,
+    key::count_only,
+    key::revision,
+    key::edits,
+    key::value,
+    key::time,
+    key::delta,
+    key::relative,
+    key::playlist_id,
+    key::playlist_name,
+    key::subquery,
+    key::sort_order,
+    key::from,
+    key::to,
+    key::track,
+    key::stream,
+    key::chunk_size,
+    key::partial,
+    key::total,
+    key::cursor,
+    key::next_cursor,
+    key::from_revision
+};
+
+static const int ApiVersion = 20;
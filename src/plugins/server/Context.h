@@ -39,6 +39,8 @@
 #include <core/sdk/IPlaybackService.h>
 #include <core/sdk/IEnvironment.h>
 
+#include "Metrics.h"
+
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/locks.hpp>
 
@@ -73,5 +75,6 @@ struct Context {
     musik::core::sdk::IPreferences* prefs;
     musik::core::sdk::IPlaybackService* playback;
     musik::core::sdk::IEnvironment* environment;
+    Metrics metrics;
     ReadWriteLock lock;
 };
\ No newline at end of file
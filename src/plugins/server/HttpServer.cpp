@@ -37,6 +37,7 @@
 #include "Util.h"
 #include "Transcoder.h"
 #include "TranscodingDataStream.h"
+#include "ThumbnailCache.h"
 
 #include <core/sdk/ITrack.h>
 
@@ -44,16 +45,22 @@
 #include <boost/algorithm/string.hpp>
 
 #include <websocketpp/base64/base64.hpp>
+#include <websocketpp/sha1/sha1.hpp>
 
+#include <algorithm>
+#include <ctime>
 #include <iostream>
 #include <unordered_map>
 #include <string>
 
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 #ifdef WIN32
 #include <io.h>
+#else
+#include <unistd.h>
 #endif
 
 #include <vector>
@@ -145,6 +152,32 @@ static void fileFreeCallback(void *cls) {
     delete range;
 }
 
+static int openFileDescriptor(const std::string& filename, size_t expectedSize) {
+    /* only regular, local files can be served directly from an fd; anything
+    else (e.g. remote uris) continues to go through the IDataStream */
+    int fd = -1;
+
+#ifdef WIN32
+    fd = _wopen(utf8to16(filename.c_str()).c_str(), _O_RDONLY | _O_BINARY);
+#else
+    fd = open(filename.c_str(), O_RDONLY);
+#endif
+
+    if (fd != -1) {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG || (size_t) info.st_size != expectedSize) {
+#ifdef WIN32
+            _close(fd);
+#else
+            close(fd);
+#endif
+            fd = -1;
+        }
+    }
+
+    return fd;
+}
+
 static Range* parseRange(IDataStream* file, const char* range) {
     Range* result = new Range();
 
@@ -233,6 +266,48 @@ static std::string getStringUrlParam(
     return stringValue ? std::string(stringValue) : defaultValue;
 }
 
+/* derived from the file's identity rather than its content, so we don't have
+to read the file to validate a request. files under thumbs/ are re-written
+(and get a new mtime) whenever their content changes. */
+static std::string fileEtag(const std::string& path, std::time_t modified, uintmax_t size) {
+    static const char* HEX = "0123456789abcdef";
+    std::string identity = path + ":" + std::to_string(modified) + ":" + std::to_string(size);
+    unsigned char digest[20];
+    websocketpp::sha1::calc(identity.data(), identity.size(), digest);
+    std::string result = "\"";
+    for (unsigned char c : digest) {
+        result += HEX[c >> 4];
+        result += HEX[c & 0x0f];
+    }
+    return result + "\"";
+}
+
+/* If-None-Match: "*", or a comma separated list of (possibly weak) tags.
+uses the weak comparison function, per RFC 7232 section 3.2. */
+static bool etagMatches(const char* ifNoneMatch, const std::string& etag) {
+    if (!ifNoneMatch) {
+        return false;
+    }
+
+    std::vector<std::string> tags;
+    boost::split(tags, ifNoneMatch, boost::is_any_of(","));
+
+    for (auto& tag : tags) {
+        boost::trim(tag);
+        if (tag == "*") {
+            return true;
+        }
+        if (boost::starts_with(tag, "W/")) {
+            tag = tag.substr(2);
+        }
+        if (tag == etag) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static bool isAuthenticated(MHD_Connection *connection, Context& context) {
     const char* authPtr = MHD_lookup_connection_value(
         connection, MHD_HEADER_KIND, "Authorization");
@@ -284,6 +359,24 @@ bool HttpServer::Start() {
             ipVersion = MHD_USE_IPv6;
         }
 
+        /* optional tuning parameters; zero means "use the libmicrohttpd
+        default", so we only pass the ones that were actually specified. */
+        std::vector<MHD_OptionItem> options;
+
+        auto addOption = [this, &options](MHD_OPTION option, const std::string& key, int defaultValue) {
+            int value = context.prefs->GetInt(key.c_str(), defaultValue);
+            if (value > 0) {
+                options.push_back({ option, (intptr_t) value, nullptr });
+            }
+        };
+
+        addOption(MHD_OPTION_THREAD_POOL_SIZE, prefs::http_server_thread_pool_size, defaults::http_server_thread_pool_size);
+        addOption(MHD_OPTION_CONNECTION_LIMIT, prefs::http_server_connection_limit, defaults::http_server_connection_limit);
+        addOption(MHD_OPTION_PER_IP_CONNECTION_LIMIT, prefs::http_server_per_ip_connection_limit, defaults::http_server_per_ip_connection_limit);
+        addOption(MHD_OPTION_CONNECTION_TIMEOUT, prefs::http_server_connection_timeout, defaults::http_server_connection_timeout);
+
+        options.push_back({ MHD_OPTION_END, 0, nullptr });
+
         httpServer = MHD_start_daemon(
 #if MHD_VERSION >= 0x00095300
             MHD_USE_AUTO | MHD_USE_INTERNAL_POLLING_THREAD | ipVersion,
@@ -299,6 +392,7 @@ bool HttpServer::Start() {
             &HttpServer::HandleUnescape,
             this,
             MHD_OPTION_LISTENING_ADDRESS_REUSE, 1,
+            MHD_OPTION_ARRAY, options.data(),
             MHD_OPTION_END);
 
         this->running = (httpServer != nullptr);
@@ -341,6 +435,7 @@ int HttpServer::HandleRequest(
 #endif
 
     HttpServer* server = static_cast<HttpServer*>(cls);
+    ++server->context.metrics.httpRequests;
 
     struct MHD_Response* response = nullptr;
     int ret = MHD_NO;
@@ -350,6 +445,7 @@ int HttpServer::HandleRequest(
         if (method && std::string(method) == "GET") {
             if (!isAuthenticated(connection, server->context)) {
                 status = 401; /* unauthorized */
+                ++server->context.metrics.httpUnauthorized;
                 static const char* error = "unauthorized";
                 response = MHD_create_response_from_buffer(strlen(error), (void*)error, MHD_RESPMEM_PERSISTENT);
 
@@ -376,6 +472,10 @@ int HttpServer::HandleRequest(
                     else if (parts.at(0) == fragment::thumbnail && parts.size() == 2) {
                         status = HandleThumbnailRequest(server, response, connection, parts);
                     }
+                    /* /metrics */
+                    else if (parts.at(0) == fragment::metrics && parts.size() == 1) {
+                        status = HandleMetricsRequest(server, response, connection);
+                    }
                 }
             }
         }
@@ -463,10 +563,24 @@ int HttpServer::HandleAudioTrackRequest(
         std::cerr << "on demand? " << isOnDemandTranscoder << std::endl;
 #endif
 
+        /* constant bitrate mp3 output can be joined mid-stream, so for those
+        we can satisfy a range request by seeking the transcoder (which maps
+        the byte offset to a time offset and starts a new encoder segment). */
+        bool isSeekableTranscoder = isOnDemandTranscoder && format == "mp3";
+
         /* gotta be careful with request ranges if we're transcoding. don't
         allow any custom ranges other than from 0 to end. */
         if (isOnDemandTranscoder && rangeVal && strlen(rangeVal)) {
-            if (range->from != 0 || range->to != range->total - 1) {
+            bool seeked = isSeekableTranscoder &&
+                range->to == range->total - 1 &&
+                file->SetPosition(range->from);
+
+            if (seeked) {
+#ifdef ENABLE_DEBUG
+                std::cerr << "seeked ondemand transcoder to " << range->from << "\n";
+#endif
+            }
+            else if (range->from != 0 || range->to != range->total - 1) {
                 delete range;
 
 #ifdef ENABLE_DEBUG
@@ -511,12 +625,56 @@ int HttpServer::HandleAudioTrackRequest(
         if (file) {
             size_t length = (range->to - range->from);
 
-            response = MHD_create_response_from_callback(
-                length == 0 ? MHD_SIZE_UNKNOWN : length + 1,
-                4096,
-                &fileReadCallback,
-                range,
-                &fileFreeCallback);
+            /* if we're serving a regular local file, hand libmicrohttpd the
+            descriptor directly; it can use sendfile() and avoid copying every
+            byte through the IDataStream. */
+            int fd = -1;
+            if (!isOnDemandTranscoder && range->total > 0) {
+                /* with a bitrate, `file` is a previously cached transcode, so
+                open that -- never the original source */
+                std::string servedFilename = (bitrate == 0)
+                    ? filename
+                    : Transcoder::GetCachedFilename(server->context, filename, bitrate, format);
+
+                fd = openFileDescriptor(servedFilename, range->total);
+            }
+
+            if (fd != -1) {
+                response = MHD_create_response_from_fd_at_offset64(length + 1, fd, range->from);
+
+                if (response) {
+                    /* the response owns the descriptor now; we just need to
+                    hang on to the range so we can build the headers */
+                    ++server->context.metrics.httpFileDescriptorResponses;
+                    range->file = nullptr;
+                    file->Release();
+                    file = nullptr;
+                }
+                else {
+#ifdef WIN32
+                    _close(fd);
+#else
+                    close(fd);
+#endif
+                }
+            }
+
+            if (!response) {
+                response = MHD_create_response_from_callback(
+                    length == 0 ? MHD_SIZE_UNKNOWN : length + 1,
+                    4096,
+                    &fileReadCallback,
+                    range,
+                    &fileFreeCallback);
+
+                if (response) {
+                    ++server->context.metrics.httpStreamResponses;
+                }
+            }
+
+            if (response && length > 0) {
+                server->context.metrics.httpBytesQueued += length + 1;
+            }
 
 #ifdef ENABLE_DEBUG
             std::cerr << "response length: " << ((length == 0) ? 0 : length + 1) << "\n";
@@ -524,10 +682,11 @@ int HttpServer::HandleAudioTrackRequest(
 #endif
 
             if (response) {
-                if (!isOnDemandTranscoder) {
+                if (!isOnDemandTranscoder || isSeekableTranscoder) {
                     MHD_add_response_header(response, "Accept-Ranges", "bytes");
                 }
-                else {
+
+                if (isOnDemandTranscoder) {
                     MHD_add_response_header(response, "X-musikcube-Estimated-Content-Length", "true");
                 }
 
@@ -560,6 +719,10 @@ int HttpServer::HandleAudioTrackRequest(
 #endif
                     }
                 }
+
+                if (!file) {
+                    delete range; /* fd-backed response, the range isn't owned by MHD */
+                }
             }
             else {
                 file->Release();
@@ -583,21 +746,82 @@ int HttpServer::HandleThumbnailRequest(
     server->context.environment->GetPath(
         PathType::PathLibrary, pathBuffer, sizeof(pathBuffer));
 
-    if (strlen(pathBuffer)) {
-        std::string path = std::string(pathBuffer) + "thumbs/" + pathParts.at(1) + ".jpg";
+    /* thumbnail ids are integers; anything else can't be a valid file, and
+    we don't want it to become part of a path we might write to. */
+    const std::string& id = pathParts.at(1);
+    bool validId = id.size() && std::all_of(id.begin(), id.end(), ::isdigit);
+
+    if (strlen(pathBuffer) && validId) {
+        /* ?size=<n> requests a downscaled variant, n pixels on the longest
+        side (rounded up to one of the sizes the cache generates) */
+        int size = (int) std::min(getUnsignedUrlParam(connection, "size", 0), (size_t) 65536);
+
+        std::string path = ThumbnailCache::Resolve(
+            std::string(pathBuffer) + "thumbs/", id, size);
+
+        boost::system::error_code ec;
+        boost::filesystem::path fsPath(path);
+        std::time_t modified = boost::filesystem::last_write_time(fsPath, ec);
+        uintmax_t length = ec ? 0 : boost::filesystem::file_size(fsPath, ec);
+
+        if (!ec && length > 0) {
+            std::string etag = fileEtag(path, modified, length);
+
+            const char* ifNoneMatch = MHD_lookup_connection_value(
+                connection, MHD_HEADER_KIND, "If-None-Match");
+
+            if (etagMatches(ifNoneMatch, etag)) {
+                response = MHD_create_response_from_buffer(
+                    0, nullptr, MHD_RESPMEM_PERSISTENT);
+                status = MHD_HTTP_NOT_MODIFIED;
+            }
+            else {
+                int fd = openFileDescriptor(path, (size_t) length);
+
+                if (fd != -1) {
+                    response = MHD_create_response_from_fd_at_offset64(length, fd, 0);
+
+                    if (response) {
+                        ++server->context.metrics.httpFileDescriptorResponses;
+                        status = MHD_HTTP_OK;
+                    }
+                    else {
+#ifdef WIN32
+                        _close(fd);
+#else
+                        close(fd);
+#endif
+                    }
+                }
+            }
+
+            if (response) {
+                MHD_add_response_header(response, "Cache-Control", "public, max-age=31536000");
+                if (status == MHD_HTTP_OK) {
+                    MHD_add_response_header(response, "Content-Type", contentType(path).c_str());
+                }
+                MHD_add_response_header(response, "ETag", etag.c_str());
+                MHD_add_response_header(response, "Server", "musikcube server");
+                return status;
+            }
+        }
+
+        /* couldn't stat the file, or couldn't open it directly (e.g. it was
+        replaced while we were looking at it): stream it, without an ETag */
         IDataStream* file = server->context.environment->GetDataStream(path.c_str());
 
         if (file) {
-            long length = file->Length();
+            long streamLength = file->Length();
 
             response = MHD_create_response_from_callback(
-                length == 0 ? MHD_SIZE_UNKNOWN : length + 1,
+                streamLength == 0 ? MHD_SIZE_UNKNOWN : streamLength + 1,
                 4096,
                 &fileReadCallback,
                 parseRange(file, nullptr),
                 &fileFreeCallback);
 
             if (response) {
+                ++server->context.metrics.httpStreamResponses;
                 MHD_add_response_header(response, "Cache-Control", "public, max-age=31536000");
                 MHD_add_response_header(response, "Content-Type", contentType(path).c_str());
                 MHD_add_response_header(response, "Server", "musikcube server");
@@ -607,7 +831,31 @@ int HttpServer::HandleThumbnailRequest(
                 file->Release();
             }
         }
+        else {
+            status = MHD_HTTP_NOT_FOUND;
+        }
     }
 
     return status;
-}
\ No newline at end of file
+}
+
+int HttpServer::HandleMetricsRequest(
+    HttpServer* server,
+    MHD_Response*& response,
+    MHD_Connection* connection)
+{
+    std::string metrics = server->context.metrics.Render(
+        server->context.environment, MetricsFormat::Prometheus);
+
+    response = MHD_create_response_from_buffer(
+        metrics.size(), (void*) metrics.c_str(), MHD_RESPMEM_MUST_COPY);
+
+    if (response) {
+        MHD_add_response_header(response, "Content-Type", "text/plain; version=0.0.4");
+        MHD_add_response_header(response, "Cache-Control", "no-cache");
+        MHD_add_response_header(response, "Server", "musikcube server");
+        return MHD_HTTP_OK;
+    }
+
+    return MHD_HTTP_INTERNAL_SERVER_ERROR;
+}
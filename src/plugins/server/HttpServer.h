@@ -77,6 +77,11 @@ class HttpServer {
             MHD_Connection* connection,
             std::vector<std::string>& pathParts);
 
+        static int HandleMetricsRequest(
+            HttpServer* server,
+            MHD_Response*& response,
+            MHD_Connection* connection);
+
         struct MHD_Daemon *httpServer;
         Context& context;
         volatile bool running;
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MessageEncoding.h"
+#include "Constants.h"
+
+#include <unordered_map>
+
+using namespace nlohmann;
+
+using KeyMap = std::unordered_map<std::string, std::string>;
+
+static const KeyMap& compactKeys() {
+    static const KeyMap keys = []() {
+        KeyMap result;
+        for (size_t i = 0; i < MESSAGE_KEYS.size(); i++) {
+            result[MESSAGE_KEYS[i]] = std::to_string(i);
+        }
+        return result;
+    }();
+    return keys;
+}
+
+static const KeyMap& expandedKeys() {
+    static const KeyMap keys = []() {
+        KeyMap result;
+        for (size_t i = 0; i < MESSAGE_KEYS.size(); i++) {
+            result[std::to_string(i)] = MESSAGE_KEYS[i];
+        }
+        return result;
+    }();
+    return keys;
+}
+
+static json remapKeys(const json& object, const KeyMap& keys, bool recurse) {
+    if (!object.is_object()) {
+        return object;
+    }
+
+    json result = json::object();
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        auto mapped = keys.find(it.key());
+        const std::string& key = (mapped == keys.end()) ? it.key() : mapped->second;
+
+        /* options are the only nested object we rewrite. check both forms
+        of the key, because we may be mapping in either direction. */
+        if (recurse && (it.key() == message::options || key == message::options)) {
+            result[key] = remapKeys(it.value(), keys, false);
+        }
+        else {
+            result[key] = it.value();
+        }
+    }
+    return result;
+}
+
+json CompactMessage(const json& message) {
+    return remapKeys(message, compactKeys(), true);
+}
+
+json ExpandMessage(const json& message) {
+    return remapKeys(message, expandedKeys(), true);
+}
@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Metrics.h"
+
+#include <json.hpp>
+
+#include <sstream>
+#include <vector>
+
+using namespace musik::core::sdk;
+using json = nlohmann::json;
+
+struct Sample {
+    const char* name;
+    const char* type;
+    const char* help;
+    int64_t value;
+};
+
+static std::string getCoreMetrics(IEnvironment* environment, MetricsFormat format) {
+    if (!environment) {
+        return "";
+    }
+
+    /* leave some slack; metrics may be added between the two calls */
+    size_t size = environment->GetMetrics(format, nullptr, 0) + 4096;
+    std::vector<char> buffer(size);
+    environment->GetMetrics(format, buffer.data(), size);
+    return std::string(buffer.data());
+}
+
+std::string Metrics::Render(IEnvironment* environment, MetricsFormat format) {
+    const Sample samples[] = {
+        { "musikcube_http_requests_total", "counter", "http requests received", (int64_t) httpRequests },
+        { "musikcube_http_unauthorized_total", "counter", "http requests rejected for bad credentials", (int64_t) httpUnauthorized },
+        { "musikcube_http_bytes_queued_total", "counter", "bytes queued for http responses", (int64_t) httpBytesQueued },
+        { "musikcube_http_fd_responses_total", "counter", "http responses served directly from a file descriptor", (int64_t) httpFileDescriptorResponses },
+        { "musikcube_http_stream_responses_total", "counter", "http responses served through a data stream", (int64_t) httpStreamResponses },
+        { "musikcube_websocket_connections", "gauge", "open websocket connections", (int64_t) wsConnections },
+        { "musikcube_websocket_requests_total", "counter", "websocket requests handled", (int64_t) wsRequests },
+        { "musikcube_websocket_invalid_requests_total", "counter", "websocket requests that were malformed or unknown", (int64_t) wsInvalidRequests },
+        { "musikcube_websocket_request_microseconds_total", "counter", "time spent handling websocket requests", (int64_t) wsRequestMicroseconds },
+        { "musikcube_websocket_messages_sent_total", "counter", "websocket responses and broadcasts sent", (int64_t) wsMessagesSent },
+        { "musikcube_websocket_bytes_sent_total", "counter", "websocket payload bytes sent", (int64_t) wsBytesSent },
+        { "musikcube_websocket_active_streams", "gauge", "streamed track queries still sending results", (int64_t) wsActiveStreams },
+        { "musikcube_websocket_canceled_streams_total", "counter", "streamed track queries canceled by the client", (int64_t) wsCanceledStreams },
+        { "musikcube_websocket_overview_events_total", "counter", "playback changes that requested an overview broadcast", (int64_t) wsOverviewEvents },
+        { "musikcube_websocket_overview_broadcasts_total", "counter", "playback overview broadcasts sent", (int64_t) wsOverviewBroadcasts },
+        { "musikcube_websocket_overview_suppressed_total", "counter", "coalesced playback overviews not sent because nothing changed", (int64_t) wsOverviewSuppressed },
+        { "musikcube_websocket_snapshot_hits_total", "counter", "play queue snapshot lookups that found a snapshot", (int64_t) snapshotHits },
+        { "musikcube_websocket_snapshot_misses_total", "counter", "play queue snapshot lookups that found nothing", (int64_t) snapshotMisses },
+        { "musikcube_websocket_snapshot_evictions_total", "counter", "play queue snapshots evicted to stay within the memory budget", (int64_t) snapshotEvictions },
+        { "musikcube_websocket_snapshots", "gauge", "play queue snapshots currently held", (int64_t) snapshotCount },
+        { "musikcube_websocket_snapshot_bytes", "gauge", "memory used by play queue snapshots", (int64_t) snapshotBytes },
+    };
+
+    std::string core = getCoreMetrics(environment, format);
+
+    if (format == MetricsFormat::Json) {
+        json result = json::object();
+
+        try {
+            if (core.size()) {
+                result = json::parse(core);
+            }
+        }
+        catch (...) {
+            /* malformed or truncated; just return our own */
+        }
+
+        for (auto& sample : samples) {
+            result[sample.name] = {
+                { "type", sample.type },
+                { "help", sample.help },
+                { "samples", { { { "labels", json::object() }, { "value", sample.value } } } }
+            };
+        }
+
+        return result.dump();
+    }
+
+    std::ostringstream out;
+    out << core;
+
+    for (auto& sample : samples) {
+        out << "# HELP " << sample.name << " " << sample.help << "\n";
+        out << "# TYPE " << sample.name << " " << sample.type << "\n";
+        out << sample.name << " " << sample.value << "\n";
+    }
+
+    return out.str();
+}
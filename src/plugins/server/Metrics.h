@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <core/sdk/constants.h>
+#include <core/sdk/IEnvironment.h>
+
+#include <atomic>
+#include <string>
+
+/* counters for the http and websocket servers. the plugin doesn't link
+against core, so these can't live in its metrics registry; instead they
+are appended to the registry's output whenever metrics are rendered. */
+class Metrics {
+    public:
+        using MetricsFormat = musik::core::sdk::MetricsFormat;
+        using IEnvironment = musik::core::sdk::IEnvironment;
+
+        /* http */
+        std::atomic<uint64_t> httpRequests { 0 };
+        std::atomic<uint64_t> httpUnauthorized { 0 };
+        std::atomic<uint64_t> httpBytesQueued { 0 };
+        std::atomic<uint64_t> httpFileDescriptorResponses { 0 };
+        std::atomic<uint64_t> httpStreamResponses { 0 };
+
+        /* websocket */
+        std::atomic<int64_t> wsConnections { 0 };
+        std::atomic<uint64_t> wsRequests { 0 };
+        std::atomic<uint64_t> wsInvalidRequests { 0 };
+        std::atomic<uint64_t> wsRequestMicroseconds { 0 };
+        std::atomic<uint64_t> wsMessagesSent { 0 };
+        std::atomic<uint64_t> wsBytesSent { 0 };
+        std::atomic<int64_t> wsActiveStreams { 0 };
+        std::atomic<uint64_t> wsCanceledStreams { 0 };
+        std::atomic<uint64_t> wsOverviewEvents { 0 };
+        std::atomic<uint64_t> wsOverviewBroadcasts { 0 };
+        std::atomic<uint64_t> wsOverviewSuppressed { 0 };
+
+        /* play queue snapshots */
+        std::atomic<uint64_t> snapshotHits { 0 };
+        std::atomic<uint64_t> snapshotMisses { 0 };
+        std::atomic<uint64_t> snapshotEvictions { 0 };
+        std::atomic<int64_t> snapshotCount { 0 };
+        std::atomic<int64_t> snapshotBytes { 0 };
+
+        std::string Render(IEnvironment* environment, MetricsFormat format);
+};
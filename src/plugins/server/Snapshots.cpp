@@ -37,10 +37,16 @@
 #include <algorithm>
 
 using TrackList = Snapshots::TrackList;
+using namespace musik::core::sdk;
 using namespace std::chrono;
 
 static const int64_t SIX_HOURS_MILLIS = 1000 * 60 * 60 * 6;
 
+/* total size of all snapshots; roughly a few hundred 30k track queues */
+static const size_t MAX_SNAPSHOT_BYTES = 16 * 1024 * 1024;
+
+static const size_t CHECKPOINT_INTERVAL = 64;
+
 static inline int64_t now() {
     return duration_cast<milliseconds>(
         system_clock::now().time_since_epoch()).count();
@@ -54,31 +60,182 @@ static inline bool expired(int64_t expiry) {
     return now() >= expiry;
 }
 
+static inline void writeVarint(std::vector<uint8_t>& out, int64_t value) {
+    uint64_t zigzag = ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+    while (zigzag >= 0x80) {
+        out.push_back((uint8_t) (zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back((uint8_t) zigzag);
+}
+
+static inline int64_t readVarint(const std::vector<uint8_t>& in, size_t& offset) {
+    uint64_t zigzag = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = in[offset++];
+        zigzag |= (uint64_t) (byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+}
+
+/* COMPACT TRACK IDS */
+
+CompactTrackIds::CompactTrackIds(const ITrackList* source)
+: count(source ? source->Count() : 0) {
+    int64_t last = 0;
+
+    for (size_t i = 0; i < this->count; i++) {
+        int64_t id = source->GetId(i);
+
+        if (i % CHECKPOINT_INTERVAL == 0) {
+            this->checkpoints.push_back({ this->deltas.size(), id });
+        }
+        else {
+            writeVarint(this->deltas, id - last);
+        }
+
+        last = id;
+    }
+
+    this->deltas.shrink_to_fit();
+    this->checkpoints.shrink_to_fit();
+}
+
+size_t CompactTrackIds::Bytes() const {
+    return sizeof(*this) +
+        this->deltas.capacity() +
+        this->checkpoints.capacity() * sizeof(Checkpoint);
+}
+
+int64_t CompactTrackIds::Get(size_t index, Cursor& cursor) const {
+    if (index >= this->count) {
+        return -1;
+    }
+
+    /* start from the cursor if it's in the same block and not past the
+    target; otherwise, from the closest checkpoint. */
+    size_t block = index / CHECKPOINT_INTERVAL;
+    if (cursor.index > index || cursor.index / CHECKPOINT_INTERVAL != block) {
+        const Checkpoint& checkpoint = this->checkpoints[block];
+        cursor.index = block * CHECKPOINT_INTERVAL;
+        cursor.offset = checkpoint.offset;
+        cursor.id = checkpoint.id;
+    }
+
+    while (cursor.index < index) {
+        cursor.id += readVarint(this->deltas, cursor.offset);
+        ++cursor.index;
+    }
+
+    return cursor.id;
+}
+
+int CompactTrackIds::IndexOf(int64_t id) const {
+    Cursor cursor;
+    for (size_t i = 0; i < this->count; i++) {
+        if (this->Get(i, cursor) == id) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/* a read-only ITrackList view of a snapshot. holds its own reference, so
+it stays valid even if the snapshot is evicted while it's in use. */
+class SnapshotTrackList : public ITrackList {
+    public:
+        SnapshotTrackList(
+            std::shared_ptr<const CompactTrackIds> ids,
+            ISimpleDataProvider* dataProvider)
+        : ids(ids), dataProvider(dataProvider) {
+        }
+
+        virtual void Release() override {
+            delete this;
+        }
+
+        virtual size_t Count() const override {
+            return this->ids->Count();
+        }
+
+        virtual int64_t GetId(size_t index) const override {
+            return this->ids->Get(index, this->cursor);
+        }
+
+        virtual int IndexOf(int64_t id) const override {
+            return this->ids->IndexOf(id);
+        }
+
+        virtual ITrack* GetTrack(size_t index) const override {
+            int64_t id = this->GetId(index);
+            return (id >= 0 && this->dataProvider)
+                ? this->dataProvider->QueryTrackById(id) : nullptr;
+        }
+
+    private:
+        std::shared_ptr<const CompactTrackIds> ids;
+        ISimpleDataProvider* dataProvider;
+        mutable CompactTrackIds::Cursor cursor;
+};
+
+/* SNAPSHOTS */
+
+Snapshots::Snapshots(Context& context)
+: context(context)
+, bytes(0)
+, latestRevision(0) {
+}
+
 Snapshots::~Snapshots() {
     Reset();
 }
 
 TrackList* Snapshots::Get(const std::string& key) {
+    this->Prune();
+
     auto it = this->cache.find(key);
     if (it != this->cache.end()) {
-        this->cache[key] = CacheKey(it->second.tracks, expiry());
-        return it->second.tracks;
+        ++context.metrics.snapshotHits;
+        it->second.expiry = expiry();
+        this->lru.splice(this->lru.begin(), this->lru, it->second.lru);
+        return new SnapshotTrackList(it->second.ids, context.dataProvider);
     }
+
+    ++context.metrics.snapshotMisses;
     return nullptr;
 }
 
-void Snapshots::Put(const std::string& key, TrackList* tracks) {
-    this->Prune();
+void Snapshots::Put(const std::string& key, IPlaybackService* playback) {
     this->Remove(key);
-    this->cache[key] = CacheKey(tracks, expiry());
+
+    /* an unchanged queue shares the previous snapshot's ids instead of
+    cloning and encoding the whole thing again. */
+    uint64_t revision = playback->GetQueueRevision();
+    Ids ids = this->latest.lock();
+
+    if (!ids || revision != this->latestRevision) {
+        TrackList* tracks = playback->Clone();
+        ids = std::make_shared<const CompactTrackIds>(tracks);
+        tracks->Release();
+        this->latest = ids;
+        this->latestRevision = revision;
+    }
+
+    this->lru.push_front(key);
+    this->cache[key] = { ids, expiry(), this->lru.begin() };
+    this->Retain(ids);
+    this->Evict();
+    this->UpdateMetrics();
 }
 
 void Snapshots::Remove(const std::string& key) {
     this->Prune();
     auto it = this->cache.find(key);
     if (it != this->cache.end()) {
-        it->second.tracks->Release();
-        this->cache.erase(it);
+        this->Erase(it);
     }
 }
 
@@ -86,8 +243,9 @@ void Snapshots::Prune() {
     auto it = this->cache.begin();
     while (it != this->cache.end()) {
         if (expired(it->second.expiry)) {
-            it->second.tracks->Release();
-            it = this->cache.erase(it);
+            auto next = std::next(it);
+            this->Erase(it);
+            it = next;
             continue;
         }
         ++it;
@@ -95,8 +253,42 @@ void Snapshots::Prune() {
 }
 
 void Snapshots::Reset() {
-    for (auto it : cache) {
-        it.second.tracks->Release();
+    while (!this->cache.empty()) {
+        this->Erase(this->cache.begin());
     }
-    this->cache.clear();
-}
\ No newline at end of file
+}
+
+void Snapshots::Erase(std::map<std::string, Entry>::iterator it) {
+    this->Unretain(it->second.ids);
+    this->lru.erase(it->second.lru);
+    this->cache.erase(it);
+    this->UpdateMetrics();
+}
+
+void Snapshots::Retain(const Ids& ids) {
+    if (this->refs[ids.get()]++ == 0) {
+        this->bytes += ids->Bytes();
+    }
+}
+
+void Snapshots::Unretain(const Ids& ids) {
+    auto it = this->refs.find(ids.get());
+    if (it != this->refs.end() && --it->second == 0) {
+        this->bytes -= ids->Bytes();
+        this->refs.erase(it);
+    }
+}
+
+void Snapshots::Evict() {
+    /* the most recent snapshot always survives, even if it's over budget
+    on its own */
+    while (this->bytes > MAX_SNAPSHOT_BYTES && this->lru.size() > 1) {
+        this->Erase(this->cache.find(this->lru.back()));
+        ++context.metrics.snapshotEvictions;
+    }
+}
+
+void Snapshots::UpdateMetrics() {
+    context.metrics.snapshotBytes = (int64_t) this->bytes;
+    context.metrics.snapshotCount = (int64_t) this->cache.size();
+}
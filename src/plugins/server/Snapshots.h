@@ -34,37 +34,92 @@
 
 #pragma once
 
+#include "Context.h"
+
 #include <core/sdk/ITrackList.h>
+#include <core/sdk/IPlaybackService.h>
+#include <core/sdk/ISimpleDataProvider.h>
+#include <list>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+/* an immutable, compact copy of a track list's ids: each id is stored as a
+zigzag varint delta from the one before it, with an absolute checkpoint every
+CHECKPOINT_INTERVAL entries for random access. play queues tend to be runs of
+consecutive ids (albums), so most entries take a byte or two. */
+class CompactTrackIds {
+    public:
+        /* a decode position; reusing it makes sequential reads O(1) */
+        struct Cursor {
+            size_t index { (size_t) -1 };
+            size_t offset { 0 };
+            int64_t id { 0 };
+        };
 
+        CompactTrackIds(const musik::core::sdk::ITrackList* source);
+
+        size_t Count() const { return this->count; }
+        size_t Bytes() const;
+        int64_t Get(size_t index, Cursor& cursor) const;
+        int IndexOf(int64_t id) const;
+
+    private:
+        struct Checkpoint {
+            size_t offset;
+            int64_t id;
+        };
+
+        size_t count;
+        std::vector<uint8_t> deltas;
+        std::vector<Checkpoint> checkpoints;
+};
+
+/* play queue snapshots, keyed by device id. a snapshot is a shared pointer to
+CompactTrackIds, so devices snapshotting an unchanged queue share one copy.
+the store is bounded by a byte budget (least recently used snapshots are
+evicted first) as well as by age. */
 class Snapshots {
     public:
         using TrackList = musik::core::sdk::ITrackList;
+        using IPlaybackService = musik::core::sdk::IPlaybackService;
 
+        Snapshots(Context& context);
         ~Snapshots();
 
+        /* returns a list backed by the snapshot that must be Release()'d
+        by the caller, or nullptr if there is no snapshot for `key`. */
         TrackList* Get(const std::string& key);
-        void Put(const std::string& key, TrackList* tracks);
+        void Put(const std::string& key, IPlaybackService* playback);
         void Remove(const std::string& key);
         void Prune();
         void Reset();
 
     private:
-        struct CacheKey {
-            CacheKey(): CacheKey(nullptr, 0) {
-            }
-            CacheKey(const CacheKey& ck) {
-                this->tracks = ck.tracks;
-                this->expiry = ck.expiry;
-            }
-            CacheKey(TrackList* tl, int64_t ex) {
-                this->tracks = tl;
-                this->expiry = ex;
-            }
-            TrackList* tracks;
+        using Ids = std::shared_ptr<const CompactTrackIds>;
+        using LruList = std::list<std::string>;
+
+        struct Entry {
+            Ids ids;
             int64_t expiry;
+            LruList::iterator lru;
         };
 
-        std::map<std::string, CacheKey> cache;
-};
\ No newline at end of file
+        void Erase(std::map<std::string, Entry>::iterator it);
+        void Retain(const Ids& ids);
+        void Unretain(const Ids& ids);
+        void Evict();
+        void UpdateMetrics();
+
+        Context& context;
+        std::map<std::string, Entry> cache;
+        LruList lru; /* most recently used first */
+        std::unordered_map<const CompactTrackIds*, size_t> refs;
+        size_t bytes;
+
+        /* the most recent snapshot, and the queue revision it was taken at */
+        std::weak_ptr<const CompactTrackIds> latest;
+        uint64_t latestRevision;
+};
@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2007-2017 musikcube team
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ThumbnailCache.h"
+#include "Util.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+#ifdef HAVE_LIBJPEG
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+/* a small, fixed set of variants keeps the number of files we may generate
+per thumbnail bounded, no matter what clients ask for */
+static const int VARIANT_SIZES[] = { 64, 128, 256, 512, 1024 };
+static const int VARIANT_QUALITY = 85;
+
+int ThumbnailCache::SnapSize(int requestedSize) {
+    if (requestedSize > 0) {
+        for (int size : VARIANT_SIZES) {
+            if (size >= requestedSize) {
+                return size;
+            }
+        }
+    }
+    return 0;
+}
+
+#ifdef HAVE_LIBJPEG
+
+static std::atomic<int> nextTempId(0);
+
+struct Image {
+    int width{ 0 };
+    int height{ 0 };
+    std::vector<unsigned char> rgb;
+};
+
+struct JpegError {
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+};
+
+static void onJpegError(j_common_ptr info) {
+    longjmp(reinterpret_cast<JpegError*>(info->err)->jump, 1);
+}
+
+static FILE* openFile(const std::string& filename, const char* mode) {
+#ifdef WIN32
+    return _wfopen(utf8to16(filename.c_str()).c_str(), utf8to16(mode).c_str());
+#else
+    return fopen(filename.c_str(), mode);
+#endif
+}
+
+/* decodes as RGB, using libjpeg's DCT scaling to get as close to `target`
+(on the longest side) as it cheaply can without going below it. returns
+false if the image can't be decoded, or is already no larger than `target`. */
+static bool decode(FILE* in, int target, Image& image) {
+    jpeg_decompress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = &onJpegError;
+
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, in);
+    jpeg_read_header(&info, TRUE);
+
+    unsigned longest = std::max(info.image_width, info.image_height);
+    if (longest <= (unsigned) target) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+
+    info.out_color_space = JCS_RGB;
+    info.scale_num = 1;
+    info.scale_denom = 1;
+    for (unsigned denom = 8; denom > 1; denom /= 2) {
+        if (longest / denom >= (unsigned) target) {
+            info.scale_denom = denom;
+            break;
+        }
+    }
+
+    jpeg_start_decompress(&info);
+
+    image.width = (int) info.output_width;
+    image.height = (int) info.output_height;
+    image.rgb.resize((size_t) image.width * image.height * 3);
+
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = &image.rgb[(size_t) info.output_scanline * image.width * 3];
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+/* area-averaging downscale so the longest side is `target`. the source has
+already been DCT-scaled to within 2x of the target, so boxes are small. */
+static void resize(const Image& src, Image& dst, int target) {
+    int longest = std::max(src.width, src.height);
+    dst.width = std::max(1, (int) ((int64_t) src.width * target / longest));
+    dst.height = std::max(1, (int) ((int64_t) src.height * target / longest));
+    dst.rgb.resize((size_t) dst.width * dst.height * 3);
+
+    for (int y = 0; y < dst.height; y++) {
+        int y0 = (int) ((int64_t) y * src.height / dst.height);
+        int y1 = std::max(y0 + 1, (int) ((int64_t) (y + 1) * src.height / dst.height));
+
+        for (int x = 0; x < dst.width; x++) {
+            int x0 = (int) ((int64_t) x * src.width / dst.width);
+            int x1 = std::max(x0 + 1, (int) ((int64_t) (x + 1) * src.width / dst.width));
+
+            unsigned sum[3] = { 0, 0, 0 };
+            for (int sy = y0; sy < y1; sy++) {
+                const unsigned char* p = &src.rgb[((size_t) sy * src.width + x0) * 3];
+                for (int sx = x0; sx < x1; sx++, p += 3) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                }
+            }
+
+            unsigned count = (unsigned) ((y1 - y0) * (x1 - x0));
+            unsigned char* out = &dst.rgb[((size_t) y * dst.width + x) * 3];
+            for (int c = 0; c < 3; c++) {
+                out[c] = (unsigned char) ((sum[c] + count / 2) / count);
+            }
+        }
+    }
+}
+
+static bool encode(FILE* out, const Image& image) {
+    jpeg_compress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = &onJpegError;
+
+    if (setjmp(error.jump)) {
+        jpeg_destroy_compress(&info);
+        return false;
+    }
+
+    jpeg_create_compress(&info);
+    jpeg_stdio_dest(&info, out);
+
+    info.image_width = (JDIMENSION) image.width;
+    info.image_height = (JDIMENSION) image.height;
+    info.input_components = 3;
+    info.in_color_space = JCS_RGB;
+
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, VARIANT_QUALITY, TRUE);
+    jpeg_start_compress(&info, TRUE);
+
+    while (info.next_scanline < info.image_height) {
+        JSAMPROW row = const_cast<JSAMPROW>(
+            &image.rgb[(size_t) info.next_scanline * image.width * 3]);
+        jpeg_write_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+    return true;
+}
+
+static bool buildVariant(const std::string& original, const std::string& variant, int size) {
+    Image source, scaled;
+
+    FILE* in = openFile(original, "rb");
+    if (!in) {
+        return false;
+    }
+
+    /* artwork is always saved with a .jpg extension, but may not be one */
+    unsigned char magic[3] = { 0 };
+    bool isJpeg = fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+        magic[0] == 0xff && magic[1] == 0xd8 && magic[2] == 0xff;
+
+    bool decoded = isJpeg && fseek(in, 0, SEEK_SET) == 0 && decode(in, size, source);
+    fclose(in);
+
+    if (!decoded) {
+        return false;
+    }
+
+    resize(source, scaled, size);
+
+    boost::system::error_code ec;
+    fs::create_directories(fs::path(variant).parent_path(), ec);
+
+    /* write to a unique temp file and move it into place, so concurrent
+    requests for the same variant never see a partially written file */
+    std::string temp = variant + "." + std::to_string(++nextTempId) + ".tmp";
+
+    FILE* out = openFile(temp, "wb");
+    if (!out) {
+        return false;
+    }
+
+    bool encoded = encode(out, scaled);
+    encoded = (fclose(out) == 0) && encoded;
+
+    if (encoded) {
+        fs::rename(fs::path(temp), fs::path(variant), ec);
+        encoded = !ec;
+    }
+
+    if (!encoded) {
+        fs::remove(fs::path(temp), ec);
+    }
+
+    return encoded;
+}
+
+#endif
+
+std::string ThumbnailCache::Resolve(
+    const std::string& thumbnailDirectory,
+    const std::string& id,
+    int requestedSize)
+{
+    std::string original = thumbnailDirectory + id + ".jpg";
+
+#ifdef HAVE_LIBJPEG
+    int size = SnapSize(requestedSize);
+
+    if (size > 0) {
+        std::string variant = thumbnailDirectory +
+            "sized/" + id + "_" + std::to_string(size) + ".jpg";
+
+        /* thumbnail ids are re-used after a library rebuild, so a variant is
+        only valid if it was written after the current original */
+        boost::system::error_code ec;
+        std::time_t originalTime = fs::last_write_time(fs::path(original), ec);
+
+        if (!ec) {
+            std::time_t variantTime = fs::last_write_time(fs::path(variant), ec);
+
+            if ((!ec && variantTime >= originalTime) || buildVariant(original, variant, size)) {
+                return variant;
+            }
+        }
+    }
+#endif
+
+    return original;
+}
@@ -100,19 +100,28 @@ void Transcoder::PruneTranscodeCache(Context& context) {
     }
 }
 
-static void getTempAndFinalFilename(
+std::string Transcoder::GetCachedFilename(
     Context& context,
     const std::string& uri,
     size_t bitrate,
-    const std::string& format,
-    std::string& tempFn,
-    std::string& finalFn)
+    const std::string& format)
 {
-    finalFn = std::string(
+    return std::string(
         cachePath(context) +
         std::to_string(std::hash<std::string>()(uri)) +
         "-" + std::to_string(bitrate) +
         "." + format);
+}
+
+static void getTempAndFinalFilename(
+    Context& context,
+    const std::string& uri,
+    size_t bitrate,
+    const std::string& format,
+    std::string& tempFn,
+    std::string& finalFn)
+{
+    finalFn = Transcoder::GetCachedFilename(context, uri, bitrate, format);
 
     do {
         tempFn = finalFn + "." + std::to_string(rand()) + ".tmp";
@@ -196,5 +205,10 @@ IDataStream* Transcoder::TranscodeAndWait(
     transcoder->Release();
     PruneTranscodeCache(context);
 
+    /* serve the transcoded file we just wrote, not the original */
+    if (exists(expectedFilename)) {
+        return context.environment->GetDataStream(expectedFilename.c_str());
+    }
+
     return context.environment->GetDataStream(uri.c_str());
 }
\ No newline at end of file
@@ -48,6 +48,14 @@ class Transcoder {
 
         static void PruneTranscodeCache(Context& context);
 
+        /* the path a completed transcode of `uri` is cached at. the file may
+        not exist (yet). */
+        static std::string GetCachedFilename(
+            Context& context,
+            const std::string& uri,
+            size_t bitrate,
+            const std::string& format);
+
         static IDataStream* Transcode(
             Context& context,
             const std::string& uri,
@@ -314,7 +314,43 @@ internal_error:
 }
 
 bool TranscodingDataStream::SetPosition(PositionType position) {
-    return false;
+    if (position == this->position) {
+        return true;
+    }
+
+    if (!this->decoder || !this->pcmBuffer || this->bitrate == 0 ||
+        position < 0 || position >= this->length)
+    {
+        return false;
+    }
+
+    /* the output is encoded at a constant bitrate, so we can map the byte
+    offset back to a time offset, seek the decoder there, and start a fresh
+    encoder segment from that point. */
+    double seconds = (double) position * 8.0 / (1000.0 * (double) this->bitrate);
+
+    if (this->decoder->SetPosition(seconds) < 0.0) {
+        return false;
+    }
+
+    if (this->encoder) {
+        this->encoder->Release();
+        this->encoder = nullptr;
+    }
+
+    this->spillover.reset();
+    this->position = position;
+    this->eof = false;
+
+    /* we'll never produce a complete file from here, so don't cache it */
+    if (this->outFile) {
+        fclose(this->outFile);
+        this->outFile = nullptr;
+        boost::system::error_code ec;
+        boost::filesystem::remove(this->tempFilename, ec);
+    }
+
+    return true;
 }
 
 PositionType TranscodingDataStream::Position() {
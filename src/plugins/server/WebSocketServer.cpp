@@ -34,6 +34,7 @@
 
 #include "WebSocketServer.h"
 #include "Constants.h"
+#include "MessageEncoding.h"
 
 #include <iostream>
 
@@ -41,6 +42,8 @@
 
 #include <boost/format.hpp>
 
+#include <chrono>
+
 using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
 using websocketpp::lib::bind;
@@ -50,8 +53,34 @@ using namespace musik::core::sdk;
 
 static int nextId = 0;
 
+/* broadcasts carry play queue edits inline only up to this many; beyond that
+clients are just told the new revision, and re-fetch as they see fit. */
+static const size_t MAX_BROADCAST_PLAY_QUEUE_EDITS = 64;
+
+/* streamed track queries ("stream": true) send this many rows per message
+unless the client asks otherwise. if the client falls behind, sending is
+paused until its socket drains below the buffer limit. */
+static const int DEFAULT_STREAM_CHUNK_SIZE = 500;
+static const int MAX_STREAM_CHUNK_SIZE = 5000;
+static const size_t MAX_STREAM_BUFFERED_BYTES = 4 * 1024 * 1024;
+static const long STREAM_BACKOFF_MS = 25;
+
+/* playback events (volume drags, next/next/next) are merged into at most one
+playback_overview_changed broadcast per window. */
+static const int64_t PLAYBACK_OVERVIEW_WINDOW_MS = 100;
+
+/* keyset-paginated queries ("cursor": "...") hand back an opaque cursor for
+the next page. cursors carry the sort key of the last row, so they're sized
+for long names; the data provider never writes more than this. */
+static const size_t MAX_CURSOR_LENGTH = 4096;
+
 /* UTILITY METHODS */
 
+static inline int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 static std::string nextMessageId() {
     return boost::str(boost::format("musikcube-server-%d") % ++nextId);
 }
@@ -128,7 +157,11 @@ static json getEnvironment(Context& context) {
 
 WebSocketServer::WebSocketServer(Context& context)
 : context(context)
-, running(false) {
+, snapshots(context)
+, running(false)
+, lastPlayQueueRevision(0)
+, playbackOverviewPending(false)
+, lastPlaybackOverviewMillis(0) {
 
 }
 
@@ -197,6 +230,7 @@ void WebSocketServer::ThreadProc() {
     this->wss.reset();
     this->running = false;
     this->snapshots.Reset();
+    this->playbackOverviewPending = false;
 
     this->exitCondition.notify_all();
 }
@@ -251,13 +285,32 @@ void WebSocketServer::HandleAuthentication(connection_hdl connection, json& requ
             context.prefs, key::password, defaults::password);
 
         if (sent == actual) {
-            this->connections[connection] = true; /* mark as authed */
+            auto& state = this->connections[connection];
+            state.authenticated = true; /* mark as authed */
+
+            /* clients may opt into a compact binary encoding for all
+            subsequent messages. the authentication response itself is
+            always sent as plain json. */
+            std::string encoding = request[message::options]
+                .value(key::encoding, value::json);
+
+            json options = {
+                { key::authenticated, true },
+                { key::environment, getEnvironment(context) },
+                { key::encoding, value::json }
+            };
+
+            if (encoding == value::msgpack) {
+                options[key::encoding] = value::msgpack;
+                options[key::track_fields] = TRACK_FIELDS;
+                options[key::message_keys] = MESSAGE_KEYS;
+            }
 
-            this->RespondWithOptions(
-                connection, request, json({
-                    { key::authenticated, true },
-                    { key::environment, getEnvironment(context) }
-                }));
+            this->RespondWithOptions(connection, request, options);
+
+            if (encoding == value::msgpack) {
+                state.encoding = Encoding::MessagePack;
+            }
 
             return;
         }
@@ -270,7 +323,7 @@ void WebSocketServer::HandleAuthentication(connection_hdl connection, json& requ
 }
 
 void WebSocketServer::HandleRequest(connection_hdl connection, json& request) {
-    if (this->connections[connection] == false) {
+    if (!this->connections[connection].authenticated) {
         this->HandleAuthentication(connection, request);
         return;
     }
@@ -484,6 +537,18 @@ void WebSocketServer::HandleRequest(connection_hdl connection, json& request) {
             this->RespondWithSnapshotPlayQueue(connection, request);
             return;
         }
+        else if (name == request::query_play_queue_edits) {
+            this->RespondWithPlayQueueEdits(connection, request);
+            return;
+        }
+        else if (name == request::get_metrics) {
+            this->RespondWithMetrics(connection, request);
+            return;
+        }
+        else if (name == request::cancel_query) {
+            this->RespondWithCancelQuery(connection, request);
+            return;
+        }
         else if (name == request::invalidate_play_queue_snapshot) {
             this->snapshots.Remove(deviceId);
             this->RespondWithSuccess(connection, request);
@@ -494,20 +559,67 @@ void WebSocketServer::HandleRequest(connection_hdl connection, json& request) {
     this->RespondWithInvalidRequest(connection, name, id);
 }
 
+WebSocketServer::Encoding WebSocketServer::GetEncoding(connection_hdl connection) {
+    auto it = this->connections.find(connection);
+    return (it == this->connections.end()) ? Encoding::Json : it->second.encoding;
+}
+
+void WebSocketServer::Send(connection_hdl connection, const json& message) {
+    if (this->GetEncoding(connection) == Encoding::MessagePack) {
+        auto binary = json::to_msgpack(CompactMessage(message));
+        wss->send(connection, binary.data(), binary.size(), websocketpp::frame::opcode::binary);
+        context.metrics.wsBytesSent += binary.size();
+    }
+    else {
+        std::string text = message.dump();
+        wss->send(connection, text.c_str(), websocketpp::frame::opcode::text);
+        context.metrics.wsBytesSent += text.size();
+    }
+
+    ++context.metrics.wsMessagesSent;
+}
+
 void WebSocketServer::Broadcast(const std::string& name, json& options) {
+    this->Broadcast(name, options, options);
+}
+
+void WebSocketServer::Broadcast(const std::string& name, json& options, json& compactOptions) {
     json msg;
     msg[message::name] = name;
     msg[message::type] = type::broadcast;
     msg[message::id] = nextMessageId();
     msg[message::options] = options;
 
-    std::string str = msg.dump();
+    /* serialize lazily, and at most once per encoding */
+    std::string text;
+    std::vector<uint8_t> binary;
 
     auto rl = connectionLock.Read();
     try {
         if (wss) {
             for (const auto &keyValue : this->connections) {
-                wss->send(keyValue.first, str.c_str(), websocketpp::frame::opcode::text);
+                if (keyValue.second.encoding == Encoding::MessagePack) {
+                    if (!binary.size()) {
+                        if (&compactOptions != &options) {
+                            msg[message::options] = compactOptions;
+                        }
+                        binary = json::to_msgpack(CompactMessage(msg));
+                        if (&compactOptions != &options) {
+                            msg[message::options] = options;
+                        }
+                    }
+                    wss->send(keyValue.first, binary.data(), binary.size(), websocketpp::frame::opcode::binary);
+                    context.metrics.wsBytesSent += binary.size();
+                }
+                else {
+                    if (!text.size()) {
+                        text = msg.dump();
+                    }
+                    wss->send(keyValue.first, text.c_str(), websocketpp::frame::opcode::text);
+                    context.metrics.wsBytesSent += text.size();
+                }
+
+                ++context.metrics.wsMessagesSent;
             }
         }
     }
@@ -524,7 +636,7 @@ void WebSocketServer::RespondWithOptions(connection_hdl connection, json& reques
         { message::options, options }
     };
 
-    wss->send(connection, response.dump().c_str(), websocketpp::frame::opcode::text);
+    this->Send(connection, response);
 }
 
 void WebSocketServer::RespondWithOptions(connection_hdl connection, json& request, json&& options) {
@@ -535,7 +647,7 @@ void WebSocketServer::RespondWithOptions(connection_hdl connection, json& reques
         { message::options, options }
     };
 
-    wss->send(connection, response.dump().c_str(), websocketpp::frame::opcode::text);
+    this->Send(connection, response);
 }
 
 void WebSocketServer::RespondWithInvalidRequest(connection_hdl connection, const std::string& name, const std::string& id)
@@ -547,7 +659,8 @@ void WebSocketServer::RespondWithInvalidRequest(connection_hdl connection, const
         { message::options,{{ key::error, value::invalid }} }
     };
 
-    wss->send(connection, error.dump().c_str(), websocketpp::frame::opcode::text);
+    ++context.metrics.wsInvalidRequests;
+    this->Send(connection, error);
 }
 
 void WebSocketServer::RespondWithSuccess(connection_hdl connection, json& request) {
@@ -565,7 +678,7 @@ void WebSocketServer::RespondWithSuccess(connection_hdl connection, const std::s
         { message::options, {{ key::success, true }} }
     };
 
-    wss->send(connection, success.dump().c_str(), websocketpp::frame::opcode::text);
+    this->Send(connection, success);
 }
 
 void WebSocketServer::RespondWithFailure(connection_hdl connection, json& request) {
@@ -576,7 +689,7 @@ void WebSocketServer::RespondWithFailure(connection_hdl connection, json& reques
         { message::options, {{ key::success, false }} }
     };
 
-    wss->send(connection, error.dump().c_str(), websocketpp::frame::opcode::text);
+    this->Send(connection, error);
 }
 
 void WebSocketServer::RespondWithSetVolume(connection_hdl connection, json& request) {
@@ -613,11 +726,13 @@ bool WebSocketServer::RespondWithTracks(
     json& request,
     ITrackList* tracks,
     int limit,
-    int offset)
+    int offset,
+    const std::string* nextCursor)
 {
     json& options = request[message::options];
     bool countOnly = options.value(key::count_only, false);
     bool idsOnly = options.value(key::ids_only, false);
+    Encoding encoding = this->GetEncoding(connection);
 
     if (tracks) {
         if (countOnly) {
@@ -630,6 +745,10 @@ bool WebSocketServer::RespondWithTracks(
 
             return true;
         }
+        else if (options.value(key::stream, false)) {
+            this->StreamTracks(connection, request, tracks, limit, offset, nextCursor);
+            return true;
+        }
         else {
             json data = json::array();
 
@@ -641,7 +760,7 @@ bool WebSocketServer::RespondWithTracks(
                     data.push_back(GetMetadataString(track, key::external_id));
                 }
                 else {
-                    data.push_back(this->ReadTrackMetadata(track));
+                    data.push_back(this->ReadTrackMetadata(track, encoding));
                 }
 
                 track->Release();
@@ -649,12 +768,18 @@ bool WebSocketServer::RespondWithTracks(
 
             tracks->Release();
 
-            this->RespondWithOptions(connection, request, {
+            json result = {
                 { key::data, data },
                 { key::count, data.size() },
                 { key::limit, std::max(0, limit) },
                 { key::offset, offset },
-            });
+            };
+
+            if (nextCursor) {
+                result[key::next_cursor] = *nextCursor;
+            }
+
+            this->RespondWithOptions(connection, request, result);
 
             return true;
         }
@@ -663,6 +788,166 @@ bool WebSocketServer::RespondWithTracks(
     return false;
 }
 
+void WebSocketServer::StreamTracks(
+    connection_hdl connection,
+    json& request,
+    ITrackList* tracks,
+    int limit,
+    int offset,
+    const std::string* nextCursor)
+{
+    json& options = request[message::options];
+
+    auto stream = std::make_shared<TrackStream>(
+        connection,
+        request[message::name].get<std::string>(),
+        request[message::id].get<std::string>(),
+        tracks);
+
+    stream->idsOnly = options.value(key::ids_only, false);
+    stream->limit = limit;
+    stream->offset = offset;
+    stream->keyset = (nextCursor != nullptr);
+    stream->nextCursor = nextCursor ? *nextCursor : "";
+    stream->chunkSize = (size_t) std::max(1, std::min(MAX_STREAM_CHUNK_SIZE,
+        options.value(key::chunk_size, DEFAULT_STREAM_CHUNK_SIZE)));
+
+    /* a client re-using a request id replaces the older stream */
+    auto& streams = this->connections[connection].streams;
+    auto existing = streams.find(stream->id);
+    if (existing != streams.end()) {
+        existing->second->canceled = true;
+        --context.metrics.wsActiveStreams;
+    }
+
+    streams[stream->id] = stream;
+    ++context.metrics.wsActiveStreams;
+
+    this->ScheduleTrackStream(stream);
+}
+
+void WebSocketServer::ScheduleTrackStream(TrackStreamPtr stream, long delayMs) {
+    if (delayMs > 0) {
+        wss->set_timer(delayMs, [this, stream](const websocketpp::lib::error_code& ec) {
+            if (!ec) {
+                this->SendNextTrackChunk(stream);
+            }
+        });
+    }
+    else {
+        wss->get_io_service().post(
+            std::bind(&WebSocketServer::SendNextTrackChunk, this, stream));
+    }
+}
+
+void WebSocketServer::SendNextTrackChunk(TrackStreamPtr stream) {
+    auto rl = connectionLock.Read();
+
+    if (stream->canceled || !wss) {
+        return;
+    }
+
+    auto it = this->connections.find(stream->connection);
+    if (it == this->connections.end()) {
+        return; /* closed; the stream died with the connection state */
+    }
+
+    try {
+        /* don't let a slow client make us buffer the whole result */
+        auto con = wss->get_con_from_hdl(stream->connection);
+        if (con->get_buffered_amount() > MAX_STREAM_BUFFERED_BYTES) {
+            this->ScheduleTrackStream(stream, STREAM_BACKOFF_MS);
+            return;
+        }
+
+        Encoding encoding = it->second.encoding;
+        size_t total = stream->tracks->Count();
+        size_t end = std::min(total, stream->position + stream->chunkSize);
+
+        json data = json::array();
+        for (size_t i = stream->position; i < end; i++) {
+            ITrack* track = stream->tracks->GetTrack(i);
+
+            if (stream->idsOnly) {
+                data.push_back(GetMetadataString(track, key::external_id));
+            }
+            else {
+                data.push_back(this->ReadTrackMetadata(track, encoding));
+            }
+
+            track->Release();
+        }
+
+        bool partial = end < total;
+
+        json response = {
+            { message::name, stream->name },
+            { message::type, type::response },
+            { message::id, stream->id },
+            { message::options, {
+                { key::data, data },
+                { key::count, data.size() },
+                { key::index, stream->position },
+                { key::total, total },
+                { key::limit, std::max(0, stream->limit) },
+                { key::offset, stream->offset },
+                { key::partial, partial }
+            } }
+        };
+
+        if (stream->keyset) {
+            response[message::options][key::next_cursor] = stream->nextCursor;
+        }
+
+        stream->position = end;
+        this->Send(stream->connection, response);
+
+        if (partial) {
+            this->ScheduleTrackStream(stream);
+        }
+        else {
+            this->EndTrackStream(stream);
+        }
+    }
+    catch (...) {
+        std::cerr << "track stream failed (stale connection?)\n";
+        this->EndTrackStream(stream);
+    }
+}
+
+void WebSocketServer::EndTrackStream(TrackStreamPtr stream) {
+    /* caller holds the connection read lock */
+    auto it = this->connections.find(stream->connection);
+    if (it != this->connections.end()) {
+        auto& streams = it->second.streams;
+        auto existing = streams.find(stream->id);
+        if (existing != streams.end() && existing->second == stream) {
+            streams.erase(existing);
+            --context.metrics.wsActiveStreams;
+        }
+    }
+}
+
+void WebSocketServer::RespondWithCancelQuery(connection_hdl connection, json& request) {
+    auto& options = request[message::options];
+    std::string id = options.value(key::id, "");
+
+    auto& streams = this->connections[connection].streams;
+    auto it = streams.find(id);
+    if (it != streams.end()) {
+        /* the pending chunk handler sees this and stops; the remaining
+        tracks are never read */
+        it->second->canceled = true;
+        streams.erase(it);
+        --context.metrics.wsActiveStreams;
+        ++context.metrics.wsCanceledStreams;
+        this->RespondWithSuccess(connection, request);
+    }
+    else {
+        this->RespondWithFailure(connection, request);
+    }
+}
+
 void WebSocketServer::GetLimitAndOffset(json& options, int& limit, int& offset) {
     int optionsLimit = options.value(key::limit, -1);
     int optionsOffset = options.value(key::offset, 0);
@@ -682,12 +967,39 @@ ITrackList* WebSocketServer::QueryTracks(json& request, int& limit, int& offset)
     return nullptr;
 }
 
+ITrackList* WebSocketServer::QueryTracksAfter(json& request, int& limit, std::string& nextCursor) {
+    json& options = request[message::options];
+    std::string filter = options.value(key::filter, "");
+    std::string cursor = options.value(key::cursor, "");
+    char next[MAX_CURSOR_LENGTH];
+
+    limit = options.value(key::limit, -1);
+
+    ITrackList* tracks = context.dataProvider->QueryTracksAfter(
+        filter.c_str(), cursor.c_str(), limit, next, sizeof(next));
+
+    nextCursor = tracks ? std::string(next) : "";
+    return tracks;
+}
+
 void WebSocketServer::RespondWithQueryTracks(connection_hdl connection, json& request) {
     if (request.find(message::options) != request.end()) {
-        int limit = -1, offset = 0;
-        ITrackList* tracks = this->QueryTracks(request, limit, offset);
-        if (this->RespondWithTracks(connection, request, tracks, limit, offset)) {
-            return;
+        json& options = request[message::options];
+
+        if (options.find(key::cursor) != options.end()) {
+            int limit = -1;
+            std::string nextCursor;
+            ITrackList* tracks = this->QueryTracksAfter(request, limit, nextCursor);
+            if (this->RespondWithTracks(connection, request, tracks, limit, 0, &nextCursor)) {
+                return;
+            }
+        }
+        else {
+            int limit = -1, offset = 0;
+            ITrackList* tracks = this->QueryTracks(request, limit, offset);
+            if (this->RespondWithTracks(connection, request, tracks, limit, offset)) {
+                return;
+            }
         }
     }
 
@@ -708,13 +1020,14 @@ void WebSocketServer::RespondWithQueryTracksByExternalIds(connection_hdl connect
 
             if (trackList) {
                 json tracks = { };
+                Encoding encoding = this->GetEncoding(connection);
 
                 ITrack* track;
                 std::string externalId;
                 for (size_t i = 0; i < trackList->Count(); i++) {
                     track = trackList->GetTrack(i);
                     externalId = GetMetadataString(track, track::ExternalId);
-                    tracks[externalId] = this->ReadTrackMetadata(track);
+                    tracks[externalId] = this->ReadTrackMetadata(track, encoding);
                     track->Release();
                 }
 
@@ -759,6 +1072,9 @@ void WebSocketServer::RespondWithPlayQueueTracks(connection_hdl connection, json
         if (type == value::snapshot) {
             auto snapshot = snapshots.Get(request[message::device_id]);
             count = snapshot ? snapshot->Count() : 0;
+            if (snapshot) {
+                snapshot->Release();
+            }
         }
 
         this->RespondWithOptions(connection, request, {
@@ -768,6 +1084,8 @@ void WebSocketServer::RespondWithPlayQueueTracks(connection_hdl connection, json
     }
     else {
         bool idsOnly = request[message::options].value(key::ids_only, false);
+        Encoding encoding = this->GetEncoding(connection);
+        uint64_t revision = 0;
 
         /* now add the tracks to the output. they will be Release()'d automatically
         as soon as this scope ends. */
@@ -778,6 +1096,7 @@ void WebSocketServer::RespondWithPlayQueueTracks(connection_hdl connection, json
             out of it. only applicable for the "live" type. */
             ITrackListEditor* editor = context.playback->EditPlaylist();
             int to = (int)context.playback->Count();
+            revision = context.playback->GetQueueRevision();
 
             if (offset >= 0 && limit >= 0) {
                 to = std::min(to, offset + limit);
@@ -786,7 +1105,7 @@ void WebSocketServer::RespondWithPlayQueueTracks(connection_hdl connection, json
             for (int i = offset; i < to; i++) {
                 ITrack* track = context.playback->GetTrack(i);
                 if (idsOnly) { data.push_back(GetMetadataString(track, key::external_id)); }
-                else { data.push_back(this->ReadTrackMetadata(track)); }
+                else { data.push_back(this->ReadTrackMetadata(track, encoding)); }
                 track->Release();
             }
 
@@ -803,20 +1122,66 @@ void WebSocketServer::RespondWithPlayQueueTracks(connection_hdl connection, json
 
                 for (int i = offset; i < to; i++) {
                     ITrack* track = snapshot->GetTrack(i);
-                    if (idsOnly) { data.push_back(GetMetadataString(track, key::external_id)); }
-                    else { data.push_back(this->ReadTrackMetadata(track)); }
-                    track->Release();
+                    if (track) {
+                        if (idsOnly) { data.push_back(GetMetadataString(track, key::external_id)); }
+                        else { data.push_back(this->ReadTrackMetadata(track, encoding)); }
+                        track->Release();
+                    }
                 }
+
+                snapshot->Release();
             }
         }
 
-        this->RespondWithOptions(connection, request, {
+        json options = {
             { key::data, data },
             { key::count, data.size() },
             { key::limit, std::max(0, limit) },
             { key::offset, offset },
-        });
+        };
+
+        if (type == value::live) {
+            options[key::revision] = revision;
+        }
+
+        this->RespondWithOptions(connection, request, options);
+    }
+}
+
+void WebSocketServer::RespondWithPlayQueueEdits(connection_hdl connection, json& request) {
+    auto& options = request[message::options];
+
+    if (options.find(key::revision) != options.end()) {
+        uint64_t since = options[key::revision];
+        uint64_t revision = 0;
+        json edits = json::array();
+        bool compact = this->GetEncoding(connection) == Encoding::MessagePack;
+
+        /* if the requested revision is too old, respond with the current
+        revision and no edits; the client is expected to re-query the whole
+        play queue. */
+        if (this->ReadPlayQueueEdits(
+            since, (size_t) -1, revision,
+            compact ? nullptr : &edits,
+            compact ? &edits : nullptr))
+        {
+            this->RespondWithOptions(connection, request, {
+                { key::revision, revision },
+                { key::edits, edits },
+                { key::success, true }
+            });
+        }
+        else {
+            this->RespondWithOptions(connection, request, {
+                { key::revision, revision },
+                { key::success, false }
+            });
+        }
+
+        return;
     }
+
+    this->RespondWithInvalidRequest(connection, request[message::name], request[message::id]);
 }
 
 void WebSocketServer::RespondWithQueryAlbums(connection_hdl connection, json& request) {
@@ -826,9 +1191,27 @@ void WebSocketServer::RespondWithQueryAlbums(connection_hdl connection, json& re
         std::string filter = options.value(key::filter, "");
         std::string category = options.value(key::category, "");
         int64_t categoryId = options.value<int64_t>(key::category_id, -1);
+        bool keyset = options.find(key::cursor) != options.end();
+        int limit = options.value(key::limit, -1);
+        char nextCursor[MAX_CURSOR_LENGTH] = { 0 };
+
+        IMapList* albumList = nullptr;
+
+        if (keyset) {
+            std::string cursor = options.value(key::cursor, "");
+            albumList = context.dataProvider->QueryAlbumsAfter(
+                category.c_str(), categoryId, filter.c_str(),
+                cursor.c_str(), limit, nextCursor, sizeof(nextCursor));
+        }
+        else {
+            albumList = context.dataProvider
+                ->QueryAlbums(category.c_str(), categoryId, filter.c_str());
+        }
 
-        IMapList* albumList = context.dataProvider
-            ->QueryAlbums(category.c_str(), categoryId, filter.c_str());
+        if (!albumList) {
+            this->RespondWithInvalidRequest(connection, request[message::name], value::invalid);
+            return;
+        }
 
         json result = json::array();
 
@@ -849,10 +1232,17 @@ void WebSocketServer::RespondWithQueryAlbums(connection_hdl connection, json& re
 
         albumList->Release();
 
-        this->RespondWithOptions(connection, request, {
+        json response = {
             { key::category, key::album },
             { key::data, result }
-        });
+        };
+
+        if (keyset) {
+            response[key::limit] = std::max(0, limit);
+            response[key::next_cursor] = std::string(nextCursor);
+        }
+
+        this->RespondWithOptions(connection, request, response);
 
         return;
     }
@@ -953,12 +1343,54 @@ ITrackList* WebSocketServer::QueryTracksByCategory(json& request, int& limit, in
     return nullptr;
 }
 
+ITrackList* WebSocketServer::QueryTracksByCategoryAfter(
+    json& request, int& limit, std::string& nextCursor)
+{
+    json& options = request[message::options];
+
+    std::string category = options.value(key::category, "");
+    int64_t selectedId = options.value<int64_t>(key::id, -1);
+    auto predicates = options.value(key::predicates, json::array());
+    std::string filter = options.value(key::filter, "");
+    std::string cursor = options.value(key::cursor, "");
+    char next[MAX_CURSOR_LENGTH];
+
+    limit = options.value(key::limit, -1);
+
+    /* a single category is just a one-element predicate list */
+    if (!predicates.size() && category.size() && selectedId > 0) {
+        predicates.push_back({ { "category", category }, { "id", selectedId } });
+    }
+
+    auto predicateList = jsonToPredicateList(predicates);
+
+    ITrackList* tracks = context.dataProvider->QueryTracksByCategoriesAfter(
+        predicateList.get(), predicates.size(), filter.c_str(),
+        cursor.c_str(), limit, next, sizeof(next));
+
+    nextCursor = tracks ? std::string(next) : "";
+    return tracks;
+}
+
 void WebSocketServer::RespondWithQueryTracksByCategory(connection_hdl connection, json& request) {
-    int limit, offset;
+    int limit = -1, offset = 0;
+    std::string nextCursor;
+    ITrackList* tracks = nullptr;
 
-    ITrackList* tracks = QueryTracksByCategory(request, limit, offset);
+    bool keyset =
+        request.find(message::options) != request.end() &&
+        request[message::options].find(key::cursor) != request[message::options].end();
 
-    if (tracks && this->RespondWithTracks(connection, request, tracks, limit, offset)) {
+    if (keyset) {
+        tracks = this->QueryTracksByCategoryAfter(request, limit, nextCursor);
+    }
+    else {
+        tracks = this->QueryTracksByCategory(request, limit, offset);
+    }
+
+    if (tracks && this->RespondWithTracks(
+        connection, request, tracks, limit, offset, keyset ? &nextCursor : nullptr))
+    {
         return;
     }
 
@@ -1084,6 +1516,7 @@ void WebSocketServer::RespondWithPlaySnapshotTracks(connection_hdl connection, j
         }
 
         context.playback->Play(snapshot, index);
+        snapshot->Release();
 
         if (time > 0.0) {
             context.playback->SetPosition(time);
@@ -1123,6 +1556,19 @@ void WebSocketServer::RespondWithEnvironment(connection_hdl connection, json& re
     this->RespondWithOptions(connection, request, getEnvironment(context));
 }
 
+void WebSocketServer::RespondWithMetrics(connection_hdl connection, json& request) {
+    json metrics = json::object();
+
+    try {
+        metrics = json::parse(context.metrics.Render(context.environment, MetricsFormat::Json));
+    }
+    catch (...) {
+        /* shouldn't happen, but an empty result is better than no response */
+    }
+
+    this->RespondWithOptions(connection, request, metrics);
+}
+
 void WebSocketServer::RespondWithCurrentTime(connection_hdl connection, json& request) {
     auto track = context.playback->GetPlayingTrack();
 
@@ -1435,8 +1881,7 @@ void WebSocketServer::RespondWithSetTransportType(connection_hdl connection, jso
 
 void WebSocketServer::RespondWithSnapshotPlayQueue(connection_hdl connection, json& request) {
     auto deviceId = request[message::device_id];
-    this->snapshots.Remove(deviceId);
-    this->snapshots.Put(deviceId, context.playback->Clone());
+    this->snapshots.Put(deviceId, context.playback);
     this->RespondWithSuccess(connection, request);
 }
 
@@ -1475,6 +1920,48 @@ void WebSocketServer::RespondWithRemoveTracksFromPlaylist(connection_hdl connect
 }
 
 void WebSocketServer::BroadcastPlaybackOverview() {
+    ++context.metrics.wsOverviewEvents;
+
+    /* a flush is already scheduled, and will pick this change up */
+    if (this->playbackOverviewPending.exchange(true)) {
+        return;
+    }
+
+    auto rl = connectionLock.Read();
+
+    if (!this->wss || !this->connections.size()) {
+        this->playbackOverviewPending = false;
+        return;
+    }
+
+    /* the first change after a quiet period goes out right away; anything
+    sooner waits for the rest of the window. */
+    int64_t elapsed = nowMillis() - this->lastPlaybackOverviewMillis;
+
+    if (elapsed >= PLAYBACK_OVERVIEW_WINDOW_MS) {
+        wss->get_io_service().post(
+            std::bind(&WebSocketServer::FlushPlaybackOverview, this));
+    }
+    else {
+        wss->set_timer(
+            (long) (PLAYBACK_OVERVIEW_WINDOW_MS - elapsed),
+            [this](const websocketpp::lib::error_code& ec) {
+                if (!ec) {
+                    this->FlushPlaybackOverview();
+                }
+                else {
+                    this->playbackOverviewPending = false;
+                }
+            });
+    }
+}
+
+void WebSocketServer::FlushPlaybackOverview() {
+    /* cleared before building, so a change that lands while we're reading
+    state schedules another flush instead of being lost */
+    this->playbackOverviewPending = false;
+    this->lastPlaybackOverviewMillis = nowMillis();
+
     {
         auto rl = connectionLock.Read();
         if (!this->connections.size()) {
@@ -1489,9 +1976,13 @@ void WebSocketServer::BroadcastPlaybackOverview() {
     overview broadcast, so we always remember the last one, and won't
     re-broadcast if status hasn't changed */
     std::string newPlaybackOverview = options.dump();
-    if (newPlaybackOverview != lastPlaybackOverview) {
-        this->Broadcast(broadcast::playback_overview_changed, options);
+    if (newPlaybackOverview != this->lastPlaybackOverview) {
         this->lastPlaybackOverview = newPlaybackOverview;
+        this->Broadcast(broadcast::playback_overview_changed, options);
+        ++context.metrics.wsOverviewBroadcasts;
+    }
+    else {
+        ++context.metrics.wsOverviewSuppressed;
     }
 }
 
@@ -1503,11 +1994,160 @@ void WebSocketServer::BroadcastPlayQueueChanged() {
         }
     }
 
-    json options;
-    this->Broadcast(broadcast::play_queue_changed, options);
+    uint64_t revision = 0;
+    uint64_t fromRevision = this->lastPlayQueueRevision;
+    json edits = json::array(), compactEdits = json::array();
+
+    json options, compactOptions;
+
+    /* track metadata in the edits is encoded per connection, so build both
+    forms from a single read of the journal */
+    if (this->ReadPlayQueueEdits(
+        fromRevision, MAX_BROADCAST_PLAY_QUEUE_EDITS,
+        revision, &edits, &compactEdits))
+    {
+        options[key::edits] = edits;
+        compactOptions[key::edits] = compactEdits;
+    }
+
+    /* edits apply on top of `from_revision`. a client whose last known
+    revision doesn't match missed a broadcast (or connected in between),
+    and should re-query the whole play queue. */
+    options[key::from_revision] = fromRevision;
+    compactOptions[key::from_revision] = fromRevision;
+    options[key::revision] = revision;
+    compactOptions[key::revision] = revision;
+    this->lastPlayQueueRevision = revision;
+
+    this->Broadcast(broadcast::play_queue_changed, options, compactOptions);
+}
+
+bool WebSocketServer::ReadPlayQueueEdits(
+    uint64_t sinceRevision, size_t max, uint64_t& revision, json* edits, json* compactEdits)
+{
+    /* GetQueueEdits() reads the journal under the playback service's own
+    lock, so we don't need (or want) an editor here. the queue may change
+    between the two calls; that's fine, we just report the revision of the
+    last edit we actually copied, and the next broadcast picks up the rest. */
+    int count = context.playback->GetQueueEdits(sinceRevision, nullptr, 0);
+
+    if (count < 0 || (size_t) count > max) {
+        revision = context.playback->GetQueueRevision();
+        return false;
+    }
+
+    std::vector<TrackListEdit> journal(count);
+    int available = context.playback->GetQueueEdits(sinceRevision, journal.data(), journal.size());
+
+    if (available < 0) {
+        revision = context.playback->GetQueueRevision();
+        return false;
+    }
+
+    journal.resize(std::min((size_t) available, journal.size()));
+    revision = journal.size() ? journal.back().revision : sinceRevision;
+
+    /* include metadata for new tracks, so clients don't need to go back to
+    the server to render them. loaded with a single query, without holding
+    any playback locks. */
+    std::vector<int64_t> addedIds;
+    for (auto& edit : journal) {
+        if (edit.type == TrackListEditType::Insert || edit.type == TrackListEditType::Add) {
+            addedIds.push_back(edit.id);
+        }
+    }
+
+    std::map<int64_t, json> metadata, compactMetadata;
+
+    if (addedIds.size()) {
+        ITrackList* tracks = context.dataProvider->QueryTracksByIds(
+            addedIds.data(), addedIds.size());
+
+        if (tracks) {
+            for (size_t i = 0; i < tracks->Count(); i++) {
+                ITrack* track = tracks->GetTrack(i);
+                if (edits) {
+                    metadata[track->GetId()] = this->ReadTrackMetadata(track, Encoding::Json);
+                }
+                if (compactEdits) {
+                    compactMetadata[track->GetId()] = this->ReadTrackMetadata(track, Encoding::MessagePack);
+                }
+                track->Release();
+            }
+            tracks->Release();
+        }
+    }
+
+    for (auto& edit : journal) {
+        json entry = {
+            { key::revision, edit.revision },
+            { key::type, TRACK_LIST_EDIT_TYPE_TO_STRING.left.find(edit.type)->second }
+        };
+
+        switch (edit.type) {
+            case TrackListEditType::Insert:
+            case TrackListEditType::Add: {
+                entry[key::index] = edit.to;
+                entry[key::id] = edit.id;
+                break;
+            }
+
+            case TrackListEditType::Delete:
+                entry[key::index] = edit.to;
+                break;
+
+            case TrackListEditType::Swap:
+            case TrackListEditType::Move:
+                entry[key::from] = edit.from;
+                entry[key::to] = edit.to;
+                break;
+        }
+
+        if (edits) {
+            auto it = metadata.find(edit.id);
+            if (it != metadata.end() && entry.find(key::id) != entry.end()) {
+                entry[key::track] = it->second;
+            }
+            edits->push_back(entry);
+            entry.erase(key::track);
+        }
+
+        if (compactEdits) {
+            auto it = compactMetadata.find(edit.id);
+            if (it != compactMetadata.end() && entry.find(key::id) != entry.end()) {
+                entry[key::track] = it->second;
+            }
+            compactEdits->push_back(entry);
+        }
+    }
+
+    return true;
 }
 
-json WebSocketServer::WebSocketServer::ReadTrackMetadata(ITrack* track) {
+json WebSocketServer::ReadTrackMetadata(ITrack* track, Encoding encoding) {
+    if (encoding == Encoding::Json) {
+        return this->ReadTrackMetadata(track);
+    }
+
+    /* compact form: a positional array, ordered by TRACK_FIELDS */
+    return json::array({
+        track->GetId(),
+        GetMetadataString(track, key::external_id),
+        GetMetadataString(track, key::title),
+        track->GetInt32(key::track_num.c_str(), 0),
+        GetMetadataString(track, key::album),
+        track->GetInt64(key::album_id.c_str()),
+        GetMetadataString(track, key::album_artist),
+        track->GetInt64(key::album_artist_id.c_str()),
+        GetMetadataString(track, key::artist),
+        track->GetInt64(key::visual_artist_id.c_str()),
+        GetMetadataString(track, key::genre),
+        track->GetInt64(key::visual_genre_id.c_str()),
+        track->GetInt64(key::thumbnail_id.c_str())
+    });
+}
+
+json WebSocketServer::ReadTrackMetadata(ITrack* track) {
     return {
         { key::id, track->GetId() },
         { key::external_id, GetMetadataString(track, key::external_id) },
@@ -1545,22 +2185,50 @@ void WebSocketServer::BuildPlaybackOverview(json& options) {
 
 void WebSocketServer::OnOpen(connection_hdl connection) {
     auto wl = connectionLock.Write();
-    connections[connection] = false;
+    connections[connection] = ConnectionState();
+    context.metrics.wsConnections = (int64_t) connections.size();
 }
 
 void WebSocketServer::OnClose(connection_hdl connection) {
     auto wl = connectionLock.Write();
+
+    auto it = connections.find(connection);
+    if (it != connections.end()) {
+        for (auto& stream : it->second.streams) {
+            stream.second->canceled = true;
+        }
+        context.metrics.wsActiveStreams -= (int64_t) it->second.streams.size();
+    }
+
     connections.erase(connection);
+    context.metrics.wsConnections = (int64_t) connections.size();
 }
 
 void WebSocketServer::OnMessage(server* s, connection_hdl hdl, message_ptr msg) {
     auto rl = connectionLock.Read();
 
     try {
-        json data = json::parse(msg->get_payload());
+        json data;
+
+        if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+            const std::string& payload = msg->get_payload();
+            data = ExpandMessage(json::from_msgpack(
+                std::vector<uint8_t>(payload.begin(), payload.end())));
+        }
+        else {
+            data = json::parse(msg->get_payload());
+        }
+
         std::string type = data[message::type];
         if (type == type::request) {
+            auto start = std::chrono::steady_clock::now();
+
             this->HandleRequest(hdl, data);
+
+            ++context.metrics.wsRequests;
+            context.metrics.wsRequestMicroseconds +=
+                (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
         }
     }
     catch (std::exception& e) {
@@ -43,6 +43,7 @@
 #include <websocketpp/server.hpp>
 #include <websocketpp/server.hpp>
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 
@@ -107,11 +108,56 @@ class WebSocketServer {
         using server = websocketpp::server<asio_with_deflate>;
         using connection_hdl = websocketpp::connection_hdl;
         using message_ptr = server::message_ptr;
-        using ConnectionList = std::map<connection_hdl, bool, std::owner_less<connection_hdl>>;
         using json = nlohmann::json;
         using ITrackList = musik::core::sdk::ITrackList;
         using ITrack = musik::core::sdk::ITrack;
 
+        /* wire encoding, negotiated per-connection during authentication */
+        enum class Encoding: int {
+            Json,
+            MessagePack
+        };
+
+        /* a query_tracks* request whose results are being sent in chunks.
+        each chunk is its own handler on the server's io_service, so other
+        requests are serviced in between, and a cancel takes effect at the
+        next chunk boundary. */
+        struct TrackStream {
+            TrackStream(
+                connection_hdl connection,
+                const std::string& name,
+                const std::string& id,
+                ITrackList* tracks)
+            : connection(connection), name(name), id(id), tracks(tracks) {
+            }
+
+            ~TrackStream() {
+                this->tracks->Release();
+            }
+
+            connection_hdl connection;
+            std::string name, id;
+            ITrackList* tracks;
+            size_t position { 0 };
+            size_t chunkSize { 0 };
+            bool idsOnly { false };
+            bool canceled { false };
+            int limit { -1 };
+            int offset { 0 };
+            bool keyset { false };
+            std::string nextCursor;
+        };
+
+        using TrackStreamPtr = std::shared_ptr<TrackStream>;
+
+        struct ConnectionState {
+            bool authenticated { false };
+            Encoding encoding { Encoding::Json };
+            std::map<std::string, TrackStreamPtr> streams;
+        };
+
+        using ConnectionList = std::map<connection_hdl, ConnectionState, std::owner_less<connection_hdl>>;
+
         /* vars */
         Context& context;
         ConnectionList connections;
@@ -125,12 +171,20 @@ class WebSocketServer {
 
         /* gross extra state */
         std::string lastPlaybackOverview;
+        std::atomic<uint64_t> lastPlayQueueRevision;
+
+        /* playback overview broadcasts are coalesced: at most one is pending
+        at a time, and they go out at most once per window */
+        std::atomic<bool> playbackOverviewPending;
+        std::atomic<int64_t> lastPlaybackOverviewMillis;
 
         void ThreadProc();
         void HandleAuthentication(connection_hdl connection, json& request);
         void HandleRequest(connection_hdl connection, json& request);
 
+        void Send(connection_hdl connection, const json& message);
         void Broadcast(const std::string& name, json& options);
+        void Broadcast(const std::string& name, json& options, json& compactOptions);
         void RespondWithOptions(connection_hdl connection, json& request, json& options);
         void RespondWithOptions(connection_hdl connection, json& request, json&& options = json({}));
         void RespondWithInvalidRequest(connection_hdl connection, const std::string& name, const std::string& id);
@@ -140,7 +194,7 @@ class WebSocketServer {
 
         void RespondWithSetVolume(connection_hdl connection, json& request);
         void RespondWithPlaybackOverview(connection_hdl connection, json& reuest);
-        bool RespondWithTracks(connection_hdl connection, json& request, ITrackList* tracks, int limit, int offset);
+        bool RespondWithTracks(connection_hdl connection, json& request, ITrackList* tracks, int limit, int offset, const std::string* nextCursor = nullptr);
         void RespondWithQueryTracks(connection_hdl connection, json& request);
         void RespondWithQueryTracksByExternalIds(connection_hdl connection, json& request);
         void RespondWithPlayQueueTracks(connection_hdl connection, json& request);
@@ -153,6 +207,7 @@ class WebSocketServer {
         void RespondWithPlaySnapshotTracks(connection_hdl connection, json& request);
         void RespondWithPlayTracksByCategory(connection_hdl connection, json& request);
         void RespondWithEnvironment(connection_hdl connection, json& request);
+        void RespondWithMetrics(connection_hdl connection, json& request);
         void RespondWithCurrentTime(connection_hdl connection, json& request);
         void RespondWithSavePlaylist(connection_hdl connection, json& request);
         void RespondWithRenamePlaylist(connection_hdl connection, json& request);
@@ -168,14 +223,27 @@ class WebSocketServer {
         void RespondWithSetTransportType(connection_hdl connection, json& request);
         void RespondWithSnapshotPlayQueue(connection_hdl connection, json& request);
         void RespondWithInvalidatePlayQueueSnapshot(connection_hdl connection, json& request);
+        void RespondWithPlayQueueEdits(connection_hdl connection, json& request);
+        void RespondWithCancelQuery(connection_hdl connection, json& request);
+
+        void StreamTracks(connection_hdl connection, json& request, ITrackList* tracks, int limit, int offset, const std::string* nextCursor);
+        void ScheduleTrackStream(TrackStreamPtr stream, long delayMs = 0);
+        void SendNextTrackChunk(TrackStreamPtr stream);
+        void EndTrackStream(TrackStreamPtr stream);
 
         void BroadcastPlaybackOverview();
+        void FlushPlaybackOverview();
         void BroadcastPlayQueueChanged();
 
         void GetLimitAndOffset(json& options, int& limit, int& offset);
         ITrackList* QueryTracksByCategory(json& request, int& limit, int& offset);
         ITrackList* QueryTracks(json& request, int& limit, int& offset);
+        ITrackList* QueryTracksAfter(json& request, int& limit, std::string& nextCursor);
+        ITrackList* QueryTracksByCategoryAfter(json& request, int& limit, std::string& nextCursor);
         json ReadTrackMetadata(ITrack* track);
+        bool ReadPlayQueueEdits(uint64_t sinceRevision, size_t max, uint64_t& revision, json* edits, json* compactEdits);
+        json ReadTrackMetadata(ITrack* track, Encoding encoding);
+        Encoding GetEncoding(connection_hdl connection);
         void BuildPlaybackOverview(json& options);
 
         void OnOpen(connection_hdl connection);
@@ -196,6 +196,10 @@ extern "C" DLL_EXPORT void SetPreferences(musik::core::sdk::IPreferences* prefs)
         prefs->GetInt(prefs::transcoder_cache_count.c_str(), defaults::transcoder_cache_count);
         prefs->GetBool(prefs::transcoder_synchronous.c_str(), defaults::transcoder_synchronous);
         prefs->GetBool(prefs::transcoder_synchronous_fallback.c_str(), defaults::transcoder_synchronous_fallback);
+        prefs->GetInt(prefs::http_server_thread_pool_size.c_str(), defaults::http_server_thread_pool_size);
+        prefs->GetInt(prefs::http_server_connection_limit.c_str(), defaults::http_server_connection_limit);
+        prefs->GetInt(prefs::http_server_per_ip_connection_limit.c_str(), defaults::http_server_per_ip_connection_limit);
+        prefs->GetInt(prefs::http_server_connection_timeout.c_str(), defaults::http_server_connection_timeout);
         prefs->Save();
     }
 
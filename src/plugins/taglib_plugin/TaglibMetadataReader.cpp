@@ -170,12 +170,36 @@ bool TaglibMetadataReader::Read(const char* uri, ITagStore *track) {
 
     bool success = false;
 
+    /* open and parse the file exactly once; FileRef picks the concrete
+    TagLib::File type based on the extension, and everything below (format
+    specific frames, generic fields, audio properties, artwork) is read
+    from that same instance. */
+
+    TagLib::ID3v2::FrameFactory::instance()->setDefaultTextEncoding(TagLib::String::UTF8);
+
+#ifdef WIN32
+    TagLib::FileRef file(utf8to16(uri).c_str());
+#else
+    TagLib::FileRef file(uri);
+#endif
+
+    /* FileRef::isNull() is also true for files that TagLib considers
+    invalid (e.g. mp3s with a damaged audio stream), but their ID3v2 tag
+    may still be perfectly readable, so only bail if nothing was opened. */
+    TagLib::File* taglibFile = file.file();
+    if (!taglibFile) {
+        return false;
+    }
+
     if (extension.size()) {
         boost::algorithm::to_lower(extension);
 
         if (extension == "mp3") {
             try {
-                success = this->ReadID3V2(uri, track);
+                auto mpegFile = dynamic_cast<TagLib::MPEG::File*>(taglibFile);
+                if (mpegFile) {
+                    success = this->ReadID3V2(mpegFile, track);
+                }
             }
             catch (...) {
                 std::cerr << "id3v2 tag read for " << uri << "failed!";
@@ -183,23 +207,19 @@ bool TaglibMetadataReader::Read(const char* uri, ITagStore *track) {
         }
     }
 
-    try {
-        success |= this->ReadGeneric(uri, track);
-    }
-    catch (...) {
-        std::cerr << "generic tag read for " << uri << "failed!";
+    if (taglibFile->isValid()) {
+        try {
+            success |= this->ReadGeneric(uri, file, track);
+        }
+        catch (...) {
+            std::cerr << "generic tag read for " << uri << "failed!";
+        }
     }
 
     return success;
 }
 
-bool TaglibMetadataReader::ReadGeneric(const char* uri, ITagStore *target) {
-#ifdef WIN32
-    TagLib::FileRef file(utf8to16(uri).c_str());
-#else
-    TagLib::FileRef file(uri);
-#endif
-
+bool TaglibMetadataReader::ReadGeneric(const char* uri, TagLib::FileRef& file, ITagStore *target) {
     if (!file.isNull()) {
         TagLib::Tag *tag = file.tag();
 
@@ -243,10 +263,18 @@ bool TaglibMetadataReader::ReadGeneric(const char* uri, ITagStore *target) {
                 /* flac files may have more than one type of tag embedded. see if there's
                 see if there's a xiph comment burried deep. */
                 auto flacFile = dynamic_cast<TagLib::FLAC::File*>(file.file());
-                if (flacFile && flacFile->hasXiphComment()) {
-                    this->ReadFromMap(flacFile->xiphComment()->fieldListMap(), target);
-                    this->ExtractReplayGain(flacFile->xiphComment()->fieldListMap(), target);
-                    handled = true;
+                if (flacFile) {
+                    if (flacFile->hasXiphComment()) {
+                        this->ReadFromMap(flacFile->xiphComment()->fieldListMap(), target);
+                        this->ExtractReplayGain(flacFile->xiphComment()->fieldListMap(), target);
+                        handled = true;
+                    }
+
+                    /* embedded artwork; like id3v2, just use the first one */
+                    auto pictures = flacFile->pictureList();
+                    if (!pictures.isEmpty()) {
+                        this->SetThumbnail(pictures.front()->data(), target);
+                    }
                 }
 
                 /* similarly, mp4 buries disc number and album artist. however, taglib does
@@ -259,6 +287,13 @@ bool TaglibMetadataReader::ReadGeneric(const char* uri, ITagStore *target) {
                         this->ExtractValueForKey(mp4TagMap, "aART", "album_artist", target);
                         this->ExtractValueForKey(mp4TagMap, "disk", "disc", target);
                         this->ExtractReplayGain(mp4TagMap, target);
+
+                        if (mp4TagMap.contains("covr")) {
+                            auto covers = mp4TagMap["covr"].toCoverArtList();
+                            if (!covers.isEmpty()) {
+                                this->SetThumbnail(covers.front().data(), target);
+                            }
+                        }
                     }
                 }
             }
@@ -358,19 +393,11 @@ void TaglibMetadataReader::ExtractReplayGain(const T& map, ITagStore *target)
     }
 }
 
-bool TaglibMetadataReader::ReadID3V2(const char* uri, ITagStore *track) {
-    TagLib::ID3v2::FrameFactory::instance()->setDefaultTextEncoding(TagLib::String::UTF8);
-
-#ifdef WIN32
-    TagLib::MPEG::File file(utf8to16(uri).c_str());
-#else
-    TagLib::MPEG::File file(uri);
-#endif
-
-    TagLib::ID3v2::Tag *id3v2 = file.ID3v2Tag();
+bool TaglibMetadataReader::ReadID3V2(TagLib::MPEG::File* file, ITagStore *track) {
+    TagLib::ID3v2::Tag *id3v2 = file->ID3v2Tag();
 
     if (id3v2) {
-        TagLib::AudioProperties *audio = file.audioProperties();
+        TagLib::AudioProperties *audio = file->audioProperties();
         TagLib::ID3v2::FrameListMap allTags = id3v2->frameListMap();
 
         if (!id3v2->title().isEmpty()) {
@@ -559,12 +586,7 @@ bool TaglibMetadataReader::ReadID3V2(const char* uri, ITagStore *track) {
             TagLib::ID3v2::AttachedPictureFrame *picture =
                 static_cast<TagLib::ID3v2::AttachedPictureFrame*>(pictures.front());
 
-            TagLib::ByteVector pictureData = picture->picture();
-            long long size = pictureData.size();
-
-            if(size > 32) {    /* noticed that some id3tags have like a 4-8 byte size with no thumbnail */
-                track->SetThumbnail(pictureData.data(), size);
-            }
+            this->SetThumbnail(picture->picture(), track);
         }
 
         return true;
@@ -646,6 +668,16 @@ void TaglibMetadataReader::SetSlashSeparatedValues(
     }
 }
 
+void TaglibMetadataReader::SetThumbnail(
+    const TagLib::ByteVector& pictureData, ITagStore *track)
+{
+    long long size = pictureData.size();
+
+    if (size > 32) { /* noticed that some id3tags have like a 4-8 byte size with no thumbnail */
+        track->SetThumbnail(pictureData.data(), (long) size);
+    }
+}
+
 void TaglibMetadataReader::SetAudioProperties(
     TagLib::AudioProperties *audioProperties, ITagStore *track)
 {
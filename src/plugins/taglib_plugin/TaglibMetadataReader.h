@@ -42,6 +42,7 @@
     #include <taglib/tag.h>
     #include <taglib/fileref.h>
     #include <taglib/audioproperties.h>
+    #include <taglib/mpeg/mpegfile.h>
     #include <taglib/mpeg/id3v2/id3v2tag.h>
     #include <taglib/mp4/mp4file.h>
 #else
@@ -50,6 +51,7 @@
     #include <taglib/tag.h>
     #include <taglib/fileref.h>
     #include <taglib/audioproperties.h>
+    #include <taglib/mpegfile.h>
     #include <taglib/id3v2tag.h>
     #include <taglib/mp4file.h>
 #endif
@@ -113,6 +115,10 @@ class TaglibMetadataReader : public musik::core::sdk::ITagReader {
             const TagLib::ID3v2::FrameList &frame,
             musik::core::sdk::ITagStore *target);
 
+        void SetThumbnail(
+            const TagLib::ByteVector& pictureData,
+            musik::core::sdk::ITagStore *target);
+
         void SetAudioProperties(
             TagLib::AudioProperties *audioProperties,
             musik::core::sdk::ITagStore *target);
@@ -128,10 +134,11 @@ class TaglibMetadataReader : public musik::core::sdk::ITagReader {
             musik::core::sdk::ITagStore *target);
 
         bool ReadID3V2(
-            const char* uri,
+            TagLib::MPEG::File* file,
             musik::core::sdk::ITagStore *target);
 
         bool ReadGeneric(
             const char* uri,
+            TagLib::FileRef& file,
             musik::core::sdk::ITagStore *target);
 };